@@ -0,0 +1,160 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "async_log_sink.h"
+
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+// target sink: keeps every record it gets from the flusher thread
+struct capture_sink_t : log_sink_t {
+  std::mutex                mutex;
+  std::vector<log_record_t> records;
+  int                       flushes = 0;
+
+  void write (const log_record_t& record) override {
+    std::lock_guard<std::mutex> lock (mutex);
+    records.push_back (record);
+  }
+  void flush () override {
+    std::lock_guard<std::mutex> lock (mutex);
+    flushes++;
+  }
+  size_t size () {
+    std::lock_guard<std::mutex> lock (mutex);
+    return records.size ();
+  }
+};
+
+// record number 'sequence' of producer 'producer'
+static log_record_t make_record (int producer, int sequence) {
+  log_record_t record;
+  snprintf (record.tname, sizeof (record.tname), "producer<%d>", producer);
+  record.fd    = producer;
+  record.func  = "write";
+  record.bytes = sequence;
+  record.mes   = "test";
+  record.text  = "record " + std::to_string (sequence) + " of producer " + std::to_string (producer);
+  return record;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  Async Log Sink Tests\n";
+  std::cout << "========================================\n\n";
+
+  // --- Several producers ---
+
+  std::cout << "--- Several producers ---\n";
+
+  {
+    const int        producers = 4;
+    const int        per_thread = 3000;
+    capture_sink_t   capture;
+    async_log_sink_t sink (&capture, 4096, 1);
+
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++)
+      threads.emplace_back ([&sink, p] () {
+        for (int i = 0; i < per_thread; i++)
+          sink.write (make_record (p, i));
+      });
+    for (std::thread& thread : threads)
+      thread.join ();
+    sink.flush ();
+
+    // per producer: records complete and in the order they were written
+    std::map<int64_t, int> next;
+    bool                   complete = true, ordered = true;
+    for (const log_record_t& record : capture.records) {
+      log_record_t expected = make_record ((int)record.fd, record.bytes);
+      complete = complete && std::strcmp (record.tname, expected.tname) == 0 && std::strcmp (record.func, "write") == 0 &&
+                 std::strcmp (record.mes, "test") == 0 && record.text == expected.text;
+      ordered  = ordered && record.bytes == next[record.fd]++;
+    }
+    CHECK (sink.dropped () == 0,                                       "nothing dropped with rings large enough");
+    CHECK (capture.records.size () == (size_t)(producers * per_thread), "every record arrives after flush()");
+    CHECK (complete,                                                   "records arrive complete (names, message, text)");
+    CHECK (ordered && next.size () == (size_t)producers,               "records of each thread keep their order");
+    CHECK (capture.flushes > 0,                                        "target flush() is called after a pass");
+  }
+
+  // --- Overflow ---
+
+  std::cout << "\n--- Overflow ---\n";
+
+  {
+    // the flusher sleeps for a minute between passes, so the 8-record ring overflows at once
+    const int        count = 100000;
+    capture_sink_t   capture;
+    async_log_sink_t sink (&capture, 5, 60000);
+    for (int i = 0; i < count; i++)
+      sink.write (make_record (0, i));
+    sink.flush ();
+
+    bool ordered = true;
+    for (size_t i = 1; i < capture.records.size (); i++)
+      ordered = ordered && capture.records[i - 1].bytes < capture.records[i].bytes;
+    CHECK (sink.dropped () > 0,                                        "a full ring drops records");
+    CHECK (capture.records.size () + sink.dropped () == (size_t)count, "delivered + dropped() == written");
+    CHECK (ordered,                                                    "the records that made it keep their order");
+  }
+
+  // --- Stop ---
+
+  std::cout << "\n--- Stop ---\n";
+
+  {
+    capture_sink_t   capture;
+    async_log_sink_t sink (&capture, 1024, 60000);
+    for (int i = 0; i < 500; i++)
+      sink.write (make_record (0, i));
+    sink.stop ();
+    CHECK (capture.size () == 500,                                     "stop() writes out everything queued");
+    sink.write (make_record (0, 500));
+    sink.flush ();
+    CHECK (capture.size () == 501,                                     "flush() after stop() drains on the calling thread");
+  }
+
+  // --- Socket messages ---
+
+  std::cout << "\n--- Socket messages ---\n";
+
+  {
+    capture_sink_t   capture;
+    async_log_sink_t sink (&capture);
+    set_log_sink (&sink);
+    udp_socket_t<v4, socket_type_e::client> closed (log_e::error);
+    char buf[4] = {};
+    closed.send (buf, sizeof (buf));
+    sink.flush ();
+    set_log_sink (nullptr);
+    CHECK (capture.size () == 1 && std::strcmp (capture.records[0].func, "send") == 0 &&
+           capture.records[0].cerr == error_closed_or_not_open,       "a socket error goes through the installed sink");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
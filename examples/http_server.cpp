@@ -176,12 +176,10 @@ struct mini_http_server_t {
     // Empty line to separate headers from body
     headers << "\r\n";
 
-    // Send headers
+    // Send headers and body with one call, they leave in the same TCP segment
     std::string h = headers.str();
-    client.send (h.data(), (int)h.size());
-    // Send body (if it not empty)
-    if (!body.empty())
-      client.send (body.data(), (int)body.size());
+    io_vec_t parts[2] = { io_vec_t (h.data(), (int)h.size()), io_vec_t (body.data(), (int)body.size()) };
+    client.sendv (parts, body.empty() ? 1 : 2);
     std::cout << "Response: " << status << " " << status_text << " (" << body.size() << " bytes)" << std::endl;
   }
 
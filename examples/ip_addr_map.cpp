@@ -0,0 +1,216 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "ip_addr_map.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using clock_type = std::chrono::steady_clock;
+
+// key number i: 10.x.x.x:port
+static addr4_t make_addr (uint32_t i) {
+  addr4_t addr;
+  addr.ip   = ip4_t ((uint32_t)(0x0a000000 | (i >> 4)));
+  addr.port = (uint16_t)(5000 + (i & 0xf));
+  return addr;
+}
+
+// a poor hash: 8 distinct values with the same 7-bit tag, so keys share long probe chains through full groups
+struct crowded_hash_t {
+  size_t operator() (const addr4_t& addr) const {
+    return (size_t)(hashing::mix (addr.port % 8) & ~(uint64_t)0x7f);
+  }
+};
+
+template <class Hash>
+static bool same_content (const addr_map_t<addr4_t, std::string, Hash>& map, const std::unordered_map<uint32_t, std::string>& model) {
+  if (map.size () != model.size ())
+    return false;
+  for (const auto& entry : model) {
+    const std::string* value = map.find (make_addr (entry.first));
+    if (value == nullptr || *value != entry.second)
+      return false;
+  }
+  size_t visited = 0, known = 0;
+  map.for_each ([&] (const addr4_t& key, const std::string& value) {
+    auto found = model.find ((((uint32_t)key.ip & 0xffffff) << 4) | (uint32_t)(key.port - 5000));
+    known += found != model.end () && found->second == value;
+    visited++;
+  });
+  return known == visited && visited == model.size ();
+}
+
+// random insert/overwrite/erase/find over 'keys' key numbers, checked against std::unordered_map;
+// erases are frequent, so tombstones pile up and force in-place rehashes as well as growth
+template <class Hash>
+static bool model_run (uint32_t keys, size_t steps, unsigned seed) {
+  addr_map_t<addr4_t, std::string, Hash>      map;
+  std::unordered_map<uint32_t, std::string>  model;
+  std::mt19937                               rng (seed);
+
+  for (size_t step = 0; step < steps; step++) {
+    uint32_t id = rng () % keys;
+    addr4_t  key = make_addr (id);
+    switch (rng () % 5) {
+      case 0: case 1: {
+        std::string value = std::to_string (step);
+        if (map.insert (key, value) != (model.count (id) == 0))
+          return false;
+        model[id] = value;
+        break;
+      }
+      case 2: case 3:
+        if (map.erase (key) != (model.erase (id) != 0))
+          return false;
+        break;
+      default: {
+        const std::string* value = map.find (key);
+        auto               found = model.find (id);
+        if ((value == nullptr) != (found == model.end ()) || (value && *value != found->second))
+          return false;
+      }
+    }
+    if (step % 1000 == 0 && !same_content (map, model))
+      return false;
+  }
+
+  addr_map_t<addr4_t, std::string, Hash> copy  = map;
+  addr_map_t<addr4_t, std::string, Hash> moved = std::move (copy);
+  return same_content (map, model) && same_content (moved, model) && copy.size () == 0;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  Address Hash Map Tests\n";
+  std::cout << "========================================\n\n";
+
+  // --- Basic operations ---
+
+  std::cout << "--- Basic operations ---\n";
+
+  {
+    addr_map_t<addr4_t, int> map;
+    CHECK (map.find ("10.0.0.1:53") == nullptr && map.capacity () == 0,   "empty map allocates nothing");
+    CHECK (map.insert ("10.0.0.1:53", 1) && !map.insert ("10.0.0.1:53", 2), "insert adds once, then overwrites");
+    CHECK (*map.find ("10.0.0.1:53") == 2,                                  "overwritten value");
+    map["10.0.0.2:53"] += 5;
+    CHECK (map.size () == 2 && *map.find ("10.0.0.2:53") == 5,              "operator[] adds a value-initialized value");
+    CHECK (!map.emplace ("10.0.0.2:53", 9).second && *map.find ("10.0.0.2:53") == 5, "emplace keeps the existing value");
+    CHECK (map.erase ("10.0.0.1:53") && !map.erase ("10.0.0.1:53") && !map.contains ("10.0.0.1:53"), "erase removes the key once");
+    map.clear ();
+    CHECK (map.empty () && map.capacity () > 0 && !map.contains ("10.0.0.2:53"), "clear() keeps the slots");
+
+    addr_map_t<ip6_t, int> map6;
+    map6.insert ("2001:db8::1", 1);
+    map6.insert ("2001:db8::2", 2);
+    CHECK (*map6.find ("2001:db8::2") == 2 && map6.find ("2001:db8::3") == nullptr, "ip6_t keys");
+  }
+
+  // --- Tombstones and rehash ---
+
+  std::cout << "\n--- Tombstones and rehash ---\n";
+
+  {
+    // constant size with endless churn: tombstones must be cleaned up in place instead of growing the table
+    addr_map_t<addr4_t, std::string, crowded_hash_t> map;
+    for (uint32_t i = 0; i < 100; i++)
+      map.insert (make_addr (i), "x");
+    size_t capacity = map.capacity ();
+    bool   same     = true;
+    for (uint32_t i = 100; i < 100000; i++) {
+      map.erase (make_addr (i - 100));
+      map.insert (make_addr (i), "x");
+      same = same && map.contains (make_addr (i - 99)) && !map.contains (make_addr (i - 100));
+    }
+    CHECK (same && map.size () == 100,                   "erase + insert churn with a crowded hash");
+    CHECK (map.capacity () <= capacity * 2,              "churn does not grow the table");
+
+    addr_map_t<addr4_t, int> reserved;
+    reserved.reserve (1000);
+    capacity = reserved.capacity ();
+    for (uint32_t i = 0; i < 1000; i++)
+      reserved.insert (make_addr (i), (int)i);
+    CHECK (reserved.capacity () == capacity,             "reserve() avoids growth");
+  }
+
+  // --- Random operations vs std::unordered_map ---
+
+  std::cout << "\n--- Random operations vs std::unordered_map ---\n";
+
+  CHECK (model_run<std::hash<addr4_t>> (2000,   200000, 1), "2000 keys, good hash");
+  CHECK (model_run<std::hash<addr4_t>> (100000, 300000, 2), "100000 keys, growth while erasing");
+  CHECK (model_run<crowded_hash_t>     (300,    100000, 3), "300 keys, crowded hash (long probes through tombstones)");
+
+  // --- Benchmark ---
+
+  const uint32_t count = 1000000;
+
+  std::cout << "\n--- Benchmark: " << count << " addr4_t keys, addr_map_t vs std::unordered_map ---\n";
+
+  {
+    std::vector<addr4_t> keys (count), misses (count);
+    std::mt19937         rng (4);
+    for (uint32_t i = 0; i < count; i++) {
+      keys[i]   = addr4_t (ip4_t ((uint32_t)rng () | 0x80000000u), (uint16_t)rng ());
+      misses[i] = addr4_t (ip4_t ((uint32_t)rng () & 0x7fffffffu), (uint16_t)rng ());
+    }
+
+    addr_map_t<addr4_t, uint32_t>         map;
+    std::unordered_map<addr4_t, uint32_t> std_map;
+    double ns[2][4];
+    size_t found[2] = { 0, 0 };
+
+    for (int which = 0; which < 2; which++) {
+      clock_type::time_point start = clock_type::now ();
+      for (uint32_t i = 0; i < count; i++)
+        which ? (void)std_map.emplace (keys[i], i) : (void)map.insert (keys[i], i);
+      ns[which][0] = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / count;
+
+      start = clock_type::now ();
+      for (uint32_t i = 0; i < count; i++)
+        found[which] += which ? std_map.count (keys[i]) : (map.find (keys[i]) != nullptr);
+      ns[which][1] = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / count;
+
+      start = clock_type::now ();
+      for (uint32_t i = 0; i < count; i++)
+        found[which] += which ? std_map.count (misses[i]) : (map.find (misses[i]) != nullptr);
+      ns[which][2] = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / count;
+
+      start = clock_type::now ();
+      for (uint32_t i = 0; i < count; i++)
+        which ? (void)std_map.erase (keys[i]) : (void)map.erase (keys[i]);
+      ns[which][3] = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / count;
+    }
+
+    printf ("  %-20s %8s %8s %8s %8s (ns/op)\n", "", "insert", "hit", "miss", "erase");
+    printf ("  %-20s %8.1f %8.1f %8.1f %8.1f\n", "addr_map_t",         ns[0][0], ns[0][1], ns[0][2], ns[0][3]);
+    printf ("  %-20s %8.1f %8.1f %8.1f %8.1f\n", "std::unordered_map", ns[1][0], ns[1][1], ns[1][2], ns[1][3]);
+    CHECK (found[0] == found[1] && map.empty () && std_map.empty (), "same lookups, both empty after erase");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -1,6 +1,7 @@
 
 #include "ip_address.h"
 
+#include <cstring>
 #include <iostream>
 #include <string>
 #include <unordered_set>
@@ -14,6 +15,18 @@ using namespace ipsockets;
     if (!ok) failures++; \
   } while(0)
 
+// to_chars() into the first 'size' bytes of a marked buffer: the text, or "#null" if it refused and left
+// the buffer untouched ("#written" if it refused but wrote anyway)
+template <class T, class... Args>
+static std::string chars_of (const T& value, size_t size, Args... args) {
+  char buffer[64];
+  std::memset (buffer, '#', sizeof (buffer));
+  char* end = value.to_chars (buffer, buffer + size, args...);
+  if (end == nullptr)
+    return std::string (buffer, sizeof (buffer)) == std::string (sizeof (buffer), '#') ? "#null" : "#written";
+  return std::string (buffer, end);
+}
+
 int main () {
 
   int failures = 0;
@@ -166,6 +179,37 @@ int main () {
   ipv4_rot.rotate ();
   CHECK (ipv4_rot.to_str () == "4.3.2.1", "rotate 1.2.3.4 -> 4.3.2.1");
 
+  // --- to_chars ---
+
+  std::cout << "\n--- to_chars ---\n";
+
+  const char* v4_texts[] = { "0.0.0.0", "1.2.3.4", "10.0.100.9", "192.168.1.2", "255.255.255.255" };
+  for (const char* text : v4_texts) {
+    ip4_t       ip   = text;
+    std::string full = chars_of (ip, ip4_t::max_str_len);
+    size_t      size = full.size ();
+    CHECK (full == text && full == ip.to_str () && chars_of (ip, size) == full && chars_of (ip, size - 1) == "#null",
+           std::string ("to_chars ") + text + " (exact buffer fits, one byte less is refused)");
+  }
+  CHECK (chars_of (ip4_t ("1.2.3.4"), 0) == "#null",                   "to_chars into an empty buffer");
+  CHECK (ip4_t ("1.2.3.4").to_chars (nullptr, nullptr) == nullptr,      "to_chars into nullptr");
+
+  // --- Address arithmetic ---
+
+  std::cout << "\n--- Address arithmetic ---\n";
+
+  CHECK (ip4_t ("255.255.255.255").next ().to_str () == "0.0.0.0",     "next() of 255.255.255.255 wraps to 0.0.0.0");
+  CHECK (ip4_t ("0.0.0.0").prev ().to_str () == "255.255.255.255",     "prev() of 0.0.0.0 wraps to 255.255.255.255");
+  CHECK (ip4_t ("10.0.0.255").next ().to_str () == "10.0.1.0",         "next() carries into the next octet");
+  CHECK ((ip4_t ("10.0.0.1") + (-1)).to_str () == "10.0.0.0",          "+ negative step goes back");
+  CHECK ((ip4_t ("10.0.0.1") - (-1)).to_str () == "10.0.0.2",          "- negative step goes forward");
+  CHECK ((ip4_t ("0.0.0.0") + (-1)).to_str () == "255.255.255.255",    "+ (-1) of 0.0.0.0 wraps");
+  CHECK ((ip4_t ("255.255.255.255") + 2).to_str () == "0.0.0.1",       "+ 2 of 255.255.255.255 wraps");
+  CHECK ((ip4_t ("10.0.0.0") + (int64_t)-256).to_str () == "9.255.255.0", "+ negative int64_t step");
+  CHECK (ip4_t ("10.0.0.0").distance ("10.0.1.0") == 256,                "distance() forward");
+  CHECK (ip4_t ("10.0.1.0").distance ("10.0.0.0") == 0xffffff00u,        "distance() backward wraps");
+  CHECK (ip4_t ("255.255.255.255").distance ("0.0.0.0") == 1,            "distance() across the wrap");
+
   // --- Stream output ---
 
   std::cout << "\n--- Stream output (visual check) ---\n";
@@ -300,6 +344,34 @@ int main () {
   std::cout << "  ipv6_1b reduction=false: " << ipv6_1b.to_str (false) << '\n';
   std::cout << "  ipv6_1b embedded=true:   " << ipv6_1b.to_str (true, true) << '\n';
 
+  // --- to_chars ---
+
+  std::cout << "\n--- to_chars ---\n";
+
+  struct v6_case_t { const char* text; bool reduction; bool embedded_ipv4; const char* expected; };
+  const v6_case_t v6_cases[] = {
+    { "::",                                      true,  false, "::" },
+    { "::",                                      false, false, "0:0:0:0:0:0:0:0" },
+    { "::1",                                     true,  false, "::1" },
+    { "1::",                                     true,  false, "1::" },
+    { "2001:db8::1",                             false, false, "2001:db8:0:0:0:0:0:1" },
+    { "2001:db8:0:0:1:0:0:1",                    true,  false, "2001:db8::1:0:0:1" },
+    { "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff", true,  false, "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff" },
+    { "::ffff:192.168.1.1",                      true,  false, "::ffff:192.168.1.1" },
+    { "::ffff:255.255.255.255",                  true,  true,  "::ffff:255.255.255.255" },
+    { "2001:db8::c000:201",                      true,  true,  "2001:db8::192.0.2.1" },
+    { "1:2:3:4:5:6:7:8",                         true,  true,  "1:2:3:4:5:6:0.7.0.8" },
+  };
+  for (const v6_case_t& test : v6_cases) {
+    ip6_t       ip   = test.text;
+    std::string full = chars_of (ip, ip6_t::max_str_len, test.reduction, test.embedded_ipv4);
+    size_t      size = full.size ();
+    CHECK (full == test.expected && full == ip.to_str (test.reduction, test.embedded_ipv4) &&
+           chars_of (ip, size, test.reduction, test.embedded_ipv4) == full && chars_of (ip, size - 1, test.reduction, test.embedded_ipv4) == "#null",
+           std::string ("to_chars ") + test.expected + " (exact buffer fits, one byte less is refused)");
+  }
+  CHECK (chars_of (ip6_t ("::"), 1) == "#null",                        "to_chars :: into 1 byte");
+
   // --- Bitwise operations ---
 
   std::cout << "\n--- Bitwise operations ---\n";
@@ -315,6 +387,43 @@ int main () {
   CHECK (mask6_64[7]  == 0xff, "mask /64 byte[7] = 0xff");
   CHECK (mask6_64[8]  == 0x00, "mask /64 byte[8] = 0x00");
 
+  // --- u128_t ---
+
+  std::cout << "\n--- u128_t ---\n";
+
+  const u128_t all_ones = ~u128_t (0);
+  const u128_t pattern (0x0123456789abcdefull, 0xfedcba9876543210ull);
+  CHECK ((pattern << 0) == pattern && (pattern >> 0) == pattern,                       "shift by 0 keeps the value");
+  CHECK ((pattern << 64) == u128_t (pattern.low (), 0),                                "<< 64 moves the low word up");
+  CHECK ((pattern >> 64) == u128_t (0, pattern.high ()),                               ">> 64 moves the high word down");
+  CHECK ((u128_t (1) << 127) == u128_t (0x8000000000000000ull, 0),                     "1 << 127 is the top bit");
+  CHECK ((all_ones >> 127) == u128_t (1) && (all_ones << 127) == (u128_t (1) << 127), "all ones shifted by 127");
+  CHECK ((pattern << 128) == u128_t (0) && (pattern >> 128) == u128_t (0),            "shift by 128 gives 0");
+  CHECK (u128_t (0, ~0ull) + u128_t (1) == u128_t (1, 0),                              "+ carries into the high word");
+  CHECK (u128_t (1, 0) - u128_t (1) == u128_t (0, ~0ull),                              "- borrows from the high word");
+  CHECK (u128_t (0) - u128_t (1) == all_ones && all_ones + u128_t (1) == u128_t (0),  "wrap-around at 0 and all ones");
+  CHECK (u128_t (1, 0) > u128_t (0, ~0ull) && u128_t (0, 5) < u128_t (1, 0),          "compare by the high word first");
+  CHECK (u128_t (1, 0).countr_zero () == 64 && u128_t (1, 0).bit_width () == 65,      "countr_zero() and bit_width() past 64 bits");
+
+  // --- Address arithmetic ---
+
+  std::cout << "\n--- Address arithmetic ---\n";
+
+  const ip6_t last6 = "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff";
+  CHECK (last6.next ().to_str () == "::",                                              "next() of all ones wraps to ::");
+  CHECK (ip6_t ("::").prev () == last6,                                                "prev() of :: wraps to all ones");
+  CHECK (ip6_t ("::ffff:ffff:ffff:ffff").next () == ip6_t ("0:0:0:1::"),               "next() carries across the 64-bit boundary");
+  CHECK (ip6_t ("0:0:0:1::").prev ().to_str () == "::ffff:ffff:ffff:ffff",             "prev() borrows across the 64-bit boundary");
+  CHECK ((ip6_t ("::") + (-1)) == last6,                                               "+ (-1) of :: wraps to all ones");
+  CHECK ((ip6_t ("2001:db8::1") + (-1)).to_str () == "2001:db8::",                     "+ negative step goes back");
+  CHECK ((ip6_t ("2001:db8::1") - (-1)).to_str () == "2001:db8::2",                    "- negative step goes forward");
+  CHECK ((ip6_t ("0:0:0:1::") + (int64_t)-2).to_str () == "::ffff:ffff:ffff:fffe",    "+ negative int64_t step across the 64-bit boundary");
+  CHECK ((last6 + 2).to_str () == "::1",                                               "+ 2 of all ones wraps");
+  CHECK ((ip6_t ("::") + u128_t (1, 0)) == ip6_t ("0:0:0:1::"),                        "+ u128_t step");
+  CHECK (ip6_t ("::ffff:ffff:ffff:ffff").distance ("0:0:0:1::1") == u128_t (2),        "distance() across the 64-bit boundary");
+  CHECK (ip6_t ("0:0:0:1::1").distance ("::ffff:ffff:ffff:ffff") == all_ones - u128_t (1), "distance() backward wraps");
+  CHECK (ip6_t ("::").distance (last6) == all_ones && last6.distance ("::") == u128_t (1), "distance() over the whole space");
+
   // --- Equality ---
 
   std::cout << "\n--- Equality ---\n";
@@ -401,6 +510,14 @@ int main () {
   CHECK ((addr4_t("192.168.1.2:123") == addr4_t("192.168.2.2:123")) == false,"addr4 diff ip");
   CHECK ((addr4_t("192.168.1.2:123") == addr4_t("192.168.1.2:124")) == false,"addr4 diff port");
 
+  // --- to_chars ---
+
+  std::cout << "\n--- to_chars ---\n";
+
+  CHECK (chars_of (addr4_t ("10.0.0.1:80"), 11) == "10.0.0.1:80",                    "addr4 to_chars into an exact buffer");
+  CHECK (chars_of (addr4_t ("10.0.0.1:80"), 10) == "#null",                          "addr4 to_chars into a short buffer");
+  CHECK (chars_of (addr4_t ("255.255.255.255:65535"), addr4_t::max_str_len) == "255.255.255.255:65535", "addr4 to_chars at max_str_len");
+
   // --- Hash ---
 
   std::cout << "\n--- Hash ---\n";
@@ -484,6 +601,14 @@ int main () {
   std::cout << "  no reduction: " << a6_ts.to_str (false)       << '\n';
   std::cout << "  embedded v4:  " << a6_ts.to_str (true, true)  << '\n';
 
+  // --- to_chars ---
+
+  std::cout << "\n--- to_chars ---\n";
+
+  CHECK (chars_of (addr6_t ("[2001:db8::1]:443"), 17) == "[2001:db8::1]:443",        "addr6 to_chars into an exact buffer");
+  CHECK (chars_of (addr6_t ("[2001:db8::1]:443"), 16) == "#null",                    "addr6 to_chars into a short buffer");
+  CHECK (chars_of (a6_ts, addr6_t::max_str_len, true, true) == a6_ts.to_str (true, true), "addr6 to_chars embedded v4 same as to_str");
+
   // --- Hash ---
 
   std::cout << "\n--- Hash ---\n";
@@ -0,0 +1,199 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "ip_bulk_parse.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+  #include <sys/mman.h>
+  #include <unistd.h>
+  #define HAS_GUARD_PAGE 1
+#endif
+
+// this file is built twice: as is, and with IP_SOCKETS_NO_SIMD (ipsockets_ip_bulk_parse_scalar),
+// so both paths of parse_bulk() are compared with from_str()
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using clock_type = std::chrono::steady_clock;
+
+// a view over memory that is not zero terminated
+struct text_view_t {
+  const char* text;
+  size_t      length;
+  const char* data () const { return text; }
+  size_t      size () const { return length; }
+};
+
+// parse_bulk() gives the same address and the same success bit as from_str() for every item
+template <class View>
+static bool same_as_from_str (const std::vector<View>& items) {
+  std::vector<ip4_t>    results (items.size ());
+  std::vector<uint64_t> success ((items.size () + 63) / 64);
+  size_t parsed = parse_bulk (items.data (), items.size (), results.data (), success.data ());
+  size_t count  = 0;
+  for (size_t i = 0; i < items.size (); i++) {
+    bool  ok = false;
+    ip4_t expected;
+    expected.from_str (items[i].data (), items[i].size (), &ok);
+    if (ok != (((success[i / 64] >> (i % 64)) & 1) != 0) || !(results[i] == expected))
+      return false;
+    count += ok;
+  }
+  return parsed == count;
+}
+
+static std::vector<std::string> strings (std::initializer_list<std::string> list) {
+  return std::vector<std::string> (list);
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  #ifdef IP_SOCKETS_HAS_SIMD_PARSE
+    std::cout << "  Bulk Parse Tests (SSE4.1 " << (bulk_parse::simd_supported () ? "kernel" : "not supported, scalar") << ")\n";
+  #else
+    std::cout << "  Bulk Parse Tests (IP_SOCKETS_NO_SIMD, scalar)\n";
+  #endif
+  std::cout << "========================================\n\n";
+
+  // --- Inputs vs from_str ---
+
+  std::cout << "--- Inputs vs from_str ---\n";
+
+  CHECK (same_as_from_str (strings ({ "0.0.0.0", "1.2.3.4", "10.0.0.1", "192.168.100.200", "255.255.255.255", "9.99.199.249" })),
+         "canonical dotted quads");
+  CHECK (same_as_from_str (strings ({ "01.2.3.4", "1.02.3.4", "001.002.003.004", "0.0.0.00", "010.010.010.010" })),
+         "leading zeros");
+  CHECK (same_as_from_str (strings ({ "127.1", "192.168.1", "3232235778", "0xc0a80102", "0xc0.0xa8.1.2", "1.2.3" })),
+         "short forms, single number and hex");
+  CHECK (same_as_from_str (strings ({ "256.1.1.1", "1.1.1.256", "999.999.999.999", "255.255.255.300", "300.1" })),
+         "octets above 255");
+  CHECK (same_as_from_str (strings ({ std::string ("1.2.3.4\0", 8), std::string ("1.2\0.3.4", 8), std::string ("\0" "1.2.3.4", 8),
+                                      std::string ("1.2.3.4\0\0\0\0\0\0\0\0", 15) })),
+         "trailing and embedded zero bytes");
+  CHECK (same_as_from_str (strings ({ "", ".", "1.2.3.", ".1.2.3", "1..2.3", "1.2.3.4.", "1.2.3.4.5", "a.b.c.d", " 1.2.3.4", "1.2.3.4 " })),
+         "empty and malformed");
+  CHECK (same_as_from_str (strings ({ "1.2.3.4/", "100.100.100.1000", "0000000000000001", "1.2.3.4567890123456", "255.255.255.2555" })),
+         "strings of 16 bytes and longer");
+
+  {
+    // random strings over the characters that matter, every length from 0 to 20
+    std::mt19937             rng (1);
+    const char               alphabet[] = "0123456789..x\0";
+    std::vector<std::string> items;
+    for (int i = 0; i < 200000; i++) {
+      std::string text (rng () % 21, '0');
+      for (char& c : text)
+        c = alphabet[rng () % (sizeof (alphabet) - 1)];
+      items.push_back (text);
+    }
+    CHECK (same_as_from_str (items), "200000 random strings");
+  }
+
+  // --- Text at the end of a page ---
+
+  std::cout << "\n--- Text at the end of a page ---\n";
+
+  #ifdef HAS_GUARD_PAGE
+  {
+    // the byte after each text is in a PROT_NONE page: any read past the text crashes the example
+    size_t page = (size_t)sysconf (_SC_PAGESIZE);
+    char*  base = (char*)mmap (nullptr, page * 2, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (base == (char*)MAP_FAILED || mprotect (base + page, page, PROT_NONE) != 0)
+      CHECK (false, "mmap a page with a guard page");
+    else {
+      char* end = base + page;
+      const char* texts[] = { "1.2.3.4", "255.255.255.255", "10.0.0.1", "127.1", "0xc0a80102", "256.1.1.1", "1.2.3.4.5", "" };
+      bool  same = true;
+      for (const char* text : texts) {
+        size_t size = std::strlen (text);
+        for (size_t cut = 0; cut <= size; cut++) { // every prefix of the text, each one ending at the guard page
+          std::memcpy (end - cut, text, cut);
+          std::vector<text_view_t> items (1, text_view_t { end - cut, cut });
+          same = same && same_as_from_str (items);
+        }
+      }
+      CHECK (same, "no read past texts ending exactly at a page boundary");
+      munmap (base, page * 2);
+    }
+  }
+  #else
+    std::cout << "[SKIP] no mmap on this platform\n";
+  #endif
+
+  // --- SSE4.1 kernel ---
+
+  std::cout << "\n--- SSE4.1 kernel ---\n";
+
+  #ifdef IP_SOCKETS_HAS_SIMD_PARSE
+    if (bulk_parse::simd_supported ()) {
+      // the kernel accepts exactly the canonical dotted quads and agrees with from_str on them
+      std::mt19937 rng (2);
+      bool         same = true;
+      for (int i = 0; i < 200000 && same; i++) {
+        std::string text = ip4_t ((uint32_t)rng ()).to_str ();
+        ip4_t       simd;
+        same = bulk_parse::parse_ip4_sse41 (text.data (), text.size (), simd) && simd == ip4_t (text);
+      }
+      CHECK (same, "200000 random canonical addresses");
+      ip4_t result;
+      CHECK (!bulk_parse::parse_ip4_sse41 ("127.1", 5, result) && !bulk_parse::parse_ip4_sse41 ("1.2.3.256", 9, result) &&
+             !bulk_parse::parse_ip4_sse41 ("0x1.2.3.4", 9, result) && !bulk_parse::parse_ip4_sse41 ("1.2.3.4\0", 8, result),
+             "non-canonical text is left to the scalar parser");
+    }
+    else
+      std::cout << "[SKIP] the CPU has no SSE4.1\n";
+  #else
+    std::cout << "[SKIP] built with IP_SOCKETS_NO_SIMD\n";
+  #endif
+
+  // --- Benchmark ---
+
+  const size_t count = 1000000;
+
+  std::cout << "\n--- Benchmark: " << count << " canonical addresses ---\n";
+
+  {
+    std::mt19937             rng (3);
+    std::vector<std::string> items;
+    for (size_t i = 0; i < count; i++)
+      items.push_back (ip4_t ((uint32_t)rng ()).to_str ());
+    std::vector<ip4_t> results (count), expected (count);
+
+    clock_type::time_point start = clock_type::now ();
+    size_t parsed = parse_bulk (items.data (), count, results.data (), nullptr);
+    double bulk   = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / count;
+
+    start = clock_type::now ();
+    for (size_t i = 0; i < count; i++)
+      expected[i].from_str (items[i]);
+    double single = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / count;
+
+    printf ("  parse_bulk(): %.1f ns/address, from_str(): %.1f ns/address\n", bulk, single);
+    CHECK (parsed == count && results == expected, "same addresses");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
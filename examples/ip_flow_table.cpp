@@ -0,0 +1,196 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "ip_flow_table.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using clock_type = std::chrono::steady_clock;
+
+static const uint8_t proto_udp = 17;
+
+// distinct flow key number i: source 10.x.x.x:port, destination 192.168.0.1:53
+static flow_key_t<v4> make_key (uint32_t i) {
+  addr4_t src, dst;
+  src.ip   = ip4_t ((uint32_t)(0x0a000000 | (i >> 8)));
+  src.port = (uint16_t)(1024 + (i & 0xff));
+  dst.ip   = ip4_t ("192.168.0.1");
+  dst.port = 53;
+  return flow_key_t<v4> (src, dst, proto_udp);
+}
+
+static double elapsed_ns (clock_type::time_point start, size_t count) {
+  return std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / (double)(count ? count : 1);
+}
+
+// randomized run against a std::map model: update/touch/erase/expire every tick, 'steps' ticks from 'start',
+// optionally skipping expire() for more than a wheel turn; returns true if the table always matched the model
+static bool model_run (uint32_t start, uint32_t steps, uint32_t timeout, bool gaps, unsigned seed) {
+  flow_table_t<v4>             table (timeout, 0, 4);
+  std::map<uint32_t, uint32_t> model; // key number -> last seen
+  std::mt19937                 rng (seed);
+  uint32_t                     now = start;
+  bool                         same = true;
+
+  for (uint32_t step = 0; step < steps && same; step++, now++) {
+    for (int op = 0; op < 20; op++) {
+      uint32_t id = rng () % 500;
+      switch (rng () % 4) {
+        case 0: case 1:
+          table.update (make_key (id), now, [] (flow_stats_t& flow, bool) { flow.packets++; });
+          model[id] = now;
+          break;
+        case 2:
+          if (table.touch (make_key (id), now) != (model.count (id) != 0)) same = false;
+          if (model.count (id)) model[id] = now;
+          break;
+        default:
+          if (table.erase (make_key (id)) != (model.erase (id) != 0)) same = false;
+      }
+    }
+
+    if (gaps && rng () % 50 == 0)
+      now += timeout * 3 + rng () % 100; // several wheel turns without expire()
+
+    std::map<uint32_t, uint32_t> expected;
+    for (const auto& flow : model)
+      if ((int32_t)(now - flow.second) < (int32_t)timeout)
+        expected.insert (flow);
+    size_t expected_removed = model.size () - expected.size ();
+    size_t removed          = table.expire (now);
+    model.swap (expected);
+    if (removed != expected_removed || table.size () != model.size ())
+      same = false;
+  }
+  return same;
+}
+
+int main (int argc, char** argv) {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  Flow Table Tests\n";
+  std::cout << "========================================\n\n";
+
+  // --- Basic operations ---
+
+  std::cout << "--- Basic operations ---\n";
+
+  {
+    flow_table_t<v4> table (30, 0, 4);
+    flow_key_t<v4>   key = make_key (1);
+    bool             created = false;
+    table.update (key, 100, [&] (flow_stats_t& flow, bool is_new) { flow.packets++; flow.bytes += 100; created = is_new; });
+    table.update (key, 101, [&] (flow_stats_t& flow, bool is_new) { flow.packets++; flow.bytes += 50;  created = is_new; });
+    flow_stats_t stats;
+    CHECK (table.find (key, stats) && stats.packets == 2 && stats.bytes == 150, "update counts packets and bytes");
+    CHECK (!created,                                                              "second update is not created");
+    CHECK (key.reversed ().reversed () == key && !table.contains (key.reversed ()), "reversed key is another flow");
+    CHECK (table.expire (130) == 0 && table.contains (key),                       "flow seen at 101 lives at 130");
+    CHECK (table.expire (131) == 1 && !table.contains (key),                      "flow expires after 30 idle ticks");
+
+    table.update (key, 200, [] (flow_stats_t&, bool) {});
+    table.touch  (key, 225);
+    CHECK (table.expire (254) == 0 && table.contains (key),                       "touch() postpones expiry");
+    CHECK (table.expire (255) == 1,                                               "touched flow expires 30 ticks after touch");
+
+    table.update (key, 300, [] (flow_stats_t&, bool) {});
+    CHECK (table.erase (key) && !table.erase (key),                               "erase removes the flow once");
+    table.update (key, 320, [] (flow_stats_t&, bool) {});
+    CHECK (table.expire (335) == 0 && table.contains (key),                       "re-created flow ignores the stale wheel record");
+    CHECK (table.expire (350) == 1,                                               "re-created flow expires on its own schedule");
+
+    flow_table_t<v4> limited (30, 8, 1);
+    int accepted = 0;
+    for (uint32_t i = 0; i < 20; i++)
+      accepted += limited.update (make_key (i), 1, [] (flow_stats_t&, bool) {}) ? 1 : 0;
+    CHECK (accepted == 8 && limited.stats ().rejected == 12,                      "max_flows rejects new flows");
+  }
+
+  // --- Aging across tick wrap-around ---
+
+  std::cout << "\n--- Aging across tick wrap-around ---\n";
+
+  {
+    flow_table_t<v4> table (30, 0, 4);
+    uint32_t         start = 0xfffffff0u;
+    for (uint32_t i = 0; i < 100; i++)
+      table.update (make_key (i), start + i % 20, [] (flow_stats_t&, bool) {});
+    // every flow must go away exactly 30 ticks after it was seen, also when the tick wraps through zero
+    bool exact = true;
+    for (uint32_t now = start; now != start + 60; now++)
+      table.expire (now, [&] (const flow_key_t<v4>& key, flow_stats_t&) {
+        uint32_t i = 0;
+        while (i < 100 && make_key (i) != key)
+          i++;
+        exact = exact && i < 100 && (uint32_t)(now - (start + i % 20)) == 30;
+      });
+    CHECK (exact && table.size () == 0,                                           "flows seen before the wrap expire after it");
+  }
+
+  CHECK (model_run (0xffffff00u, 2000, 30, false, 1), "random ops vs std::map model, wrap-around, expire every tick");
+  CHECK (model_run (0xffffff00u, 2000, 30, true,  2), "random ops vs std::map model, gaps longer than the wheel");
+  CHECK (model_run (0x7fffff00u, 2000, 7,  true,  3), "random ops vs std::map model, signed wrap, short timeout");
+
+  // --- Benchmark ---
+
+  size_t flows = (argc > 1) ? (size_t)std::strtoull (argv[1], nullptr, 10) : 10000000;
+
+  std::cout << "\n--- Benchmark: " << flows << " v4 flows, 64 shards, one thread ---\n";
+
+  {
+    flow_table_t<v4> table (30, 0, 64);
+    std::vector<uint32_t> order (flows);
+    for (size_t i = 0; i < flows; i++)
+      order[i] = (uint32_t)i;
+    std::shuffle (order.begin (), order.end (), std::mt19937 (7));
+
+    clock_type::time_point start = clock_type::now ();
+    for (size_t i = 0; i < flows; i++)
+      table.update (make_key ((uint32_t)i), 1, [] (flow_stats_t& flow, bool) { flow.packets++; });
+    printf ("  insert:            %.0f ns/flow\n", elapsed_ns (start, flows));
+
+    start = clock_type::now ();
+    for (size_t i = 0; i < flows; i++)
+      table.update (make_key (order[i]), 2, [] (flow_stats_t& flow, bool) { flow.packets++; });
+    printf ("  random update:     %.0f ns/flow\n", elapsed_ns (start, flows));
+
+    flow_table_t<v4>::stats_t stats = table.stats ();
+    printf ("  occupancy:         %.2f (%zu flows in %zu slots)\n", stats.occupancy (), stats.flows, stats.capacity);
+    CHECK (stats.flows == flows && stats.created == flows, "all flows inserted");
+
+    for (uint32_t now = 3; now < 32; now++)
+      table.expire (now);
+    CHECK (table.size () == flows,                         "no flow expires before its timeout");
+
+    start = clock_type::now ();
+    size_t removed = table.expire (32);
+    printf ("  expire all:        %.0f ns/flow\n", elapsed_ns (start, removed));
+    CHECK (removed == flows && table.size () == 0,         "all flows expire at once");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
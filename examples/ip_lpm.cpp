@@ -0,0 +1,203 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "ip_lpm.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using clock_type = std::chrono::steady_clock;
+
+// brute-force longest match: the reference every lookup is compared with
+template <ip_type_e Ip_type>
+static const int* naive_lookup (const std::map<ip_prefix_t<Ip_type>, int>& prefixes, const ip_t<Ip_type>& ip) {
+  const int* best        = nullptr;
+  int        best_length = -1;
+  for (const auto& prefix : prefixes)
+    if ((int)prefix.first.length > best_length && prefix.first.contains (ip)) {
+      best        = &prefix.second;
+      best_length = prefix.first.length;
+    }
+  return best;
+}
+
+template <ip_type_e Ip_type>
+static bool same_result (const int* a, const int* b) {
+  return (a == nullptr) ? (b == nullptr) : (b != nullptr && *a == *b);
+}
+
+// address near 'base': random low bits, so random prefixes overlap a lot
+template <ip_type_e Ip_type>
+static ip_t<Ip_type> random_ip (std::mt19937& rng, const ip_t<Ip_type>& base) {
+  ip_t<Ip_type> ip = base;
+  for (size_t i = Ip_type - 3; i < Ip_type; i++)
+    ip[i] = (uint8_t)rng ();
+  if (rng () % 8 == 0)
+    ip[0] = (uint8_t)rng (); // sometimes far away
+  return ip;
+}
+
+// random inserts/erases/overwrites checked against the brute-force model after every change
+template <ip_type_e Ip_type>
+static bool model_run (const ip_t<Ip_type>& base, unsigned seed, size_t steps) {
+  lpm_table_t<Ip_type, int>               table;
+  std::map<ip_prefix_t<Ip_type>, int>     model;
+  std::mt19937                            rng (seed);
+  const uint8_t                           max_length = ip_prefix_t<Ip_type>::max_length;
+
+  for (size_t step = 0; step < steps; step++) {
+    uint8_t              length = (uint8_t)((rng () % 4 == 0) ? rng () % (max_length + 1) : max_length - rng () % 25);
+    ip_prefix_t<Ip_type> prefix (random_ip<Ip_type> (rng, base), length);
+    if (rng () % 3 == 0) {
+      if (table.erase (prefix) != (model.erase (prefix) != 0))
+        return false;
+    }
+    else {
+      int value = (int)step;
+      if (table.insert (prefix, value) != (model.count (prefix) == 0))
+        return false;
+      model[prefix] = value;
+    }
+    for (int probe = 0; probe < 20; probe++) {
+      ip_t<Ip_type> ip = random_ip<Ip_type> (rng, base);
+      if (!same_result<Ip_type> (table.lookup (ip), naive_lookup (model, ip)))
+        return false;
+    }
+  }
+
+  // erasing everything must fold every node back
+  for (const auto& prefix : model)
+    table.erase (prefix.first);
+  return table.size () == 0 && table.nodes () == 0 && table.lookup (base) == nullptr;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  Longest Prefix Match Tests\n";
+  std::cout << "========================================\n\n";
+
+  // --- IPv4 ---
+
+  std::cout << "--- IPv4 ---\n";
+
+  {
+    lpm_table_t<v4, int> table;
+    CHECK (table.lookup ("10.1.2.3") == nullptr,                          "empty table has no match");
+
+    CHECK (table.insert ("10.1.2.0/24", 24),                              "insert covered prefix first");
+    CHECK (table.insert ("10.0.0.0/8", 8),                                "insert covering prefix after it");
+    CHECK (*table.lookup ("10.1.2.3") == 24 && *table.lookup ("10.1.3.1") == 8, "short prefix does not hide the longer one");
+    CHECK (table.insert ("10.1.2.3/32", 32) && *table.lookup ("10.1.2.3") == 32, "/32 host prefix");
+    CHECK (*table.lookup ("10.1.2.4") == 24,                              "/32 neighbour keeps /24");
+    CHECK (table.insert ("0.0.0.0/0", 0) && *table.lookup ("11.0.0.1") == 0,    "/0 default route");
+    CHECK (!table.insert ("10.0.0.0/8", 80) && *table.lookup ("10.9.9.9") == 80, "insert of an existing prefix overwrites");
+    CHECK (*table.find ("10.1.2.0/24") == 24 && table.find ("10.1.0.0/16") == nullptr, "find() is exact");
+
+    CHECK (table.erase ("10.1.2.0/24") && *table.lookup ("10.1.2.4") == 80,     "erase covered prefix falls back to the covering one");
+    CHECK (*table.lookup ("10.1.2.3") == 32,                              "longer prefix survives erase of its cover");
+    CHECK (table.erase ("10.0.0.0/8") && *table.lookup ("10.9.9.9") == 0,       "erase covering prefix falls back to /0");
+    CHECK (*table.lookup ("10.1.2.3") == 32,                              "/32 survives erase of /8");
+    CHECK (!table.erase ("10.0.0.0/8"),                                   "erase of a missing prefix");
+    CHECK (table.erase ("10.1.2.3/32") && table.nodes () == 0,            "erasing the last long prefix folds the nodes");
+    CHECK (table.erase ("0.0.0.0/0") && table.lookup ("10.1.2.3") == nullptr,   "empty again");
+  }
+
+  // --- IPv6 ---
+
+  std::cout << "\n--- IPv6 ---\n";
+
+  {
+    lpm_table_t<v6, int> table;
+    table.insert ("::/0", 0);
+    table.insert ("2001:db8::/32", 32);
+    table.insert ("2001:db8:1::/48", 48);
+    table.insert ("2001:db8:1:2::/64", 64);
+    table.insert ("2001:db8:1:2::7/128", 128);
+    CHECK (*table.lookup ("2001:db8:1:2::7") == 128,  "v6 /128");
+    CHECK (*table.lookup ("2001:db8:1:2::8") == 64,   "v6 /64");
+    CHECK (*table.lookup ("2001:db8:1:3::1") == 48,   "v6 /48");
+    CHECK (*table.lookup ("2001:db8:2::1") == 32,     "v6 /32");
+    CHECK (*table.lookup ("2001:db9::1") == 0,        "v6 /0");
+    table.erase ("2001:db8:1::/48");
+    CHECK (*table.lookup ("2001:db8:1:3::1") == 32 && *table.lookup ("2001:db8:1:2::7") == 128, "v6 erase of a middle prefix");
+  }
+
+  // --- Random operations vs brute force ---
+
+  std::cout << "\n--- Random operations vs brute force ---\n";
+
+  CHECK (model_run<v4> (ip4_t ("10.20.0.0"), 1, 3000),           "v4 insert/overwrite/erase, 20 lookups per step");
+  CHECK (model_run<v6> (ip6_t ("2001:db8:1:2:3:4::"), 2, 3000), "v6 insert/overwrite/erase, 20 lookups per step");
+
+  // --- Benchmark ---
+
+  std::cout << "\n--- Benchmark: lookups, lpm_table_t vs naive prefix loop ---\n";
+
+  std::mt19937 rng (3);
+  for (size_t count : { (size_t)100, (size_t)1000, (size_t)10000 }) {
+    lpm_table_t<v4, int>       table;
+    std::vector<prefix4_t>     prefixes;
+    std::vector<int>           values;
+    for (size_t i = 0; i < count; i++) {
+      prefix4_t prefix (ip4_t ((uint32_t)rng ()), (uint8_t)(8 + rng () % 25));
+      if (table.find (prefix) == nullptr && table.insert (prefix, (int)i)) {
+        prefixes.push_back (prefix);
+        values.push_back ((int)i);
+      }
+    }
+    std::vector<ip4_t> ips (20000);
+    for (size_t i = 0; i < ips.size (); i++)
+      ips[i] = (i % 2) ? ip4_t ((uint32_t)rng ()) : prefixes[rng () % prefixes.size ()].ip;
+
+    const int              rounds = 50; // the naive loop is too slow for as many lookups
+    long long              sum    = 0;
+    clock_type::time_point start  = clock_type::now ();
+    for (int round = 0; round < rounds; round++)
+      for (const ip4_t& ip : ips) {
+        const int* value = table.lookup (ip);
+        sum += value ? *value : -1;
+      }
+    double lpm_ns = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / (ips.size () * rounds);
+    sum /= rounds;
+
+    long long naive_sum = 0;
+    start = clock_type::now ();
+    for (const ip4_t& ip : ips) {
+      int best = -1, best_length = -1;
+      for (size_t i = 0; i < prefixes.size (); i++)
+        if ((int)prefixes[i].length > best_length && prefixes[i].contains (ip)) {
+          best        = values[i];
+          best_length = prefixes[i].length;
+        }
+      naive_sum += best;
+    }
+    double naive_ns = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / ips.size ();
+
+    printf ("  %6zu prefixes: lpm_table_t %6.1f ns/lookup, naive loop %9.1f ns/lookup\n", prefixes.size (), lpm_ns, naive_ns);
+    CHECK (sum == naive_sum, "same results as the naive loop");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -0,0 +1,213 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "ip_lpm_file.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using clock_type = std::chrono::steady_clock;
+
+// lpm_view_t needs a 64-byte aligned image, std::vector<uint8_t> does not guarantee it
+struct aligned_image_t {
+  std::vector<uint8_t> storage;
+  uint8_t*             data = nullptr;
+  size_t               size = 0;
+
+  explicit aligned_image_t (const std::vector<uint8_t>& image) : storage (image.size () + 64), size (image.size ()) {
+    data = storage.data () + ((64 - ((uintptr_t)storage.data () & 63)) & 63);
+    std::memcpy (data, image.data (), size);
+  }
+};
+
+template <ip_type_e Ip_type>
+static void fill_random (lpm_table_t<Ip_type, uint32_t>& table, std::mt19937& rng, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    ip_t<Ip_type> ip;
+    for (size_t b = 0; b < Ip_type; b++)
+      ip[b] = (uint8_t)rng ();
+    ip[0] = (uint8_t)(ip[0] & 0x0f); // keep the prefixes overlapping
+    uint8_t length = (uint8_t)(rng () % (ip_prefix_t<Ip_type>::max_length + 1));
+    table.insert (ip_prefix_t<Ip_type> (ip, length), (uint32_t)i);
+  }
+}
+
+// the same answer from the table and the view for many random addresses
+template <ip_type_e Ip_type>
+static bool same_lookups (const lpm_table_t<Ip_type, uint32_t>& table, const lpm_view_t<Ip_type, uint32_t>& view, std::mt19937& rng) {
+  for (int i = 0; i < 100000; i++) {
+    ip_t<Ip_type> ip;
+    for (size_t b = 0; b < Ip_type; b++)
+      ip[b] = (uint8_t)rng ();
+    ip[0] = (uint8_t)(ip[0] & 0x1f);
+    const uint32_t* a = table.lookup (ip);
+    const uint32_t* b = view.lookup (ip);
+    if ((a == nullptr) != (b == nullptr) || (a && *a != *b))
+      return false;
+  }
+  return true;
+}
+
+template <ip_type_e Ip_type>
+static int round_trip (const char* name, size_t prefixes, std::mt19937& rng) {
+
+  int failures = 0;
+
+  lpm_table_t<Ip_type, uint32_t> table;
+  fill_random (table, rng, prefixes);
+  table.insert (ip_prefix_t<Ip_type> (ip_t<Ip_type> (), 0), 0xdefa017u);
+
+  std::vector<uint8_t> image;
+  lpm_compile (table, image);
+  aligned_image_t aligned (image);
+
+  lpm_view_t<Ip_type, uint32_t> view;
+  std::cout << "  " << name << ": " << table.size () << " prefixes, image " << image.size () / 1024 << " KiB\n";
+  CHECK (view.attach (aligned.data, aligned.size) && view.verify (), "compile, attach and verify");
+  CHECK (view.size () == table.size (),                              "view holds every prefix");
+  CHECK (same_lookups (table, view, rng),                            "view lookups match the table");
+
+  lpm_table_t<Ip_type, uint32_t> loaded;
+  view.load (loaded);
+  std::vector<uint8_t> again;
+  lpm_compile (loaded, again);
+  CHECK (again == image,                                             "load() and compile again gives the same image");
+
+  size_t ordered = 0, count = 0;
+  ip_prefix_t<Ip_type> previous;
+  view.for_each ([&] (const ip_prefix_t<Ip_type>& prefix, const uint32_t& value) {
+    const uint32_t* stored = table.find (prefix);
+    ordered += (count == 0 || previous < prefix) && stored && *stored == value;
+    previous = prefix;
+    count++;
+  });
+  CHECK (count == table.size () && ordered == count,                 "for_each() visits every prefix once, in order");
+
+  return failures;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  Compiled LPM Table Tests\n";
+  std::cout << "========================================\n\n";
+
+  std::mt19937 rng (1);
+
+  // --- Compile / attach / verify round trip ---
+
+  std::cout << "--- Compile / attach / verify round trip ---\n";
+
+  failures += round_trip<v4> ("v4", 20000, rng);
+  failures += round_trip<v6> ("v6", 2000,  rng); // long random v6 prefixes need up to 14 nodes each
+
+  {
+    lpm_table_t<v4, uint32_t> empty;
+    std::vector<uint8_t>      image;
+    lpm_compile (empty, image);
+    aligned_image_t           aligned (image);
+    lpm_view_t<v4, uint32_t>  view (aligned.data, aligned.size);
+    CHECK (view.valid () && view.verify () && view.lookup ("1.2.3.4") == nullptr, "empty table image");
+  }
+
+  // --- Rejected images ---
+
+  std::cout << "\n--- Rejected images ---\n";
+
+  {
+    lpm_table_t<v4, uint32_t> table;
+    table.insert ("10.0.0.0/8", 8);
+    table.insert ("10.1.2.0/24", 24);
+    table.insert ("10.1.2.3/32", 32);
+    std::vector<uint8_t> image;
+    lpm_compile (table, image);
+
+    lpm_view_t<v4, uint32_t> view;
+    aligned_image_t          good (image);
+    CHECK (view.attach (good.data, good.size) && view.verify (),       "valid image");
+    CHECK (!view.attach (good.data, good.size - 1),                    "truncated image");
+    CHECK (!view.attach (good.data + 1, good.size - 1),                "unaligned image");
+    lpm_view_t<v6, uint32_t> view6;
+    lpm_view_t<v4, uint64_t> view64;
+    CHECK (!view6.attach (good.data, good.size),                       "other address family");
+    CHECK (!view64.attach (good.data, good.size),                      "other value type");
+
+    std::vector<uint8_t> bad_magic = image;
+    bad_magic[0] = 'X';
+    aligned_image_t magic (bad_magic);
+    CHECK (!view.attach (magic.data, magic.size),                      "wrong magic");
+
+    lpm_file_header_t header;
+    std::memcpy (&header, image.data (), sizeof (header));
+    size_t slot = (size_t)header.entries_offset + ((10u << 8) | 1u) * sizeof (uint32_t); // root slot of 10.1.x.x
+
+    std::vector<uint8_t> bad_child = image;
+    uint32_t             loop      = lpm_table_t<v4, uint32_t>::child_flag | 1000000u;
+    std::memcpy (bad_child.data () + slot, &loop, sizeof (loop));
+    aligned_image_t child (bad_child);
+    CHECK (view.attach (child.data, child.size) && !view.verify (),    "verify() rejects a node index out of range");
+
+    std::vector<uint8_t> bad_value = image;
+    uint32_t             missing   = (uint32_t)header.value_count + 1;
+    std::memcpy (bad_value.data () + slot, &missing, sizeof (missing));
+    aligned_image_t value (bad_value);
+    CHECK (view.attach (value.data, value.size) && !view.verify (),    "verify() rejects a value index out of range");
+  }
+
+  // --- Mapped file ---
+
+  std::cout << "\n--- Mapped file ---\n";
+
+  {
+    const std::string path = "ip_lpm_file_example.lpm";
+
+    lpm_table_t<v4, uint32_t> table;
+    fill_random (table, rng, 100000);
+
+    clock_type::time_point start = clock_type::now ();
+    bool compiled = lpm_compile (table, path);
+    double compile_ms = std::chrono::duration<double, std::milli> (clock_type::now () - start).count ();
+
+    lpm_file_t<v4, uint32_t> file;
+    start = clock_type::now ();
+    bool opened = file.open (path);
+    double open_ms = std::chrono::duration<double, std::milli> (clock_type::now () - start).count ();
+
+    printf ("  %zu prefixes: compile to file %.1f ms, open + verify %.1f ms\n", table.size (), compile_ms, open_ms);
+    CHECK (compiled && opened,                         "compile to file and map it");
+    CHECK (same_lookups (table, file.view, rng),       "mapped lookups match the table");
+
+    lpm_table_t<v4, uint32_t> other;
+    other.insert ("0.0.0.0/0", 7);
+    lpm_compile (other, path); // atomic replace while the old file is still mapped
+    CHECK (same_lookups (table, file.view, rng),       "old mapping stays valid after the file is replaced");
+    CHECK (file.open (path) && *file.view.lookup ("1.2.3.4") == 7, "open() again picks up the new file");
+
+    file.close ();
+    std::remove (path.c_str ());
+    CHECK (!file.open (path) && !file.view.valid (),   "missing file");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
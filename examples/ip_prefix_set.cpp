@@ -0,0 +1,209 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "ip_prefix_set.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using clock_type = std::chrono::steady_clock;
+using bitmap_t   = std::vector<bool>;
+
+// the model: a universe of 65536 addresses base + 0..65535 (the last 16 bits), one bit per address
+static const uint32_t universe = 65536;
+
+template <ip_type_e Ip_type>
+static ip_t<Ip_type> at (const ip_t<Ip_type>& base, uint32_t offset) {
+  ip_t<Ip_type> ip = base;
+  ip[Ip_type - 2]  = (uint8_t)(offset >> 8);
+  ip[Ip_type - 1]  = (uint8_t)offset;
+  return ip;
+}
+
+template <ip_type_e Ip_type>
+static uint32_t offset_of (const ip_t<Ip_type>& ip) {
+  return ((uint32_t)ip[Ip_type - 2] << 8) | ip[Ip_type - 1];
+}
+
+// random set made of prefixes and ranges inside the universe, built in both forms
+template <ip_type_e Ip_type>
+static prefix_set_t<Ip_type> random_set (const ip_t<Ip_type>& base, std::mt19937& rng, bitmap_t& bits) {
+  prefix_set_t<Ip_type> set;
+  bits.assign (universe, false);
+  int count = 1 + (int)(rng () % 40);
+  for (int i = 0; i < count; i++) {
+    if (rng () % 2) {
+      uint8_t              length = (uint8_t)(ip_prefix_t<Ip_type>::max_length - rng () % 13);
+      ip_prefix_t<Ip_type> prefix (at<Ip_type> (base, rng () % universe), length);
+      set.add (prefix);
+      uint32_t first = offset_of<Ip_type> (prefix.ip), size = 1u << (ip_prefix_t<Ip_type>::max_length - length);
+      for (uint32_t a = first; a < first + size; a++)
+        bits[a] = true;
+    }
+    else {
+      uint32_t first = rng () % universe, last = first + rng () % 3000;
+      if (last >= universe) last = universe - 1;
+      set.add (at<Ip_type> (base, first), at<Ip_type> (base, last));
+      for (uint32_t a = first; a <= last; a++)
+        bits[a] = true;
+    }
+  }
+  return set;
+}
+
+// minimal number of aligned blocks covering a bitmap (independent of prefix_set_t): greedy per run
+static size_t minimal_prefix_count (const bitmap_t& bits) {
+  size_t   count = 0;
+  uint32_t a     = 0;
+  while (a < universe) {
+    if (!bits[a]) { a++; continue; }
+    uint32_t size = 1;
+    while ((a & (size * 2 - 1)) == 0 && size * 2 <= universe) {
+      bool full = true;
+      for (uint32_t x = a; full && x < a + size * 2; x++)
+        full = bits[x];
+      if (!full) break;
+      size *= 2;
+    }
+    a += size;
+    count++;
+  }
+  return count;
+}
+
+// the set holds exactly the bitmap: contains() for every address, prefixes() sorted, disjoint, exact and minimal
+template <ip_type_e Ip_type>
+static bool matches (const prefix_set_t<Ip_type>& set, const ip_t<Ip_type>& base, const bitmap_t& bits) {
+  for (uint32_t a = 0; a < universe; a++)
+    if (set.contains (at<Ip_type> (base, a)) != bits[a])
+      return false;
+
+  bitmap_t covered (universe, false);
+  ip_t<Ip_type> previous_last {};
+  bool          first = true;
+  std::vector<ip_prefix_t<Ip_type>> prefixes = set.prefixes ();
+  for (const ip_prefix_t<Ip_type>& prefix : prefixes) {
+    typename prefix_set_t<Ip_type>::range_t range = prefix_set_t<Ip_type>::prefix_to_range (prefix);
+    if (!first && !(previous_last < range.first))
+      return false;
+    for (uint32_t a = offset_of<Ip_type> (range.first); a <= offset_of<Ip_type> (range.last); a++)
+      covered[a] = true;
+    previous_last = range.last;
+    first         = false;
+  }
+
+  std::vector<typename prefix_set_t<Ip_type>::range_t> ranges = set.ranges ();
+  for (size_t i = 1; i < ranges.size (); i++)
+    if (!(ranges[i - 1].last.next () < ranges[i].first)) // sorted, with a gap between neighbours
+      return false;
+
+  return covered == bits && prefixes.size () == minimal_prefix_count (bits);
+}
+
+template <ip_type_e Ip_type>
+static bool model_run (const ip_t<Ip_type>& base, unsigned seed, int rounds) {
+  std::mt19937 rng (seed);
+  for (int round = 0; round < rounds; round++) {
+    bitmap_t a_bits, b_bits;
+    prefix_set_t<Ip_type> a = random_set<Ip_type> (base, rng, a_bits);
+    prefix_set_t<Ip_type> b = random_set<Ip_type> (base, rng, b_bits);
+
+    bitmap_t or_bits (universe), and_bits (universe), sub_bits (universe);
+    for (uint32_t i = 0; i < universe; i++) {
+      or_bits[i]  = a_bits[i] || b_bits[i];
+      and_bits[i] = a_bits[i] && b_bits[i];
+      sub_bits[i] = a_bits[i] && !b_bits[i];
+    }
+    if (!matches<Ip_type> (a, base, a_bits) || !matches<Ip_type> (a.unite (b), base, or_bits) ||
+        !matches<Ip_type> (a.intersect (b), base, and_bits) || !matches<Ip_type> (a.subtract (b), base, sub_bits))
+      return false;
+
+    // range_to_prefixes() of a random range covers exactly that range with the minimal count
+    uint32_t first = rng () % universe, last = rng () % universe;
+    if (first > last) std::swap (first, last);
+    bitmap_t range_bits (universe, false);
+    for (uint32_t x = first; x <= last; x++)
+      range_bits[x] = true;
+    if (!matches<Ip_type> (prefix_set_t<Ip_type> (prefix_set_t<Ip_type>::range_to_prefixes (at<Ip_type> (base, first), at<Ip_type> (base, last))), base, range_bits))
+      return false;
+  }
+  return true;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  Prefix Set Tests\n";
+  std::cout << "========================================\n\n";
+
+  // --- Aggregation and set algebra ---
+
+  std::cout << "--- Aggregation and set algebra ---\n";
+
+  prefix_set_t<v4> allow ({ "10.0.0.0/25", "10.0.0.128/25", "10.0.1.0/24" });
+  prefix_set_t<v4> deny  ({ "10.0.0.64/26" });
+  CHECK (allow.prefixes () == std::vector<prefix4_t> ({ "10.0.0.0/23" }),                              "adjacent prefixes are aggregated");
+  CHECK ((allow - deny).prefixes () == std::vector<prefix4_t> ({ "10.0.0.0/26", "10.0.0.128/25", "10.0.1.0/24" }), "subtract splits a prefix");
+  CHECK ((allow & deny) == deny && (allow | deny) == allow,                                           "intersect and unite with a subset");
+  CHECK (prefix_set_t<v4>::range_to_prefixes ("10.0.0.1", "10.0.0.6") ==
+         std::vector<prefix4_t> ({ "10.0.0.1/32", "10.0.0.2/31", "10.0.0.4/31", "10.0.0.6/32" }),       "range_to_prefixes() of .1-.6");
+
+  // --- Edges of the address space ---
+
+  std::cout << "\n--- Edges of the address space ---\n";
+
+  CHECK (prefix_set_t<v4>::range_to_prefixes ("0.0.0.0", "255.255.255.255") == std::vector<prefix4_t> ({ "0.0.0.0/0" }), "v4 whole space is /0");
+  CHECK (prefix_set_t<v6>::range_to_prefixes ("::", "ffff:ffff:ffff:ffff:ffff:ffff:ffff:ffff") == std::vector<prefix6_t> ({ "::/0" }), "v6 whole space is /0");
+  CHECK (prefix_set_t<v4>::range_to_prefixes ("255.255.255.255", "255.255.255.255") == std::vector<prefix4_t> ({ "255.255.255.255/32" }), "last v4 address");
+  CHECK (prefix_set_t<v4>::range_to_prefixes ("10.0.0.2", "10.0.0.1").empty (),                     "first > last is empty");
+  prefix_set_t<v4> all ({ "0.0.0.0/0" });
+  CHECK ((all - prefix_set_t<v4> ({ "0.0.0.0/1" })).prefixes () == std::vector<prefix4_t> ({ "128.0.0.0/1" }), "/0 minus /1");
+  CHECK (all.contains (prefix4_t ("255.255.255.255/32")) && (all - all).prefixes ().empty (),        "/0 contains the last address, /0 - /0 is empty");
+
+  // --- Random sets vs bitmap model ---
+
+  std::cout << "\n--- Random sets vs bitmap model (65536 addresses) ---\n";
+
+  CHECK (model_run<v4> (ip4_t ("10.20.0.0"), 1, 200),        "v4 unite/intersect/subtract/range_to_prefixes");
+  CHECK (model_run<v4> (ip4_t ("255.255.0.0"), 2, 50),       "v4 at the end of the address space");
+  CHECK (model_run<v6> (ip6_t ("2001:db8::"), 3, 200),       "v6 unite/intersect/subtract/range_to_prefixes");
+
+  // --- Benchmark ---
+
+  std::cout << "\n--- Benchmark: aggregation of random v4 prefixes ---\n";
+
+  {
+    std::mt19937           rng (4);
+    std::vector<prefix4_t> input;
+    for (int i = 0; i < 1000000; i++)
+      input.push_back (prefix4_t (ip4_t ((uint32_t)rng ()), (uint8_t)(16 + rng () % 17)));
+    clock_type::time_point start = clock_type::now ();
+    prefix_set_t<v4>       set (input);
+    std::vector<prefix4_t> output = set.prefixes ();
+    double ms = std::chrono::duration<double, std::milli> (clock_type::now () - start).count ();
+    printf ("  %zu prefixes aggregated into %zu in %.1f ms\n", input.size (), output.size (), ms);
+    CHECK (prefix_set_t<v4> (output) == set, "aggregated list describes the same set");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -0,0 +1,205 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "reactor.h"
+#include "tcp_socket.h"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+// this file is built twice: with the default backend (epoll on Linux) and with IP_SOCKETS_REACTOR_POLL
+// (ipsockets_reactor_poll), so both backends run the same checks
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using udp_server_t = udp_socket_t<v4, socket_type_e::server>;
+using udp_client_t = udp_socket_t<v4, socket_type_e::client>;
+using tcp_server_t = tcp_socket_t<v4, socket_type_e::server>;
+using tcp_client_t = tcp_socket_t<v4, socket_type_e::client>;
+
+static const addr4_t ip_server = "127.0.0.1:2018";
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  #ifdef IP_SOCKETS_REACTOR_EPOLL
+    std::cout << "  Reactor Tests (epoll)\n";
+  #else
+    std::cout << "  Reactor Tests (poll)\n";
+  #endif
+  std::cout << "========================================\n\n";
+
+  // --- Registration ---
+
+  std::cout << "--- Registration ---\n";
+
+  reactor_t    reactor;
+  udp_server_t server (log_e::error);
+  udp_client_t client (log_e::error);
+  udp_client_t closed (log_e::none);
+  server.open (ip_server, 100);
+  client.open (ip_server, 100);
+
+  std::vector<std::string> received;
+  uint32_t                 server_events = 0;
+  bool                     drain         = true; // false: read one datagram per callback
+  auto on_server = [&] (uint32_t events) {
+    server_events |= events;
+    char    buf[64];
+    addr4_t from;
+    int     res;
+    while ((res = server.recvfrom (buf, sizeof (buf), from)) > 0) {
+      received.emplace_back (buf, res);
+      if (!drain) break;
+    }
+  };
+
+  CHECK (reactor.add (server, reactor_t::ev_read, on_server) == no_error,          "add() an opened socket");
+  CHECK (server.nonblocking,                                                         "add() switches the socket to non-blocking");
+  CHECK (reactor.add (server, reactor_t::ev_read, on_server) == error_already_opened, "add() twice is rejected");
+  CHECK (reactor.add (closed, reactor_t::ev_read, on_server) == error_closed_or_not_open, "add() a closed socket is rejected");
+  CHECK (reactor.modify (client, reactor_t::ev_read) == error_closed_or_not_open &&
+         reactor.remove (client) == error_closed_or_not_open,                       "modify()/remove() of an unknown socket");
+  CHECK (reactor.run_once (0) == 0,                                                  "nothing ready, nothing dispatched");
+
+  // --- Read events ---
+
+  std::cout << "\n--- Read events ---\n";
+
+  client.send ("one", 3);
+  client.send ("two", 3);
+  client.send ("three", 5);
+  int dispatched = reactor.run_once (1000);
+  CHECK (dispatched == 1 && server_events == reactor_t::ev_read,                    "ev_read callback for queued datagrams");
+  CHECK (received == std::vector<std::string> ({ "one", "two", "three" }),          "the callback drains until error_would_block");
+  CHECK (reactor.run_once (0) == 0,                                                  "no callback once everything is read");
+
+  drain = false;
+  received.clear ();
+  client.send ("a", 1);
+  client.send ("b", 1);
+  reactor.run_once (1000);
+  reactor.run_once (1000);
+  CHECK (received == std::vector<std::string> ({ "a", "b" }),                       "level-triggered: called again while data remains");
+  drain = true;
+
+  // --- Write events and modify() ---
+
+  std::cout << "\n--- Write events and modify() ---\n";
+
+  uint32_t client_events = 0;
+  int      client_calls  = 0;
+  auto on_client = [&] (uint32_t events) { client_events = events; client_calls++; };
+  reactor.add (client, reactor_t::ev_write, on_client);
+  reactor.run_once (1000);
+  CHECK (client_calls == 1 && client_events == reactor_t::ev_write,                 "ev_write callback for an empty send buffer");
+
+  CHECK (reactor.modify (client, reactor_t::ev_read) == no_error,                   "modify() to ev_read");
+  client_calls = 0;
+  reactor.run_once (0);
+  CHECK (client_calls == 0,                                                          "no ev_write after modify()");
+
+  char reply[64] = "back";
+  server.sendto (reply, 4, client.address_local);
+  reactor.run_once (1000);
+  CHECK (client_calls == 1 && client_events == reactor_t::ev_read,                  "ev_read after modify()");
+  char buf[16];
+  client.recv (buf, sizeof (buf));
+
+  reactor.modify (client, reactor_t::ev_read | reactor_t::ev_write);
+  client_calls = 0;
+  reactor.run_once (0);
+  CHECK (client_calls == 1 && client_events == reactor_t::ev_write,                 "modify() back to ev_read | ev_write");
+
+  // --- remove() ---
+
+  std::cout << "\n--- remove() ---\n";
+
+  CHECK (client.recv (buf, sizeof (buf)) == error_would_block,                      "registered socket does not block");
+  CHECK (reactor.remove (client) == no_error && !client.nonblocking,                "remove() restores blocking mode");
+  CHECK (client.recv (buf, sizeof (buf)) == error_timeout,                          "removed socket waits for SO_RCVTIMEO again");
+  CHECK (reactor.size () == 1,                                                       "size() counts registered sockets");
+
+  udp_client_t already (log_e::error);
+  already.open (ip_server, 100);
+  already.set_nonblocking (true);
+  reactor.add (already, reactor_t::ev_write, on_client);
+  reactor.remove (already);
+  CHECK (already.nonblocking,                                                        "a socket non-blocking before add() stays so");
+  reactor.remove (server);
+
+  // --- TCP accept, recv and peer close ---
+
+  std::cout << "\n--- TCP accept, recv and peer close ---\n";
+
+  {
+    tcp_server_t              listener (log_e::error);
+    tcp_client_t              peer (log_e::error);
+    std::vector<tcp_client_t> accepted;
+    std::string               data;
+    bool                      peer_closed = false;
+    listener.open (ip_server);
+
+    auto on_connection = [&] (uint32_t) {
+      char chunk[64];
+      int  res;
+      while ((res = accepted[0].recv (chunk, sizeof (chunk))) > 0)
+        data.append (chunk, res);
+      if (res == error_tcp_closed) {
+        peer_closed = true;
+        reactor.remove (accepted[0]); // a callback may remove its own socket
+      }
+    };
+    reactor.add (listener, reactor_t::ev_read, [&] (uint32_t) {
+      addr4_t from;
+      accepted.push_back (listener.accept (from));
+      reactor.add (accepted.back (), reactor_t::ev_read, on_connection);
+    });
+
+    peer.open (ip_server);
+    reactor.run_once (1000);
+    CHECK (accepted.size () == 1 && reactor.size () == 2,                           "listening socket reports a pending connection");
+
+    peer.send ("hello", 5);
+    reactor.run_once (1000);
+    CHECK (data == "hello",                                                          "accepted connection reports data");
+
+    peer.close ();
+    reactor.run_once (1000);
+    CHECK (peer_closed && reactor.size () == 1,                                      "peer close is reported and the socket removed");
+    reactor.remove (listener);
+  }
+
+  // --- run() and stop() ---
+
+  std::cout << "\n--- run() and stop() ---\n";
+
+  {
+    int calls = 0;
+    reactor.add (client, reactor_t::ev_write, [&] (uint32_t) {
+      if (++calls == 3)
+        reactor.stop ();
+    });
+    reactor.run (1000);
+    reactor.remove (client);
+    CHECK (calls == 3 && reactor.size () == 0,                                       "stop() from a callback ends run()");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -0,0 +1,222 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "tcp_framing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using tcp_server_t = tcp_socket_t<v4, socket_type_e::server>;
+using tcp_client_t = tcp_socket_t<v4, socket_type_e::client>;
+using clock_type   = std::chrono::steady_clock;
+
+static const addr4_t ip_server = "127.0.0.1:2010";
+
+// messages of different sizes, the last ones are bigger than the writer buffer (sent with one sendv, no copy)
+static std::vector<std::string> make_messages (std::size_t max_len) {
+  std::vector<std::string> messages;
+  for (std::size_t i = 0; i < 2000; i++)
+    messages.push_back (std::string (i % 300, (char)('a' + i % 26)));
+  messages.push_back (std::string ());
+  messages.push_back (std::string (max_len, 'x'));
+  messages.push_back (std::string (max_len / 2, 'y'));
+  return messages;
+}
+
+// sends messages through frame_writer_t and reads them back with frame_reader_t on an accepted connection
+static bool round_trip (const framing_t& framing, const std::vector<std::string>& messages) {
+
+  tcp_server_t server (log_e::error);
+  if (server.open (ip_server) != no_error)
+    return false;
+
+  std::thread sender ([&] () {
+    tcp_client_t client (log_e::error);
+    if (client.open (ip_server) != no_error)
+      return;
+    frame_writer_t<v4> writer (client, framing, 4096);
+    for (const std::string& msg : messages)
+      writer.write (msg.data (), (int)msg.size ());
+    writer.flush ();
+    std::this_thread::sleep_for (std::chrono::milliseconds (100)); // let the reader finish before close
+  });
+
+  addr4_t        from;
+  tcp_client_t   accepted = server.accept (from);
+  frame_reader_t<v4> reader (accepted, framing, frame_reader_t<v4>::default_max_frame, 1024);
+  frame_view_t   frame;
+  bool           same = true;
+  std::size_t    count = 0;
+  while (count < messages.size () && reader.read (frame) >= 0) {
+    same = same && std::string (frame.data, frame.size) == messages[count];
+    count++;
+  }
+  sender.join ();
+  return same && count == messages.size ();
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  TCP Message Framing Tests\n";
+  std::cout << "========================================\n\n";
+
+  // --- Length prefix encode/decode ---
+
+  std::cout << "--- Length prefix encode/decode ---\n";
+
+  char     header[framing_t::header_max];
+  uint32_t len = 0;
+
+  int n = framing_t::u16 ().encode (0x1234, header);
+  CHECK (n == 2 && (uint8_t)header[0] == 0x12 && (uint8_t)header[1] == 0x34, "u16 is big-endian");
+  CHECK (framing_t::u16 ().decode (header, 1, len) == 0,                          "u16 needs 2 bytes");
+
+  n = framing_t::u32 ().encode (0x01020304, header);
+  CHECK (n == 4 && framing_t::u32 ().decode (header, 4, len) == 4 && len == 0x01020304, "u32 round trip");
+
+  n = framing_t::varint ().encode (300, header);
+  CHECK (n == 2 && (uint8_t)header[0] == 0xac && (uint8_t)header[1] == 0x02,     "varint 300 = ac 02");
+  CHECK (framing_t::varint ().decode (header, 2, len) == 2 && len == 300,         "varint 300 decode");
+
+  n = framing_t::varint ().encode (0xffffffff, header);
+  CHECK (n == 5 && framing_t::varint ().decode (header, 5, len) == 5 && len == 0xffffffff, "varint max 32-bit round trip");
+  CHECK (framing_t::varint ().decode (header, 4, len) == 0,                       "varint needs all bytes");
+
+  const char too_long[]  = { '\x80', '\x80', '\x80', '\x80', '\x80', '\x01' };
+  const char too_big[]   = { '\x80', '\x80', '\x80', '\x80', '\x10' };
+  CHECK (framing_t::varint ().decode (too_long, sizeof (too_long), len) == -1,    "varint longer than 5 bytes is malformed");
+  CHECK (framing_t::varint ().decode (too_big,  sizeof (too_big),  len) == -1,    "varint above 32 bits is malformed");
+
+  // --- Round trip over loopback ---
+
+  std::cout << "\n--- Round trip over loopback ---\n";
+
+  std::vector<std::string> messages = make_messages (200000);
+  std::vector<std::string> short_messages = make_messages (60000);
+  std::vector<std::string> lines;
+  for (const std::string& msg : messages)
+    if (msg.find ('\n') == std::string::npos)
+      lines.push_back (msg);
+
+  CHECK (round_trip (framing_t::u16 (),         short_messages), "u16 framing");
+  CHECK (round_trip (framing_t::u32 (),         messages),       "u32 framing");
+  CHECK (round_trip (framing_t::varint (),      messages),       "varint framing");
+  CHECK (round_trip (framing_t::split ("\r\n"), lines),          "delimited framing (\\r\\n)");
+
+  // --- Writer backpressure ---
+
+  std::cout << "\n--- Writer backpressure ---\n";
+
+  {
+    tcp_server_t server (log_e::error);
+    server.open (ip_server);
+    tcp_client_t client (log_e::error);
+    socket_options_t options;
+    options.send_buffer = 16384;
+    client.open (ip_server, options);
+    addr4_t      from;
+    tcp_client_t accepted = server.accept (from); // never reads
+    client.set_nonblocking (true);
+
+    const std::size_t  flush_size = 8192;
+    frame_writer_t<v4> writer (client, framing_t::u32 (), flush_size);
+    std::string        msg (1000, 'm');
+    std::string        big (20000, 'b');
+    int                res = no_error;
+    std::size_t        max_pending = 0;
+    for (int i = 0; i < 100000 && res == no_error; i++) {
+      res = (i % 10 == 9) ? writer.write (big.data (), (int)big.size ()) : writer.write (msg.data (), (int)msg.size ());
+      max_pending = std::max (max_pending, writer.pending ());
+    }
+    CHECK (res == error_would_block,                       "write reports error_would_block when the socket is full");
+    CHECK (max_pending <= flush_size + big.size () + 4,    "buffer stays bounded");
+    CHECK (writer.write (msg.data (), (int)msg.size ()) == error_would_block, "refused again while nothing drains");
+  }
+
+  // --- Benchmark: frame_reader_t vs naive per-frame recv ---
+
+  std::cout << "\n--- Benchmark: 32-byte u32 frames over loopback ---\n";
+
+  const int   frames = 200000;
+  std::string payload (32, 'p');
+
+  for (int naive = 1; naive >= 0; naive--) {
+    tcp_server_t server (log_e::error);
+    server.open (ip_server);
+
+    std::thread sender ([&] () {
+      tcp_client_t client (log_e::error);
+      client.open (ip_server);
+      frame_writer_t<v4> writer (client, framing_t::u32 ());
+      for (int i = 0; i < frames; i++)
+        writer.write (payload.data (), (int)payload.size ());
+      writer.flush ();
+      std::this_thread::sleep_for (std::chrono::milliseconds (200));
+    });
+
+    addr4_t      from;
+    tcp_client_t accepted = server.accept (from);
+    int          received = 0;
+    clock_type::time_point start = clock_type::now ();
+
+    if (naive) {
+      // two recv() calls per frame: the length prefix, then the payload
+      char buf[256];
+      while (received < frames) {
+        int got = 0;
+        while (got < 4) {
+          int res = accepted.recv (buf + got, 4 - got);
+          if (res <= 0) break;
+          got += res;
+        }
+        uint32_t be;
+        memcpy (&be, buf, 4);
+        int size = (int)orders::ntohT<uint32_t> (be);
+        got = 0;
+        while (got < size) {
+          int res = accepted.recv (buf, size - got);
+          if (res <= 0) break;
+          got += res;
+        }
+        if (got != size) break;
+        received++;
+      }
+    }
+    else {
+      frame_reader_t<v4> reader (accepted, framing_t::u32 ());
+      frame_view_t       frame;
+      while (received < frames && reader.read (frame) >= 0)
+        received++;
+    }
+
+    double seconds = std::chrono::duration<double> (clock_type::now () - start).count ();
+    sender.join ();
+    printf ("  %-28s %d frames in %.1f ms, %.2f M frames/s\n",
+            naive ? "naive recv per frame:" : "frame_reader_t:", received, seconds * 1000, received / seconds / 1e6);
+    CHECK (received == frames, (naive ? "naive reader got all frames" : "frame_reader_t got all frames"));
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -0,0 +1,172 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "tcp_pool.h"
+
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using pool_t       = tcp_pool_t<v4>;
+using tcp_server_t = tcp_socket_t<v4, socket_type_e::server>;
+using tcp_client_t = tcp_socket_t<v4, socket_type_e::client>;
+
+static const addr4_t ip_server = "127.0.0.1:2019";
+
+// lets a FIN or data sent by the server reach the client side on loopback
+static void settle () {
+  std::this_thread::sleep_for (std::chrono::milliseconds (50));
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  TCP Connection Pool Tests\n";
+  std::cout << "========================================\n\n";
+
+  tcp_server_t server (log_e::error);
+  server.open (ip_server);
+
+  // server side of every connection the pools open, in connect order
+  std::vector<tcp_client_t> peers;
+  auto accept_peer = [&] () {
+    addr4_t from;
+    peers.push_back (server.accept (from));
+    return peers.size () - 1;
+  };
+
+  // --- Reuse ---
+
+  std::cout << "--- Reuse ---\n";
+
+  {
+    pool_t  pool;
+    int     err  = error_other;
+    addr4_t local;
+    {
+      pool_t::lease_t conn = pool.acquire (ip_server, &err);
+      CHECK (conn && err == no_error && !conn.reused (),                   "first acquire() connects");
+      local = conn->address_local;
+      accept_peer ();
+    }
+    CHECK (pool.idle (ip_server) == 1 && pool.total (ip_server) == 1,      "released connection is kept idle");
+    {
+      pool_t::lease_t conn = pool.acquire (ip_server, &err);
+      CHECK (conn && conn.reused () && conn->address_local == local,       "second acquire() reuses it");
+      CHECK (pool.idle (ip_server) == 0 && pool.total (ip_server) == 1,    "a leased connection is not idle");
+    }
+    CHECK (pool.stats ().connects == 1 && pool.stats ().reuses == 1,       "one connect, one reuse");
+  }
+
+  // --- Dead idle connections ---
+
+  std::cout << "\n--- Dead idle connections ---\n";
+
+  {
+    pool_t pool;
+    pool.acquire (ip_server);
+    size_t closing = accept_peer ();
+
+    peers[closing].close ();
+    settle ();
+    pool_t::lease_t conn = pool.acquire (ip_server);
+    CHECK (conn && !conn.reused () && pool.stats ().dead == 1,             "peer-closed connection is dropped, a new one opened");
+    size_t talking = accept_peer ();
+    conn.release ();
+
+    peers[talking].send ("late", 4);
+    settle ();
+    conn = pool.acquire (ip_server);
+    CHECK (conn && !conn.reused () && pool.stats ().dead == 2,             "connection with pending data is dropped");
+    CHECK (pool.total (ip_server) == 1,                                     "dropped connections leave the count");
+    accept_peer ();
+  }
+
+  // --- Limits ---
+
+  std::cout << "\n--- Limits ---\n";
+
+  {
+    pool_t::config_t config;
+    config.max_total = 2;
+    pool_t pool (config);
+    int    err = no_error;
+    pool_t::lease_t first  = pool.acquire (ip_server);
+    pool_t::lease_t second = pool.acquire (ip_server);
+    accept_peer ();
+    accept_peer ();
+    pool_t::lease_t third = pool.acquire (ip_server, &err);
+    CHECK (first && second && !third && err == error_would_block,          "max_total refuses a third connection");
+    CHECK (pool.stats ().rejected == 1,                                     "the refusal is counted");
+    first.release ();
+    third = pool.acquire (ip_server, &err);
+    CHECK (third && third.reused () && err == no_error,                    "a released connection makes room");
+  }
+
+  {
+    pool_t::config_t config;
+    config.max_idle = 1;
+    pool_t pool (config);
+    {
+      pool_t::lease_t leases[3] = { pool.acquire (ip_server), pool.acquire (ip_server), pool.acquire (ip_server) };
+      for (int i = 0; i < 3; i++)
+        accept_peer ();
+      CHECK (pool.total (ip_server) == 3,                                   "three leased connections");
+    }
+    CHECK (pool.idle (ip_server) == 1 && pool.total (ip_server) == 1,      "max_idle keeps one, closes the rest");
+    CHECK (pool.stats ().evicted == 2,                                      "closed extras are counted as evicted");
+
+    pool_t::lease_t conn = pool.acquire (ip_server);
+    conn.discard ();
+    CHECK (pool.idle (ip_server) == 0 && pool.total (ip_server) == 0,      "discard() closes instead of returning");
+
+    conn = pool.acquire (ip_server);
+    accept_peer ();
+    conn->set_nonblocking (true);
+    conn.release ();
+    CHECK (pool.idle (ip_server) == 0,                                      "a socket left non-blocking is not kept");
+  }
+
+  // --- Idle expiry ---
+
+  std::cout << "\n--- Idle expiry ---\n";
+
+  {
+    pool_t::config_t config;
+    config.idle_timeout_ms = 100;
+    pool_t pool (config);
+    pool.acquire (ip_server);
+    accept_peer ();
+    CHECK (pool.evict () == 0 && pool.idle (ip_server) == 1,               "a fresh idle connection survives evict()");
+    std::this_thread::sleep_for (std::chrono::milliseconds (150));
+    CHECK (pool.evict () == 1 && pool.total (ip_server) == 0,              "evict() closes it after idle_timeout_ms");
+
+    pool.acquire (ip_server);
+    accept_peer ();
+    std::this_thread::sleep_for (std::chrono::milliseconds (150));
+    pool_t::lease_t conn = pool.acquire (ip_server);
+    CHECK (conn && !conn.reused () && pool.stats ().evicted == 2,          "acquire() skips an expired connection");
+    CHECK (pool.stats ().connects == 3,                                     "and connects anew");
+    accept_peer ();
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
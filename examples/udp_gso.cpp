@@ -0,0 +1,184 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "udp_socket.h"
+#include "tcp_socket.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using udp_server_t = udp_socket_t<v4, socket_type_e::server>;
+using udp_client_t = udp_socket_t<v4, socket_type_e::client>;
+using clock_type   = std::chrono::steady_clock;
+
+static const addr4_t ip_server = "127.0.0.1:2011";
+
+// receives datagrams until the socket stays quiet for one receive timeout, returns their sizes
+static std::vector<int> recv_sizes (udp_server_t& server, std::string* data = nullptr) {
+  std::vector<int> sizes;
+  char             buf[65536];
+  addr4_t          from;
+  int              res;
+  while ((res = server.recvfrom (buf, sizeof (buf), from)) > 0) {
+    sizes.push_back (res);
+    if (data) data->append (buf, res);
+  }
+  return sizes;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  UDP Segmentation Offload Tests\n";
+  std::cout << "========================================\n\n";
+
+  std::string payload (60000, 0);
+  for (size_t i = 0; i < payload.size (); i++)
+    payload[i] = (char)(i * 7);
+
+  // --- Segmentation ---
+
+  std::cout << "--- Segmentation ---\n";
+
+  {
+    udp_server_t server (log_e::error);
+    server.open (ip_server, 100);
+    udp_client_t client (log_e::error);
+    udp_offload_t offload;
+    offload.gso_size = 1000;
+    CHECK (client.open (ip_server, offload) == no_error,                 "open with gso_size 1000");
+
+    std::string received;
+    client.send_gso (payload.data (), 10500);
+    std::vector<int> sizes = recv_sizes (server, &received);
+    CHECK (sizes.size () == 11 && sizes[0] == 1000 && sizes[10] == 500,   "10500 bytes arrive as 10 x 1000 + 500");
+    CHECK (received == payload.substr (0, 10500),                         "content in order");
+
+    client.send_gso (payload.data (), 3000, 1500);
+    sizes = recv_sizes (server);
+    CHECK (sizes.size () == 2 && sizes[0] == 1500,                        "per-call segment size");
+
+    offload.gso_size = 400;
+    CHECK (client.set_offload (offload) == no_error && client.offload.gso_size == 400, "set_offload() on an opened socket");
+    client.send_gso (payload.data (), 2000);
+    sizes = recv_sizes (server);
+    CHECK (sizes.size () == 5 && sizes[0] == 400,                         "send_gso() uses the new size");
+
+    client.offload.gso_size = 250; // written directly, the socket option is stale now
+    client.send_gso (payload.data (), 1000);
+    sizes = recv_sizes (server);
+    CHECK (sizes.size () == 4 && sizes[0] == 250,                         "segment size is passed with every call");
+
+    udp_client_t closed (log_e::none);
+    CHECK (closed.set_offload (offload) == error_closed_or_not_open,      "set_offload() on a closed socket");
+  }
+
+  // --- Receive coalescing ---
+
+  std::cout << "\n--- Receive coalescing ---\n";
+
+  {
+    udp_offload_t gro;
+    gro.gro = true;
+    udp_server_t server (log_e::error);
+    server.open (ip_server, gro, 100);
+    udp_client_t client (log_e::error);
+    client.open (ip_server);
+    client.send_gso (payload.data (), 8000, 1000);
+
+    char    buf[65536];
+    addr4_t from;
+    int     segment = 0, total = 0, calls = 0, res;
+    bool    sizes_ok = true;
+    while (total < 8000 && (res = server.recvfrom_gro (buf, sizeof (buf), from, segment)) > 0) {
+      sizes_ok = sizes_ok && segment == 1000 && res % 1000 == 0;
+      total += res;
+      calls++;
+    }
+    printf ("  8 datagrams of 1000 bytes received in %d call(s)\n", calls);
+    CHECK (total == 8000 && sizes_ok,                                     "recvfrom_gro() reports the segment size");
+  }
+
+  // --- TCP sockets ---
+
+  std::cout << "\n--- TCP sockets ---\n";
+
+  {
+    tcp_socket_t<v4, socket_type_e::server> server (log_e::none);
+    tcp_socket_t<v4, socket_type_e::client> client (log_e::none);
+    server.open (ip_server);
+    client.open (ip_server);
+    char    buf[16] = {};
+    addr4_t from;
+    int     segment = 0;
+    CHECK (client.state == state_e::opened,                               "tcp client connected");
+    CHECK (client.send_gso (buf, sizeof (buf), 8) == error_not_allowed,   "send_gso() on a TCP socket");
+    CHECK (client.sendto_gso (buf, sizeof (buf), ip_server, 8) == error_not_allowed, "sendto_gso() on a TCP socket");
+    CHECK (client.recvfrom_gro (buf, sizeof (buf), from, segment) == error_not_allowed, "recvfrom_gro() on a TCP socket");
+  }
+
+  // --- Benchmark: send_gso() vs plain send() ---
+
+  const int segment   = 1200;
+  const int per_call  = 50;                    // 60000 bytes per send_gso() call
+  const int datagrams = per_call * 4000;
+
+  std::cout << "\n--- Benchmark: " << datagrams << " datagrams of " << segment << " bytes over loopback ---\n";
+
+  for (int gso = 0; gso < 2; gso++) {
+    udp_server_t server (log_e::error);
+    socket_options_t options;
+    options.recv_buffer = 4 << 20;
+    server.open (ip_server, options, 200);
+
+    std::atomic<int> received { 0 };
+    std::thread receiver ([&] () {
+      char    buf[65536];
+      addr4_t from;
+      while (server.recvfrom (buf, sizeof (buf), from) > 0)
+        received++;
+    });
+
+    udp_client_t client (log_e::error);
+    client.open (ip_server);
+    int sent = 0;
+    clock_type::time_point start = clock_type::now ();
+    if (gso)
+      for (int i = 0; i < datagrams / per_call; i++)
+        sent += client.send_gso (payload.data (), segment * per_call, segment) > 0 ? per_call : 0;
+    else
+      for (int i = 0; i < datagrams; i++)
+        sent += client.send (payload.data (), segment) > 0 ? 1 : 0;
+    double seconds = std::chrono::duration<double> (clock_type::now () - start).count ();
+    receiver.join ();
+
+    // loopback drops datagrams when the receiver falls behind, so only the sender side is compared
+    printf ("  %-12s %.2f M datagrams/s sent (%.0f MB/s), %d of %d received\n",
+            gso ? "send_gso():" : "send():", sent / seconds / 1e6, sent * (double)segment / seconds / 1e6, received.load (), sent);
+    CHECK (sent == datagrams && received > 0, (gso ? "send_gso() sent everything" : "send() sent everything"));
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -0,0 +1,121 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "udp_socket.h"
+
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+
+// this file is built twice: with the configured IP_SOCKETS_CPP_LITE_LOG_LEVEL (ipsockets_udp_hot_path) and with
+// level 3 (ipsockets_udp_hot_path_nolog); run both and compare the per call overhead over the raw syscalls
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+using udp_server_t = udp_socket_t<v4, socket_type_e::server>;
+using udp_client_t = udp_socket_t<v4, socket_type_e::client>;
+using clock_type   = std::chrono::steady_clock;
+
+static const addr4_t ip_server = "127.0.0.1:2017";
+
+static const int rounds = 4000;
+static const int burst  = 50; // datagrams per round, well below the socket buffer
+
+struct timing_t {
+  double send_ns  = 0;
+  double recv_ns  = 0;
+  int    received = 0;
+};
+
+// 'burst' sends followed by 'burst' receives, repeated 'rounds' times; library == false calls the os directly
+static timing_t run (udp_client_t& client, udp_server_t& server, bool library) {
+  timing_t               timing;
+  char                   data[16] = "hot path";
+  char                   buf[64];
+  addr4_t                from;
+  clock_type::duration   send_time {}, recv_time {};
+  for (int round = 0; round < rounds; round++) {
+    clock_type::time_point start = clock_type::now ();
+    for (int i = 0; i < burst; i++)
+      library ? client.send (data, sizeof (data)) : (int)::send (client.sock, data, sizeof (data), 0);
+    clock_type::time_point middle = clock_type::now ();
+    for (int i = 0; i < burst; i++) {
+      int res = library ? server.recvfrom (buf, sizeof (buf), from) : (int)::recvfrom (server.sock, buf, sizeof (buf), 0, nullptr, nullptr);
+      timing.received += res == (int)sizeof (data);
+    }
+    send_time += middle - start;
+    recv_time += clock_type::now () - middle;
+  }
+  timing.send_ns = std::chrono::duration<double, std::nano> (send_time).count () / (rounds * burst);
+  timing.recv_ns = std::chrono::duration<double, std::nano> (recv_time).count () / (rounds * burst);
+  return timing;
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  UDP Hot Path (compiled log level " << IP_SOCKETS_CPP_LITE_LOG_LEVEL << ")\n";
+  std::cout << "========================================\n\n";
+
+  // --- Error codes without logging code ---
+
+  std::cout << "--- Error codes ---\n";
+
+  {
+    udp_client_t closed (log_e::debug); // prints only if the level allows it
+    char         buf[16] = {};
+    CHECK (closed.send (buf, sizeof (buf)) == error_closed_or_not_open, "send() on a closed socket");
+    CHECK ((int)compiled_log_level == IP_SOCKETS_CPP_LITE_LOG_LEVEL,     "compiled_log_level follows the macro");
+  }
+
+  // --- Benchmark ---
+
+  std::cout << "\n--- Benchmark: " << rounds * burst << " datagrams of 16 bytes over loopback ---\n";
+
+  {
+    udp_server_t server (log_e::error);
+    udp_client_t client (log_e::error);
+    server.open (ip_server, 1000);
+    client.open (ip_server, 1000);
+    char buf[16] = {};
+    CHECK (server.send (buf, sizeof (buf)) == error_not_allowed,        "send() on a server socket");
+
+    run (client, server, true); // warm up
+    timing_t os  = run (client, server, false);
+    timing_t lib = run (client, server, true);
+
+    printf ("  %-22s %8s %8s (ns/call)\n", "", "send", "recvfrom");
+    printf ("  %-22s %8.0f %8.0f\n", "raw syscalls",  os.send_ns,  os.recv_ns);
+    printf ("  %-22s %8.0f %8.0f\n", "udp_socket_t",  lib.send_ns, lib.recv_ns);
+    printf ("  %-22s %8.0f %8.0f\n", "library overhead", lib.send_ns - os.send_ns, lib.recv_ns - os.recv_ns);
+    CHECK (os.received == rounds * burst && lib.received == rounds * burst, "every datagram received");
+
+    // no syscall at all: only the state checks and the logging decision of the library are measured
+    udp_client_t           closed (log_e::none);
+    const int              calls  = 1000000;
+    int                    errors = 0;
+    clock_type::time_point start  = clock_type::now ();
+    for (int i = 0; i < calls; i++)
+      errors += closed.send (buf, sizeof (buf)) == error_closed_or_not_open;
+    double ns = std::chrono::duration<double, std::nano> (clock_type::now () - start).count () / calls;
+    printf ("  %-22s %8.1f (ns/call, error path without a syscall)\n", "send() on closed", ns);
+    CHECK (errors == calls,                                             "error code on every call");
+  }
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
@@ -0,0 +1,204 @@
+// my tiny header only crossplatform library for working with ip sockets
+#include "uring_engine.h"
+
+#include <cerrno>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ipsockets;
+
+#define CHECK(expr, name) \
+  do { \
+    bool ok = (expr); \
+    std::cout << (ok ? "[PASS] " : "[FAIL] ") << name << '\n'; \
+    if (!ok) failures++; \
+  } while(0)
+
+#ifdef IP_SOCKETS_HAS_IO_URING
+
+using tcp_server_t = tcp_socket_t<v4, socket_type_e::server>;
+using tcp_client_t = tcp_socket_t<v4, socket_type_e::client>;
+using engine_t     = uring_engine_t<v4>;
+using completion_t = engine_t::completion_t;
+using clock_type   = std::chrono::steady_clock;
+
+static const addr4_t ip_server = "127.0.0.1:2015";
+
+static const uint64_t tag_accept  = 1;
+static const uint64_t tag_connect = 2;
+static const uint64_t tag_single  = 3;
+static const uint64_t tag_recv    = 100; // + client number
+
+// reaps into 'all' until 'count' completions arrived or one second passed
+static void reap_some (engine_t& ring, std::vector<completion_t>& all, size_t count) {
+  completion_t           done[64];
+  clock_type::time_point deadline = clock_type::now () + std::chrono::seconds (1);
+  while (all.size () < count && clock_type::now () < deadline) {
+    int n = ring.reap (done, 64, 100);
+    for (int i = 0; i < n; i++)
+      all.push_back (done[i]);
+  }
+}
+
+int main () {
+
+  int failures = 0;
+
+  std::cout << "========================================\n";
+  std::cout << "  io_uring Engine Tests\n";
+  std::cout << "========================================\n\n";
+
+  engine_t ring;
+  if (ring.open () != no_error) {
+    std::cout << "[SKIP] io_uring is not available (kernel too old or disabled)\n";
+    return 0;
+  }
+
+  // --- Buffer groups ---
+
+  std::cout << "--- Buffer groups ---\n";
+
+  const int buffers = 8;
+  int group = ring.add_buffer_group (buffers, 256);
+  CHECK (group == 0,                                            "first buffer group has id 0");
+  CHECK (ring.add_buffer_group (3, 256) == error_not_allowed,  "buffer count must be a power of two");
+
+  tcp_server_t server (log_e::error);
+  server.open (ip_server);
+
+  // --- Multishot accept ---
+
+  std::cout << "\n--- Multishot accept ---\n";
+
+  const int                 clients_count = 3;
+  std::vector<tcp_client_t> clients;
+  std::vector<tcp_client_t> accepted;
+  std::vector<completion_t> all;
+
+  CHECK (ring.accept (server, tag_accept, true) == no_error,   "multishot accept queued");
+  for (int i = 0; i < clients_count; i++) {
+    clients.emplace_back (log_e::error);
+    clients.back ().open (ip_server);
+  }
+  reap_some (ring, all, clients_count);
+  bool accepts_ok = all.size () == clients_count;
+  for (const completion_t& done : all) {
+    accepts_ok = accepts_ok && done.tag == tag_accept && done.op == engine_t::op_accept && done.result >= 0 && done.more;
+    accepted.push_back (server.adopt (done.result));
+  }
+  CHECK (accepts_ok,                                            "one completion per connection, still armed");
+  CHECK (ring.in_flight () == 1,                                "the multishot accept stays in flight");
+
+  // --- Multishot recv with provided buffers ---
+
+  std::cout << "\n--- Multishot recv with provided buffers ---\n";
+
+  bool queued = true;
+  for (int i = 0; i < clients_count; i++)
+    queued = queued && ring.recv_group (accepted[i], 0, tag_recv + i, true) == no_error; // literal group 0 compiles
+  CHECK (queued,                                                "recv_group() queued on every connection");
+  CHECK (ring.recv_group (accepted[0], 5, tag_recv, true) == error_not_allowed, "unknown group is rejected");
+
+  // more messages than buffers: only works if release_buffer() gives them back
+  const int                messages = 4 * buffers;
+  std::vector<std::string> expected (clients_count), received (clients_count);
+  bool                     shots_ok = true;
+  int                      shots    = 0;
+  for (int m = 0; m < messages; m++) {
+    int         i   = m % clients_count;
+    std::string msg = "message " + std::to_string (m) + ";";
+    clients[i].send (msg.data (), (int)msg.size ());
+    expected[i] += msg;
+    all.clear ();
+    reap_some (ring, all, 1);
+    for (const completion_t& done : all) {
+      int from = (int)(done.tag - tag_recv);
+      shots_ok = shots_ok && done.op == engine_t::op_recv && done.result > 0 && done.more && done.buffer_group == group &&
+                 from >= 0 && from < clients_count;
+      if (shots_ok)
+        received[from].append (done.buf, done.result);
+      ring.release_buffer (done);
+      shots++;
+    }
+  }
+  CHECK (shots_ok && shots > buffers,                           "more recv shots than buffers in the group");
+  CHECK (received == expected,                                  "every byte arrives in order on its connection");
+
+  // --- Single-shot operations ---
+
+  std::cout << "\n--- Single-shot operations ---\n";
+
+  {
+    tcp_client_t extra (log_e::error);
+    CHECK (ring.connect (extra, ip_server, tag_connect) == no_error, "connect queued");
+    all.clear ();
+    reap_some (ring, all, 2); // the connect and the multishot accept shot of the new connection
+    bool connected = false;
+    for (const completion_t& done : all) {
+      if (done.tag == tag_connect)
+        connected = done.result == no_error && extra.state == state_e::opened && extra.address_remote == ip_server;
+      if (done.tag == tag_accept && done.result >= 0)
+        accepted.push_back (server.adopt (done.result));
+    }
+    CHECK (connected,                                           "connect completion opens the client");
+
+    const char text[] = "via ring";
+    char       buf[64] = {};
+    ring.send (extra, text, (int)sizeof (text), tag_single);
+    ring.recv (accepted.back (), buf, (int)sizeof (buf), tag_single + 1);
+    all.clear ();
+    reap_some (ring, all, 2);
+    bool sent = false, got = false;
+    for (const completion_t& done : all) {
+      sent = sent || (done.tag == tag_single     && done.result == (int)sizeof (text));
+      got  = got  || (done.tag == tag_single + 1 && done.result == (int)sizeof (text) && std::string (buf) == text);
+    }
+    CHECK (sent && got,                                         "single-shot send and recv into a caller buffer");
+  }
+
+  // --- Peer close and cancel ---
+
+  std::cout << "\n--- Peer close and cancel ---\n";
+
+  clients[0].close ();
+  all.clear ();
+  reap_some (ring, all, 1);
+  CHECK (all.size () == 1 && all[0].tag == tag_recv && all[0].result == error_tcp_closed && !all[0].more,
+         "peer close ends the multishot recv with error_tcp_closed");
+
+  int asked = ring.cancel (tag_accept);
+  for (int i = 1; i < clients_count; i++)
+    asked += ring.cancel (tag_recv + i);
+  CHECK (asked == clients_count,                                "cancel() asks every armed operation");
+  all.clear ();
+  reap_some (ring, all, clients_count);
+  bool cancelled = all.size () == clients_count;
+  for (const completion_t& done : all)
+    cancelled = cancelled && done.os_error == ECANCELED && !done.more;
+  CHECK (cancelled,                                             "cancelled operations complete with ECANCELED");
+  CHECK (ring.in_flight () == 0,                                "nothing left in flight");
+
+  ring.close ();
+  CHECK (!ring.is_open () && ring.cancel (tag_accept) == error_closed_or_not_open, "closed engine");
+
+  std::cout << "\n========================================\n";
+  if (failures == 0)
+    std::cout << "  All tests PASSED!\n";
+  else
+    std::cout << "  " << failures << " test(s) FAILED!\n";
+  std::cout << "========================================\n";
+
+  return failures;
+
+}
+
+#else
+
+int main () {
+  std::cout << "[SKIP] io_uring engine is only built on Linux with linux 6.0+ uapi headers\n";
+  return 0;
+}
+
+#endif
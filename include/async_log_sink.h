@@ -0,0 +1,217 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "udp_socket.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+namespace ipsockets {
+
+  // ============================================================
+  // async_log_sink_t — per-thread lock-free buffering, formatting on a background thread
+  // ============================================================
+
+  /// @brief Log sink that takes records off the I/O threads: write() only copies the record into a
+  ///   single-producer/single-consumer ring owned by the calling thread, a background flusher formats
+  ///   the records and writes them out in batches.
+  /// @details The first write() of a thread allocates its ring (under a mutex), every next write() is lock-free.
+  ///   When a ring is full the record is dropped and counted in dropped(), the I/O thread never waits.
+  ///   Messages of one thread keep their order; messages of different threads are not interleaved within a line.
+  ///
+  /// @code
+  ///   async_log_sink_t sink;                // formats to std::cout on its own thread
+  ///   set_log_sink (&sink);
+  ///   ...
+  ///   set_log_sink (nullptr);               // before the sink is destroyed
+  /// @endcode
+  struct async_log_sink_t : log_sink_t {
+
+    ///	@brief Starts the flusher thread.
+    ///	@param target            - Sink that receives records on the flusher thread, nullptr = format to std::cout. Default: nullptr.
+    ///	@param ring_size         - Records per producer thread, rounded up to a power of two. Default: 1024.
+    ///	@param flush_interval_ms - How long the flusher sleeps when all rings are empty. Default: 10.
+    async_log_sink_t (log_sink_t* target_ = nullptr, size_t ring_size_ = 1024, uint32_t flush_interval_ms = 10)
+      : target (target_), ring_size (_round_up (ring_size_)), interval (flush_interval_ms), id (_next_id ()) {
+      running = true;
+      flusher = std::thread (&async_log_sink_t::_run, this);
+    }
+
+    async_log_sink_t (const async_log_sink_t&) = delete;
+    async_log_sink_t& operator= (const async_log_sink_t&) = delete;
+
+    ~async_log_sink_t () {
+      stop ();
+    }
+
+    ///	@brief Queues a record in the ring of the calling thread; drops it if the ring is full.
+    void write (const log_record_t& record) override {
+      ring_t&  ring = _thread_ring ();
+      uint64_t tail = ring.tail.load (std::memory_order_relaxed);
+      if (tail - ring.head.load (std::memory_order_acquire) >= ring.records.size ()) {
+        dropped_count.fetch_add (1, std::memory_order_relaxed);
+        return;
+      }
+      ring.records[tail & (ring.records.size () - 1)] = record;
+      ring.tail.store (tail + 1, std::memory_order_release);
+    }
+
+    ///	@brief Waits until every record written before the call is passed to the output.
+    void flush () override {
+      std::unique_lock<std::mutex> lock (flush_mutex);
+      if (!running) {
+        lock.unlock ();
+        _drain ();
+        return;
+      }
+      // two complete passes guarantee that one pass started after this call
+      uint64_t target_pass = passes + 2;
+      flush_requested = true;
+      wake.notify_all ();
+      flushed.wait (lock, [&] { return passes >= target_pass || !running; });
+    }
+
+    ///	@brief Stops the flusher thread after writing out everything queued. Called by the destructor.
+    void stop () {
+      {
+        std::lock_guard<std::mutex> lock (flush_mutex);
+        if (!running) return;
+        running = false;
+      }
+      wake.notify_all ();
+      if (flusher.joinable ())
+        flusher.join ();
+      _drain ();
+      flushed.notify_all ();
+    }
+
+    uint64_t dropped () const { return dropped_count.load (std::memory_order_relaxed); } ///< @brief Returns the number of records lost because a ring was full.
+
+  protected:
+
+    struct ring_t {
+      explicit ring_t (size_t size) : records (size) {}
+      std::vector<log_record_t>          records;
+      alignas (64) std::atomic<uint64_t> head { 0 }; ///< Next record to read, written by the flusher
+      alignas (64) std::atomic<uint64_t> tail { 0 }; ///< Next record to write, written by the owner thread
+    };
+
+    log_sink_t*                          target;
+    const size_t                         ring_size;
+    const uint32_t                       interval;
+    const uint64_t                       id;         ///< Distinguishes sinks in the per-thread ring cache
+    std::atomic<uint64_t>                dropped_count { 0 };
+    std::mutex                           rings_mutex;
+    std::vector<std::shared_ptr<ring_t>> rings;      ///< Ring of every thread that wrote to this sink
+    std::mutex                           flush_mutex;
+    std::condition_variable              wake;       ///< Wakes the flusher (flush request or stop)
+    std::condition_variable              flushed;    ///< Signals a completed pass
+    uint64_t                             passes          = 0;
+    bool                                 flush_requested = false;
+    bool                                 running         = false;
+    std::thread                          flusher;
+    std::string                          batch;      ///< Formatted text of one pass (flusher thread only)
+
+    static size_t _round_up (size_t size) {
+      size_t result = 1;
+      while (result < size) result <<= 1;
+      return result;
+    }
+
+    static uint64_t _next_id () {
+      static std::atomic<uint64_t> counter { 0 };
+      return ++counter;
+    }
+
+    /// @brief Returns the ring of the calling thread, creating and registering it on first use.
+    /// @details The cache remembers one sink per thread; a thread switching between sinks registers a new ring,
+    ///   rings abandoned this way (or by finished threads) are released by the flusher once empty.
+    ring_t& _thread_ring () {
+      struct cache_t {
+        uint64_t                sink_id = 0;
+        std::shared_ptr<ring_t> ring;
+      };
+      thread_local cache_t cache;
+      if (cache.sink_id != id) {
+        std::shared_ptr<ring_t> ring = std::make_shared<ring_t> (ring_size);
+        {
+          std::lock_guard<std::mutex> lock (rings_mutex);
+          rings.push_back (ring);
+        }
+        cache.sink_id = id;
+        cache.ring    = ring;
+      }
+      return *cache.ring;
+    }
+
+    /// @brief Moves every queued record to the output.
+    /// @return Number of records written.
+    size_t _drain () {
+
+      std::vector<std::shared_ptr<ring_t>> snapshot;
+      {
+        std::lock_guard<std::mutex> lock (rings_mutex);
+        snapshot = rings;
+      }
+
+      size_t count = 0;
+      batch.clear ();
+      for (std::shared_ptr<ring_t>& ring : snapshot) {
+        uint64_t head = ring->head.load (std::memory_order_relaxed);
+        uint64_t tail = ring->tail.load (std::memory_order_acquire);
+        for (; head != tail; head++, count++) {
+          const log_record_t& record = ring->records[head & (ring->records.size () - 1)];
+          if (target) target->write (record);
+          else        format_log_record (record, batch);
+        }
+        ring->head.store (head, std::memory_order_release);
+      }
+
+      if (!batch.empty ()) {
+        std::cout.write (batch.data (), (std::streamsize)batch.size ());
+        std::cout.flush ();
+      }
+      if (target && count > 0)
+        target->flush ();
+
+      // release rings nobody writes to anymore: owner thread finished or switched to another sink
+      snapshot.clear ();
+      std::lock_guard<std::mutex> lock (rings_mutex);
+      for (size_t i = 0; i < rings.size (); )
+        if (rings[i].use_count () == 1 && rings[i]->head.load () == rings[i]->tail.load ())
+          rings.erase (rings.begin () + i);
+        else
+          i++;
+
+      return count;
+    }
+
+    void _run () {
+      std::unique_lock<std::mutex> lock (flush_mutex);
+      while (running) {
+        lock.unlock ();
+        size_t count = _drain ();
+        lock.lock ();
+        passes++;
+        flushed.notify_all ();
+        if (count == 0 && !flush_requested)
+          wake.wait_for (lock, std::chrono::milliseconds (interval));
+        flush_requested = false;
+      }
+    }
+
+  };
+
+} // namespace ipsockets
@@ -0,0 +1,366 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_address.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional> // std::hash
+#include <memory>
+#include <new>
+#include <utility>
+
+// control bytes are scanned 16 at a time with SSE2 (always present on x86-64)
+// define IP_SOCKETS_NO_SIMD before including this header to use the portable loop
+#if !defined(IP_SOCKETS_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+  #include <emmintrin.h>
+  #define IP_SOCKETS_HAS_SSE2_PROBE 1
+#endif
+
+namespace ipsockets {
+
+  // ============================================================
+  // addr_map_t — flat open-addressing hash map for address keys (SIMD-probed control bytes)
+  // ============================================================
+
+  /// @brief Hash map from addresses (addr4_t, addr6_t, ip4_t, ip6_t, ...) to values, stored in one flat array.
+  /// @details Every slot has a control byte holding 7 bits of the key hash, or the empty / deleted mark.
+  ///   A lookup compares the 16 control bytes of a group with one SSE2 instruction and checks only the slots
+  ///   whose tag matches, so it usually touches one control group and one slot. Keys and values live inline
+  ///   in the slot array, nothing is allocated per element. The table doubles at 7/8 load.
+  ///   Hash must mix well in all bits: the std::hash specializations of the address types use hashing::mix().
+  ///   Value pointers stay valid until an insertion grows the table, or clear().
+  ///   Not thread-safe for writes; concurrent lookups without writers are safe.
+  ///
+  /// @code
+  ///   addr_map_t<addr4_t, peer_t> peers;
+  ///   peers[from].packets++;
+  ///   if (peer_t* peer = peers.find (from)) ...
+  ///   peers.erase (from);
+  /// @endcode
+  template <class Key, class Value, class Hash = std::hash<Key>>
+  struct addr_map_t {
+
+    static const size_t group_size = 16;
+
+    addr_map_t () = default;
+
+    addr_map_t (const addr_map_t& other) {
+      _copy (other);
+    }
+
+    addr_map_t (addr_map_t&& other) noexcept {
+      _take (other);
+    }
+
+    addr_map_t& operator= (const addr_map_t& other) {
+      if (this != &other) {
+        addr_map_t copy (other);
+        _destroy ();
+        _take (copy);
+      }
+      return *this;
+    }
+
+    addr_map_t& operator= (addr_map_t&& other) noexcept {
+      if (this != &other) {
+        _destroy ();
+        _take (other);
+      }
+      return *this;
+    }
+
+    ~addr_map_t () {
+      _destroy ();
+    }
+
+    ///	@brief Returns the value stored for the key, or nullptr.
+    Value* find (const Key& key) {
+      size_t index = _find (key, _hash (key));
+      return (index != npos) ? &_slot (index)->value : nullptr;
+    }
+
+    ///	@brief Returns the value stored for the key, or nullptr.
+    const Value* find (const Key& key) const {
+      size_t index = _find (key, _hash (key));
+      return (index != npos) ? &_slot (index)->value : nullptr;
+    }
+
+    bool contains (const Key& key) const { return find (key) != nullptr; } ///< @brief Returns true if the key is stored.
+
+    ///	@brief Adds the key with a value constructed from args, if the key is not stored yet.
+    ///	@return Pointer to the stored value and true if it was added, false if the key already existed (value untouched).
+    template <class... Args>
+    std::pair<Value*, bool> emplace (const Key& key, Args&&... args) {
+
+      uint64_t hash  = _hash (key);
+      size_t   index = _find (key, hash);
+      if (index != npos)
+        return std::pair<Value*, bool> (&_slot (index)->value, false);
+
+      if (growth_left == 0) {
+        if (groups == 0)                             _rehash (1);
+        else if (count * 2 <= capacity () * 7 / 8)   _rehash (groups);     // mostly tombstones: clean up in place
+        else                                         _rehash (groups * 2);
+      }
+
+      index = _find_free (hash);
+      ::new (&slots[index]) slot_t (key, std::forward<Args> (args)...);
+      if (ctrl[index] == ctrl_empty)
+        growth_left--;
+      ctrl[index] = (ctrl_t)(hash & 0x7f);
+      count++;
+      return std::pair<Value*, bool> (&_slot (index)->value, true);
+    }
+
+    ///	@brief Adds the key or replaces its value.
+    ///	@return true if the key was added, false if its value was replaced.
+    bool insert (const Key& key, const Value& value) {
+      std::pair<Value*, bool> result = emplace (key, value);
+      if (!result.second)
+        *result.first = value;
+      return result.second;
+    }
+
+    ///	@brief Returns the value of the key, adding a value-initialized one if the key is not stored.
+    Value& operator[] (const Key& key) {
+      return *emplace (key).first;
+    }
+
+    ///	@brief Removes the key.
+    ///	@return true if the key was present.
+    bool erase (const Key& key) {
+
+      size_t index = _find (key, _hash (key));
+      if (index == npos)
+        return false;
+
+      _slot (index)->~slot_t ();
+      count--;
+
+      // no probe ever went past a group that still has an empty slot, so the slot can become empty again
+      if (_match_empty (&ctrl[index & ~(group_size - 1)])) {
+        ctrl[index] = ctrl_empty;
+        growth_left++;
+      }
+      else
+        ctrl[index] = ctrl_deleted;
+      return true;
+    }
+
+    ///	@brief Calls fn (const Key&, Value&) for every stored key, in no particular order.
+    template <class Fn>
+    void for_each (Fn fn) {
+      for (size_t i = 0; i < capacity (); i++)
+        if (ctrl[i] >= 0)
+          fn ((const Key&)_slot (i)->key, _slot (i)->value);
+    }
+
+    ///	@brief Calls fn (const Key&, const Value&) for every stored key, in no particular order.
+    template <class Fn>
+    void for_each (Fn fn) const {
+      for (size_t i = 0; i < capacity (); i++)
+        if (ctrl[i] >= 0)
+          fn ((const Key&)_slot (i)->key, (const Value&)_slot (i)->value);
+    }
+
+    ///	@brief Removes all keys, keeps the allocated slots.
+    void clear () {
+      for (size_t i = 0; i < capacity (); i++)
+        if (ctrl[i] >= 0)
+          _slot (i)->~slot_t ();
+      if (groups)
+        std::memset (ctrl.get (), (uint8_t)ctrl_empty, capacity ());
+      count       = 0;
+      growth_left = capacity () * 7 / 8;
+    }
+
+    ///	@brief Allocates slots for at least 'size' keys without further growth.
+    void reserve (size_t size) {
+      size_t needed = 1;
+      while (needed * group_size * 7 / 8 < size)
+        needed *= 2;
+      if (needed > groups)
+        _rehash (needed);
+    }
+
+    size_t size ()     const { return count; }               ///< @brief Returns the number of stored keys.
+    bool   empty ()    const { return count == 0; }          ///< @brief Returns true if no keys are stored.
+    size_t capacity () const { return groups * group_size; } ///< @brief Returns the number of slots.
+
+  protected:
+
+    using ctrl_t = int8_t;
+
+    static const ctrl_t ctrl_empty   = -128; ///< Never used since the last rehash; stops probing
+    static const ctrl_t ctrl_deleted = -2;   ///< Erased; probing continues past it
+    static const size_t npos         = ~(size_t)0;
+
+    struct slot_t {
+      Key   key;
+      Value value;
+
+      template <class... Args>
+      slot_t (const Key& key_, Args&&... args) : key (key_), value (std::forward<Args> (args)...) {}
+    };
+
+    struct storage_t {
+      alignas (slot_t) unsigned char bytes[sizeof (slot_t)];
+    };
+
+    std::unique_ptr<ctrl_t[]>    ctrl;            ///< One control byte per slot: 0..127 = hash tag of a full slot
+    std::unique_ptr<storage_t[]> slots;           ///< Raw slot storage, constructed where ctrl >= 0
+    size_t                       groups      = 0; ///< Number of 16-slot groups, a power of two
+    size_t                       count       = 0; ///< Stored keys
+    size_t                       growth_left = 0; ///< Empty slots that may still be filled before a rehash
+
+    slot_t*       _slot (size_t index)       { return reinterpret_cast<slot_t*> (&slots[index]); }
+    const slot_t* _slot (size_t index) const { return reinterpret_cast<const slot_t*> (&slots[index]); }
+
+    static uint64_t _hash (const Key& key) { return (uint64_t)Hash {}(key); }
+
+    /// @brief Returns bit i set for every byte i of the group equal to tag.
+    static uint32_t _match (const ctrl_t* group, ctrl_t tag) {
+      #ifdef IP_SOCKETS_HAS_SSE2_PROBE
+        __m128i bytes = _mm_loadu_si128 ((const __m128i*)group);
+        return (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (bytes, _mm_set1_epi8 (tag)));
+      #else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_size; i++)
+          mask |= (uint32_t)(group[i] == tag) << i;
+        return mask;
+      #endif
+    }
+
+    /// @brief Returns bit i set for every empty or deleted byte i of the group (both have the sign bit).
+    static uint32_t _match_free (const ctrl_t* group) {
+      #ifdef IP_SOCKETS_HAS_SSE2_PROBE
+        return (uint32_t)_mm_movemask_epi8 (_mm_loadu_si128 ((const __m128i*)group));
+      #else
+        uint32_t mask = 0;
+        for (size_t i = 0; i < group_size; i++)
+          mask |= (uint32_t)(group[i] < 0) << i;
+        return mask;
+      #endif
+    }
+
+    static uint32_t _match_empty (const ctrl_t* group) { return _match (group, ctrl_empty); }
+
+    /// @brief Returns the slot index of the key, or npos. Groups are probed quadratically (1, 2, 3, ... groups apart).
+    size_t _find (const Key& key, uint64_t hash) const {
+      if (groups == 0)
+        return npos;
+      const ctrl_t tag   = (ctrl_t)(hash & 0x7f);
+      const size_t mask  = groups - 1;
+      size_t       group = (size_t)(hash >> 7) & mask;
+      for (size_t step = 1; ; step++) {
+        const ctrl_t* bytes = &ctrl[group * group_size];
+        for (uint32_t bits = _match (bytes, tag); bits != 0; bits &= bits - 1) {
+          size_t index = group * group_size + (size_t)countr_zero (bits);
+          if (_slot (index)->key == key)
+            return index;
+        }
+        if (_match_empty (bytes) != 0 || step > groups)
+          return npos;
+        group = (group + step) & mask;
+      }
+    }
+
+    /// @brief Returns the first empty or deleted slot on the probe sequence of the hash (one always exists).
+    size_t _find_free (uint64_t hash) const {
+      const size_t mask  = groups - 1;
+      size_t       group = (size_t)(hash >> 7) & mask;
+      for (size_t step = 1; ; step++) {
+        uint32_t bits = _match_free (&ctrl[group * group_size]);
+        if (bits != 0)
+          return group * group_size + (size_t)countr_zero (bits);
+        group = (group + step) & mask;
+      }
+    }
+
+    /// @brief Moves all keys into a table of new_groups groups, dropping tombstones.
+    void _rehash (size_t new_groups) {
+
+      std::unique_ptr<ctrl_t[]>    old_ctrl   = std::move (ctrl);
+      std::unique_ptr<storage_t[]> old_slots  = std::move (slots);
+      size_t                       old_groups = groups;
+
+      groups = new_groups;
+      ctrl.reset (new ctrl_t[capacity ()]);
+      slots.reset (new storage_t[capacity ()]);
+      std::memset (ctrl.get (), (uint8_t)ctrl_empty, capacity ());
+
+      for (size_t i = 0; i < old_groups * group_size; i++) {
+        if (old_ctrl[i] < 0)
+          continue;
+        slot_t*  old   = reinterpret_cast<slot_t*> (&old_slots[i]);
+        uint64_t hash  = _hash (old->key);
+        size_t   index = _find_free (hash);
+        ::new (&slots[index]) slot_t (old->key, std::move (old->value));
+        ctrl[index] = (ctrl_t)(hash & 0x7f);
+        old->~slot_t ();
+      }
+      growth_left = capacity () * 7 / 8 - count;
+    }
+
+    void _copy (const addr_map_t& other) {
+      if (other.groups == 0)
+        return;
+      groups = other.groups;
+      ctrl.reset (new ctrl_t[capacity ()]);
+      slots.reset (new storage_t[capacity ()]);
+      std::memcpy (ctrl.get (), other.ctrl.get (), capacity ());
+      for (size_t i = 0; i < capacity (); i++) {
+        if (ctrl[i] < 0)
+          continue;
+        try {
+          ::new (&slots[i]) slot_t (other._slot (i)->key, other._slot (i)->value);
+        }
+        catch (...) {
+          for (size_t j = 0; j < i; j++)
+            if (ctrl[j] >= 0)
+              _slot (j)->~slot_t ();
+          ctrl.reset ();
+          slots.reset ();
+          groups = 0;
+          throw;
+        }
+      }
+      count       = other.count;
+      growth_left = other.growth_left;
+    }
+
+    void _take (addr_map_t& other) {
+      ctrl        = std::move (other.ctrl);
+      slots       = std::move (other.slots);
+      groups      = other.groups;
+      count       = other.count;
+      growth_left = other.growth_left;
+      other.groups      = 0;
+      other.count       = 0;
+      other.growth_left = 0;
+    }
+
+    void _destroy () {
+      for (size_t i = 0; i < capacity (); i++)
+        if (ctrl[i] >= 0)
+          _slot (i)->~slot_t ();
+      ctrl.reset ();
+      slots.reset ();
+      groups      = 0;
+      count       = 0;
+      growth_left = 0;
+    }
+
+  };
+
+} // namespace ipsockets
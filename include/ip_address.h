@@ -69,6 +69,7 @@ namespace orders {
 #include <iostream>
 #include <string>
 #include <cassert>
+#include <cstring>     // std::memcpy
 #include <algorithm>   // std::copy_n
 #include <functional>  // std::hash
 
@@ -101,6 +102,277 @@ namespace orders {
 
 namespace ipsockets {
 
+  // ============================================================
+  // chars — allocation-free text output shared by the to_chars() methods
+  // ============================================================
+
+  namespace chars {
+
+    /// @brief Decimal text of every byte value, 4 bytes per value: [length, digit, digit, digit].
+    /// @details Built once on first use; afterwards a byte is formatted with one table load and a 3 byte copy.
+    inline const char* octet_table () {
+      struct table_t {
+        char data[256][4];
+        table_t () {
+          for (int value = 0; value < 256; value++) {
+            char* entry = data[value];
+            if      (value >= 100) { entry[0] = 3; entry[1] = char ('0' + value / 100); entry[2] = char ('0' + value / 10 % 10); entry[3] = char ('0' + value % 10); }
+            else if (value >= 10)  { entry[0] = 2; entry[1] = char ('0' + value / 10);  entry[2] = char ('0' + value % 10);      entry[3] = '0'; }
+            else                   { entry[0] = 1; entry[1] = char ('0' + value);       entry[2] = '0';                          entry[3] = '0'; }
+          }
+        }
+      };
+      static const table_t table;
+      return table.data[0];
+    }
+
+    /// @brief Writes a byte value in decimal without leading zeros.
+    /// @warning Always stores 3 characters, the caller must have room for them; returns the end of the significant ones.
+    inline char* put_octet (char* out, uint8_t value) {
+      const char* entry = octet_table () + value * 4;
+      std::memcpy (out, entry + 1, 3);
+      return out + entry[0];
+    }
+
+    /// @brief Writes a 16-bit value (port number) in decimal without leading zeros, at most 5 characters.
+    inline char* put_u16 (char* out, uint16_t value) {
+      char  reversed[5];
+      char* end = reversed;
+      do {
+        *end++ = char ('0' + value % 10);
+        value /= 10;
+      } while (value != 0);
+      while (end != reversed)
+        *out++ = *--end;
+      return out;
+    }
+
+    /// @brief Runs writer(out) into [first, last) if the range can hold Max characters, otherwise into a local
+    ///   buffer and copies the result only if it fits.
+    /// @return End of the written text, or nullptr if [first, last) is too small.
+    template <size_t Max, class Writer>
+    inline char* checked (char* first, char* last, Writer writer) {
+      if (first == nullptr || last < first)
+        return nullptr;
+      if ((size_t)(last - first) >= Max)
+        return writer (first);
+      char   buffer[Max];
+      size_t size = (size_t)(writer (buffer) - buffer);
+      if (size > (size_t)(last - first))
+        return nullptr;
+      std::memcpy (first, buffer, size);
+      return first + size;
+    }
+
+  } // namespace chars
+
+  // ============================================================
+  // u128_t — 128-bit unsigned number for ipv6 address arithmetic
+  // ============================================================
+
+  // unsigned __int128 is used where the compiler provides it, two uint64_t words otherwise
+  // define IP_SOCKETS_NO_INT128 before including this header to force the two-word form
+  #if defined(__SIZEOF_INT128__) && !defined(IP_SOCKETS_NO_INT128)
+    #define IP_SOCKETS_HAS_INT128 1
+  #endif
+
+  /// @brief Unsigned 128-bit integer with wrap-around arithmetic, bitwise operations, shifts and comparisons.
+  /// @details Numeric view of an ipv6 address (ip6_t::to_number()), host byte order.
+  struct u128_t {
+
+    #ifdef IP_SOCKETS_HAS_INT128
+      __extension__ typedef unsigned __int128 native_t;
+    #endif
+
+    u128_t () = default;
+
+    u128_t (uint64_t low_) {
+      #ifdef IP_SOCKETS_HAS_INT128
+        value = low_;
+      #else
+        hi = 0;
+        lo = low_;
+      #endif
+    }
+
+    u128_t (uint64_t high_, uint64_t low_) {
+      #ifdef IP_SOCKETS_HAS_INT128
+        value = ((native_t)high_ << 64) | low_;
+      #else
+        hi = high_;
+        lo = low_;
+      #endif
+    }
+
+    #ifdef IP_SOCKETS_HAS_INT128
+      uint64_t high () const { return (uint64_t)(value >> 64); } ///< @brief Returns bits 127..64.
+      uint64_t low  () const { return (uint64_t)value; }         ///< @brief Returns bits 63..0.
+    #else
+      uint64_t high () const { return hi; } ///< @brief Returns bits 127..64.
+      uint64_t low  () const { return lo; } ///< @brief Returns bits 63..0.
+    #endif
+
+    explicit operator bool () const { return (high () | low ()) != 0; }
+
+    /// @brief Returns the number of trailing zero bits, 128 for zero.
+    int countr_zero () const {
+      uint64_t l = low (), h = high ();
+      if (l != 0) return _ctz64 (l);
+      if (h != 0) return 64 + _ctz64 (h);
+      return 128;
+    }
+
+    /// @brief Returns the number of bits needed to represent the value (0 for zero), i.e. floor(log2) + 1.
+    int bit_width () const {
+      uint64_t l = low (), h = high ();
+      if (h != 0) return 128 - _clz64 (h);
+      if (l != 0) return 64 - _clz64 (l);
+      return 0;
+    }
+
+    #ifdef IP_SOCKETS_HAS_INT128
+
+      friend u128_t operator+ (const u128_t& a, const u128_t& b) { return _make (a.value + b.value); }
+      friend u128_t operator- (const u128_t& a, const u128_t& b) { return _make (a.value - b.value); }
+      friend u128_t operator& (const u128_t& a, const u128_t& b) { return _make (a.value & b.value); }
+      friend u128_t operator| (const u128_t& a, const u128_t& b) { return _make (a.value | b.value); }
+      friend u128_t operator^ (const u128_t& a, const u128_t& b) { return _make (a.value ^ b.value); }
+      u128_t operator~ () const { return _make (~value); }
+      u128_t operator<< (int shift) const { return (shift <= 0) ? *this : (shift >= 128) ? u128_t (0) : _make (value << shift); }
+      u128_t operator>> (int shift) const { return (shift <= 0) ? *this : (shift >= 128) ? u128_t (0) : _make (value >> shift); }
+      friend bool operator== (const u128_t& a, const u128_t& b) { return a.value == b.value; }
+      friend bool operator<  (const u128_t& a, const u128_t& b) { return a.value <  b.value; }
+
+    #else
+
+      friend u128_t operator+ (const u128_t& a, const u128_t& b) {
+        uint64_t l = a.lo + b.lo;
+        return u128_t (a.hi + b.hi + (l < a.lo ? 1 : 0), l);
+      }
+      friend u128_t operator- (const u128_t& a, const u128_t& b) {
+        return u128_t (a.hi - b.hi - (a.lo < b.lo ? 1 : 0), a.lo - b.lo);
+      }
+      friend u128_t operator& (const u128_t& a, const u128_t& b) { return u128_t (a.hi & b.hi, a.lo & b.lo); }
+      friend u128_t operator| (const u128_t& a, const u128_t& b) { return u128_t (a.hi | b.hi, a.lo | b.lo); }
+      friend u128_t operator^ (const u128_t& a, const u128_t& b) { return u128_t (a.hi ^ b.hi, a.lo ^ b.lo); }
+      u128_t operator~ () const { return u128_t (~hi, ~lo); }
+      u128_t operator<< (int shift) const {
+        if (shift <= 0)  return *this;
+        if (shift >= 128) return u128_t (0);
+        if (shift >= 64)  return u128_t (lo << (shift - 64), 0);
+        return u128_t ((hi << shift) | (lo >> (64 - shift)), lo << shift);
+      }
+      u128_t operator>> (int shift) const {
+        if (shift <= 0)  return *this;
+        if (shift >= 128) return u128_t (0);
+        if (shift >= 64)  return u128_t (0, hi >> (shift - 64));
+        return u128_t (hi >> shift, (lo >> shift) | (hi << (64 - shift)));
+      }
+      friend bool operator== (const u128_t& a, const u128_t& b) { return a.hi == b.hi && a.lo == b.lo; }
+      friend bool operator<  (const u128_t& a, const u128_t& b) { return a.hi < b.hi || (a.hi == b.hi && a.lo < b.lo); }
+
+    #endif
+
+    friend bool operator!= (const u128_t& a, const u128_t& b) { return !(a == b); }
+    friend bool operator>  (const u128_t& a, const u128_t& b) { return b < a; }
+    friend bool operator<= (const u128_t& a, const u128_t& b) { return !(b < a); }
+    friend bool operator>= (const u128_t& a, const u128_t& b) { return !(a < b); }
+
+    u128_t& operator+=  (const u128_t& other) { return *this = *this + other; }
+    u128_t& operator-=  (const u128_t& other) { return *this = *this - other; }
+    u128_t& operator&=  (const u128_t& other) { return *this = *this & other; }
+    u128_t& operator|=  (const u128_t& other) { return *this = *this | other; }
+    u128_t& operator^=  (const u128_t& other) { return *this = *this ^ other; }
+    u128_t& operator<<= (int shift)           { return *this = *this << shift; }
+    u128_t& operator>>= (int shift)           { return *this = *this >> shift; }
+    u128_t& operator++ ()                     { return *this = *this + u128_t (1); }
+    u128_t& operator-- ()                     { return *this = *this - u128_t (1); }
+    u128_t  operator++ (int)                  { u128_t old = *this; ++*this; return old; }
+    u128_t  operator-- (int)                  { u128_t old = *this; --*this; return old; }
+
+  private:
+
+    #ifdef IP_SOCKETS_HAS_INT128
+      native_t value;
+      static u128_t _make (native_t v) { u128_t result; result.value = v; return result; }
+    #else
+      uint64_t hi;
+      uint64_t lo;
+    #endif
+
+    static int _ctz64 (uint64_t v) { // v != 0
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_ctzll (v);
+      #else
+        int n = 0;
+        while ((v & 1) == 0) { v >>= 1; n++; }
+        return n;
+      #endif
+    }
+
+    static int _clz64 (uint64_t v) { // v != 0
+      #if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll (v);
+      #else
+        int n = 0;
+        while ((v & 0x8000000000000000ull) == 0) { v <<= 1; n++; }
+        return n;
+      #endif
+    }
+  };
+
+  /// @brief Returns the number of trailing zero bits of a 32-bit value, 32 for zero (mirror of u128_t::countr_zero()).
+  inline int countr_zero (uint32_t value) {
+    if (value == 0) return 32;
+    #if defined(__GNUC__) || defined(__clang__)
+      return __builtin_ctz (value);
+    #else
+      int n = 0;
+      while ((value & 1) == 0) { value >>= 1; n++; }
+      return n;
+    #endif
+  }
+
+  /// @brief Returns the number of bits needed to represent a 32-bit value, 0 for zero (mirror of u128_t::bit_width()).
+  inline int bit_width (uint32_t value) {
+    if (value == 0) return 0;
+    #if defined(__GNUC__) || defined(__clang__)
+      return 32 - __builtin_clz (value);
+    #else
+      int n = 0;
+      while (value != 0) { value >>= 1; n++; }
+      return n;
+    #endif
+  }
+
+  inline int countr_zero (const u128_t& value) { return value.countr_zero (); } ///< @brief Same as u128_t::countr_zero().
+  inline int bit_width   (const u128_t& value) { return value.bit_width (); }   ///< @brief Same as u128_t::bit_width().
+
+  // ============================================================
+  // hashing — bit mixing for address hashes (std::hash specializations, addr_map_t)
+  // ============================================================
+
+  namespace hashing {
+
+    /// @brief Mixes all 64 input bits into all output bits (two multiply-xorshift rounds).
+    /// @details Sequential addresses and ports (NAT pools, one subnet) give unrelated hashes, so both the low bits
+    ///   used by bucket tables and the high bits used by open-addressing tags are evenly distributed.
+    inline uint64_t mix (uint64_t value) {
+      value ^= value >> 32;
+      value *= 0xd6e8feb86659fd93ull;
+      value ^= value >> 32;
+      value *= 0xd6e8feb86659fd93ull;
+      value ^= value >> 32;
+      return value;
+    }
+
+    /// @brief Mixes two 64-bit words (e.g. the halves of an ipv6 address).
+    inline uint64_t mix (uint64_t first, uint64_t second) {
+      return mix (first ^ mix (second + 0x9e3779b97f4a7c15ull));
+    }
+
+  } // namespace hashing
+
   struct ip4_t : public std::array<uint8_t, 4> {
     /// @brief Parses a text string with an IP address according to the rules.
     /// The string can contain from one to four numbers separated by dots.
@@ -289,15 +561,51 @@ namespace ipsockets {
       *((uint32_t*)this) &= *((uint32_t*)&other);
     }
 
+    // ===== numeric operations (address as host order uint32_t, wrap-around) =====
+
+    /// @brief Returns the address as a number, same as the uint32_t conversion.
+    uint32_t to_number () const { return (uint32_t)*this; }
+
+    ip4_t next () const { return ip4_t ((uint32_t)(to_number () + 1)); } ///< @brief Returns the following address (255.255.255.255 wraps to 0.0.0.0).
+    ip4_t prev () const { return ip4_t ((uint32_t)(to_number () - 1)); } ///< @brief Returns the preceding address (0.0.0.0 wraps to 255.255.255.255).
+
+    /// @brief Returns the number of steps from this address to 'other' (other - this, wrap-around).
+    uint32_t distance (const ip4_t& other) const { return other.to_number () - to_number (); }
+
+    template <class N, typename std::enable_if<std::is_integral<N>::value, int>::type = 0>
+    ip4_t operator+ (N count) const { return ip4_t ((uint32_t)(to_number () + (uint32_t)count)); } ///< @brief Address 'count' steps further.
+    template <class N, typename std::enable_if<std::is_integral<N>::value, int>::type = 0>
+    ip4_t operator- (N count) const { return ip4_t ((uint32_t)(to_number () - (uint32_t)count)); } ///< @brief Address 'count' steps back.
+
+    ip4_t operator| (const ip4_t& other) const { return ip4_t ((uint32_t)(to_number () | other.to_number ())); }
+    ip4_t operator^ (const ip4_t& other) const { return ip4_t ((uint32_t)(to_number () ^ other.to_number ())); }
+    ip4_t operator~ () const                   { return ip4_t ((uint32_t)~to_number ()); }
+
     void rotate () {
       std::swap ((*this)[0], (*this)[3]);
       std::swap ((*this)[1], (*this)[2]);
     }
 
+    static const size_t max_str_len = 15; ///< "255.255.255.255"
+
+    /// @brief Writes ipv4 address text into a caller buffer, without allocation and without a terminating zero.
+    /// @param first - start of the output buffer
+    /// @param last  - end of the output buffer
+    /// @return pointer past the last written character, or nullptr if the buffer is too small (nothing is written then)
+    char* to_chars (char* first, char* last) const {
+      return chars::checked<max_str_len> (first, last, [this] (char* out) {
+        out = chars::put_octet (out, (*this)[0]); *out++ = '.';
+        out = chars::put_octet (out, (*this)[1]); *out++ = '.';
+        out = chars::put_octet (out, (*this)[2]); *out++ = '.';
+        return chars::put_octet (out, (*this)[3]);
+      });
+    }
+
     /// @brief Converts ipv4 address to text representation.
     /// @return text representation of ipv4 address
     std::string to_str () const {
-      return std::to_string ((*this)[0]) + '.' + std::to_string ((*this)[1]) + '.' + std::to_string ((*this)[2]) + '.' + std::to_string ((*this)[3]);
+      char buffer[max_str_len];
+      return std::string (buffer, to_chars (buffer, buffer + max_str_len));
     }
 
     operator std::string () const {
@@ -310,7 +618,8 @@ namespace ipsockets {
   };
 
   static inline std::ostream& operator<< (std::ostream& os, const ip4_t& ipv4) {
-    os << ipv4.to_str ();
+    char buffer[ip4_t::max_str_len];
+    os.write (buffer, ipv4.to_chars (buffer, buffer + ip4_t::max_str_len) - buffer);
     return os;
   }
 
@@ -319,7 +628,7 @@ namespace ipsockets {
 template<>
 struct std::hash<ipsockets::ip4_t> {
   inline std::size_t operator() (const ipsockets::ip4_t& ip) const {
-    return (uint32_t)ip;
+    return (std::size_t)ipsockets::hashing::mix ((uint32_t)ip);
   }
 };
 
@@ -571,72 +880,72 @@ namespace ipsockets {
       return *this;
     }
 
-    /// @brief Converts ipv6 address to text representation.
-    /// Supports optional address compression and optional output of the last two groups as an IPv4 address,
-    /// always outputting the special case of ip4-over-ip6 as '::ffff:x.x.x.x' string.
+    static const size_t max_str_len = 45; ///< "xxxx:xxxx:xxxx:xxxx:xxxx:xxxx:nnn.nnn.nnn.nnn"
+
+    /// @brief Writes ipv6 address text into a caller buffer, without allocation and without a terminating zero.
+    /// The text is the same as to_str() produces with the same parameters.
+    /// @param first - start of the output buffer
+    /// @param last  - end of the output buffer
     /// @param reduction - enable address compression (replacing empty groups with '::')
     /// @param embedded_ipv4 - enable force representation of last two groups as ipv4 address
-    /// @return text representation of ipv6 address
-    std::string to_str (bool reduction = true, bool embedded_ipv4 = false) const {
-
-      std::string                result;
-      const char                 symbols[] = "0123456789abcdef";
-      bool                       dot       = false;
-      const uint16_t*            part      = (uint16_t*)this;
-      enum { start, found, end } zero      = (reduction) ? start : end;
-
-      result.reserve (45); // maximum length "xxxx:xxxx:xxxx:xxxx:xxxx:xxxx:nnn.nnn.nnn.nnn" = 45
-
-      for (size_t i = 0; i < 8; i++, part++) {
-        if (*part == 0 && zero == start) {
-          zero = found;
-          result.push_back (':');
-          if (dot == false) result.push_back (':');
-        }
-        else
-          if (*part != 0 && zero == found)
-            zero = end;
-        if (zero != found) {
-          bool    non_zero = false;
-          uint8_t half_of_byte;
-          half_of_byte = *((uint8_t*)part    ) >> 4; if (half_of_byte) non_zero = true; if (non_zero) result.push_back (symbols[half_of_byte]);
-          half_of_byte = *((uint8_t*)part    ) & 15; if (half_of_byte) non_zero = true; if (non_zero) result.push_back (symbols[half_of_byte]);
-          half_of_byte = *((uint8_t*)part + 1) >> 4; if (half_of_byte) non_zero = true; if (non_zero) result.push_back (symbols[half_of_byte]);
-          half_of_byte = *((uint8_t*)part + 1) & 15;                                                  result.push_back (symbols[half_of_byte]);
-          dot = true;
-          if (i != 7)
-            result.push_back (':');
-        }
-        if ((i == 4 && zero == found && *(part + 1) == 0xffff) || (embedded_ipv4 && i == 5)) {
-          if (i == 4) {
-            for (size_t i = 0; i < 4; i++)
-              result.push_back('f');
-            result.push_back(':');
-            part += 2;
+    /// @return pointer past the last written character, or nullptr if the buffer is too small (nothing is written then)
+    char* to_chars (char* first, char* last, bool reduction = true, bool embedded_ipv4 = false) const {
+      return chars::checked<max_str_len> (first, last, [this, reduction, embedded_ipv4] (char* out) {
+
+        const char                 symbols[] = "0123456789abcdef";
+        bool                       dot       = false;
+        const uint16_t*            part      = (uint16_t*)this;
+        enum { start, found, end } zero      = (reduction) ? start : end;
+
+        for (size_t i = 0; i < 8; i++, part++) {
+          if (*part == 0 && zero == start) {
+            zero = found;
+            *out++ = ':';
+            if (dot == false) *out++ = ':';
           }
           else
-            part += 1;
-          for (size_t i = 0; i < 4; i++) {
-            uint8_t byte     = *((uint8_t*)part + i); // byte = XYZ
-            uint8_t div      = byte % 100;            // div = XYZ % 100 = 0YZ
+            if (*part != 0 && zero == found)
+              zero = end;
+          if (zero != found) {
             bool    non_zero = false;
-            byte /= 100; // byte = XYZ / 100 = X
-            if (byte != 0) {
-              result.push_back (symbols[byte]);
-              non_zero = true;
+            uint8_t half_of_byte;
+            half_of_byte = *((uint8_t*)part    ) >> 4; if (half_of_byte) non_zero = true; if (non_zero) *out++ = symbols[half_of_byte];
+            half_of_byte = *((uint8_t*)part    ) & 15; if (half_of_byte) non_zero = true; if (non_zero) *out++ = symbols[half_of_byte];
+            half_of_byte = *((uint8_t*)part + 1) >> 4; if (half_of_byte) non_zero = true; if (non_zero) *out++ = symbols[half_of_byte];
+            half_of_byte = *((uint8_t*)part + 1) & 15;                                                  *out++ = symbols[half_of_byte];
+            dot = true;
+            if (i != 7)
+              *out++ = ':';
+          }
+          if ((i == 4 && zero == found && *(part + 1) == 0xffff) || (embedded_ipv4 && i == 5)) {
+            if (i == 4) {
+              std::memcpy (out, "ffff:", 5);
+              out  += 5;
+              part += 2;
             }
-            byte = div / 10; // byte = 0YZ / 10 = Y
-            div  = div % 10; // div = 0YZ % 10 = Z
-            if (byte != 0 || non_zero == true)
-              result.push_back (symbols[byte]);
-            result.push_back (symbols[div]);
-            if (i != 3)
-              result.push_back ('.');
+            else
+              part += 1;
+            const uint8_t* bytes = (const uint8_t*)part;
+            out = chars::put_octet (out, bytes[0]); *out++ = '.';
+            out = chars::put_octet (out, bytes[1]); *out++ = '.';
+            out = chars::put_octet (out, bytes[2]); *out++ = '.';
+            out = chars::put_octet (out, bytes[3]);
+            break;
           }
-          break;
         }
-      }
-      return result;
+        return out;
+      });
+    }
+
+    /// @brief Converts ipv6 address to text representation.
+    /// Supports optional address compression and optional output of the last two groups as an IPv4 address,
+    /// always outputting the special case of ip4-over-ip6 as '::ffff:x.x.x.x' string.
+    /// @param reduction - enable address compression (replacing empty groups with '::')
+    /// @param embedded_ipv4 - enable force representation of last two groups as ipv4 address
+    /// @return text representation of ipv6 address
+    std::string to_str (bool reduction = true, bool embedded_ipv4 = false) const {
+      char buffer[max_str_len];
+      return std::string (buffer, to_chars (buffer, buffer + max_str_len, reduction, embedded_ipv4));
     }
 
     operator std::string () const {
@@ -661,10 +970,53 @@ namespace ipsockets {
       *((uint64_t*)this + 1) &= *((uint64_t*)&other_ip + 1);
     }
 
+    // ===== numeric operations (address as 128-bit number, wrap-around) =====
+
+    /// @brief Constructs the address from its numeric value (see to_number()).
+    explicit ip6_t (const u128_t& number) {
+      uint64_t high = orders::htonT (number.high ()), low = orders::htonT (number.low ());
+      std::memcpy (data (),     &high, 8);
+      std::memcpy (data () + 8, &low,  8);
+    }
+
+    /// @brief Returns the address as a 128-bit number (first byte is the most significant).
+    u128_t to_number () const {
+      uint64_t high, low;
+      std::memcpy (&high, data (),     8);
+      std::memcpy (&low,  data () + 8, 8);
+      return u128_t (orders::ntohT (high), orders::ntohT (low));
+    }
+
+    ip6_t next () const { return ip6_t (to_number () + u128_t (1)); } ///< @brief Returns the following address (all ones wraps to ::).
+    ip6_t prev () const { return ip6_t (to_number () - u128_t (1)); } ///< @brief Returns the preceding address (:: wraps to all ones).
+
+    /// @brief Returns the number of steps from this address to 'other' (other - this, wrap-around).
+    u128_t distance (const ip6_t& other) const { return other.to_number () - to_number (); }
+
+    ip6_t operator+ (const u128_t& count) const { return ip6_t (to_number () + count); } ///< @brief Address 'count' steps further.
+    ip6_t operator- (const u128_t& count) const { return ip6_t (to_number () - count); } ///< @brief Address 'count' steps back.
+    template <class N, typename std::enable_if<std::is_integral<N>::value, int>::type = 0>
+    ip6_t operator+ (N count) const { return ip6_t (to_number () + _count (count)); }
+    template <class N, typename std::enable_if<std::is_integral<N>::value, int>::type = 0>
+    ip6_t operator- (N count) const { return ip6_t (to_number () - _count (count)); }
+
+    ip6_t operator| (const ip6_t& other) const { return ip6_t (to_number () | other.to_number ()); }
+    ip6_t operator^ (const ip6_t& other) const { return ip6_t (to_number () ^ other.to_number ()); }
+    ip6_t operator~ () const                   { return ip6_t (~to_number ()); }
+
+  private:
+
+    /// @brief Converts an integral step count to u128_t, negative counts are sign-extended (+ (-1) is one step back).
+    template <class N>
+    static u128_t _count (N count) {
+      return (std::is_signed<N>::value && (int64_t)count < 0) ? u128_t (~0ull, (uint64_t)(int64_t)count) : u128_t ((uint64_t)count);
+    }
+
   };
 
   static inline std::ostream& operator<< (std::ostream& os, const ip6_t& ipv6) {
-    os << ipv6.to_str ();
+    char buffer[ip6_t::max_str_len];
+    os.write (buffer, ipv6.to_chars (buffer, buffer + ip6_t::max_str_len) - buffer);
     return os;
   }
 
@@ -673,7 +1025,10 @@ namespace ipsockets {
 template <>
 struct std::hash<ipsockets::ip6_t> {
   inline std::size_t operator() (const ipsockets::ip6_t& ip) const noexcept{
-    return *((uint64_t*)&ip) ^ *((uint64_t*)&ip + 1);
+    uint64_t high, low;
+    std::memcpy (&high, ip.data (),     8);
+    std::memcpy (&low,  ip.data () + 8, 8);
+    return (std::size_t)ipsockets::hashing::mix (high, low);
   }
 };
 
@@ -697,6 +1052,11 @@ namespace ipsockets {
   template <ip_type_e type>
   using ip_t = typename ip_t_<type>::type;
 
+  // numeric value of an address: ip_number_t<v4> = uint32_t, ip_number_t<v6> = u128_t (see to_number())
+
+  template <ip_type_e type>
+  using ip_number_t = typename std::conditional<type == v4, uint32_t, u128_t>::type;
+
   // addr_t
 
   struct addr4_t {
@@ -768,8 +1128,21 @@ namespace ipsockets {
       from_str (value.data(), Size);
     }
 
+    static const size_t max_str_len = ip4_t::max_str_len + 6; ///< "255.255.255.255:65535"
+
+    /// @brief Writes "ip:port" into a caller buffer, without allocation and without a terminating zero.
+    /// @return pointer past the last written character, or nullptr if the buffer is too small (nothing is written then)
+    char* to_chars (char* first, char* last) const {
+      return chars::checked<max_str_len> (first, last, [this] (char* out) {
+        out    = ip.to_chars (out, out + ip4_t::max_str_len);
+        *out++ = ':';
+        return chars::put_u16 (out, port);
+      });
+    }
+
     std::string to_str () const {
-      return ip.to_str() + ':' + std::to_string (port);
+      char buffer[max_str_len];
+      return std::string (buffer, to_chars (buffer, buffer + max_str_len));
     }
 
     operator std::string () const {
@@ -787,7 +1160,8 @@ namespace ipsockets {
   };
 
   static inline std::ostream& operator<< (std::ostream& os, const addr4_t& addr4) {
-    os << addr4.to_str ();
+    char buffer[addr4_t::max_str_len];
+    os.write (buffer, addr4.to_chars (buffer, buffer + addr4_t::max_str_len) - buffer);
     return os;
   }
 
@@ -796,7 +1170,7 @@ namespace ipsockets {
 template <>
 struct std::hash<ipsockets::addr4_t> {
   std::size_t operator() (const ipsockets::addr4_t& addr4) const noexcept {
-    return std::hash<ipsockets::ip4_t> {}(addr4.ip) ^ std::hash<uint16_t> {}(addr4.port);
+    return (std::size_t)ipsockets::hashing::mix (((uint64_t)(uint32_t)addr4.ip << 16) | addr4.port);
   }
 };
 
@@ -899,8 +1273,24 @@ namespace ipsockets {
       from_str (value.data (), Size);
     }
 
+    static const size_t max_str_len = ip6_t::max_str_len + 8; ///< "[xxxx:...:nnn.nnn.nnn.nnn]:65535"
+
+    /// @brief Writes "[ip]:port" into a caller buffer, without allocation and without a terminating zero.
+    /// @param reduction, embedded_ipv4 - same as for ip6_t::to_chars()
+    /// @return pointer past the last written character, or nullptr if the buffer is too small (nothing is written then)
+    char* to_chars (char* first, char* last, bool reduction = true, bool embedded_ipv4 = false) const {
+      return chars::checked<max_str_len> (first, last, [this, reduction, embedded_ipv4] (char* out) {
+        *out++ = '[';
+        out    = ip.to_chars (out, out + ip6_t::max_str_len, reduction, embedded_ipv4);
+        *out++ = ']';
+        *out++ = ':';
+        return chars::put_u16 (out, port);
+      });
+    }
+
     std::string to_str (bool reduction = true, bool embedded_ipv4 = false) const {
-      return std::string ("[") + ip.to_str (reduction, embedded_ipv4) + std::string ("]:") + std::to_string (port);
+      char buffer[max_str_len];
+      return std::string (buffer, to_chars (buffer, buffer + max_str_len, reduction, embedded_ipv4));
     }
 
     operator std::string () const {
@@ -918,7 +1308,8 @@ namespace ipsockets {
   };
 
   static inline std::ostream& operator<< (std::ostream& os, const addr6_t& addr6) {
-    os << addr6.to_str ();
+    char buffer[addr6_t::max_str_len];
+    os.write (buffer, addr6.to_chars (buffer, buffer + addr6_t::max_str_len) - buffer);
     return os;
   }
 
@@ -927,7 +1318,10 @@ namespace ipsockets {
 template <>
 struct std::hash<ipsockets::addr6_t> {
   inline std::size_t operator() (const ipsockets::addr6_t& addr6) const noexcept {
-    return std::hash<ipsockets::ip6_t> {}(addr6.ip) ^ std::hash<uint16_t> {}(addr6.port);
+    uint64_t high, low;
+    std::memcpy (&high, addr6.ip.data (),     8);
+    std::memcpy (&low,  addr6.ip.data () + 8, 8);
+    return (std::size_t)ipsockets::hashing::mix (ipsockets::hashing::mix (high, low) ^ addr6.port);
   }
 };
 
@@ -1166,9 +1560,22 @@ namespace ipsockets {
 
     // ===== conversion =====
 
+    static const size_t max_str_len = ip_t<Ip_type>::max_str_len + 4; ///< address + "/128"
+
+    /// @brief Writes the prefix in CIDR notation into a caller buffer, without allocation and without a terminating zero.
+    /// @return pointer past the last written character, or nullptr if the buffer is too small (nothing is written then)
+    char* to_chars (char* first, char* last) const {
+      return chars::checked<max_str_len> (first, last, [this] (char* out) {
+        out    = ip.to_chars (out, out + ip_t<Ip_type>::max_str_len);
+        *out++ = '/';
+        return chars::put_octet (out, length);
+      });
+    }
+
     /// @brief Converts the prefix to CIDR notation string (e.g. "192.168.1.0/24").
     std::string to_str () const {
-      return ip.to_str () + '/' + std::to_string (length);
+      char buffer[max_str_len];
+      return std::string (buffer, to_chars (buffer, buffer + max_str_len));
     }
 
     operator std::string () const {
@@ -1317,7 +1724,8 @@ namespace ipsockets {
 
   template <ip_type_e Ip_type>
   static inline std::ostream& operator<< (std::ostream& os, const ip_prefix_t<Ip_type>& prefix) {
-    os << prefix.to_str ();
+    char buffer[ip_prefix_t<Ip_type>::max_str_len];
+    os.write (buffer, prefix.to_chars (buffer, buffer + ip_prefix_t<Ip_type>::max_str_len) - buffer);
     return os;
   }
 
@@ -0,0 +1,222 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_address.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// SIMD kernel for canonical dotted-quad ipv4 text, selected at run time when the CPU supports SSE4.1
+// define IP_SOCKETS_NO_SIMD before including this header to always use the scalar parser
+#if !defined(IP_SOCKETS_NO_SIMD) && (defined(__x86_64__) || defined(__i386__) || defined(_M_X64))
+  #if defined(__GNUC__) || defined(__clang__)
+    #include <immintrin.h>
+    #define IP_SOCKETS_HAS_SIMD_PARSE 1
+    #define IP_SOCKETS_TARGET_SSE41 __attribute__ ((target ("sse4.1")))
+  #elif defined(_MSC_VER)
+    #include <intrin.h>
+    #include <immintrin.h>
+    #define IP_SOCKETS_HAS_SIMD_PARSE 1
+    #define IP_SOCKETS_TARGET_SSE41
+  #endif
+#endif
+
+namespace ipsockets {
+
+  // ============================================================
+  // bulk parsing — many text addresses into a contiguous array with a success bitmap
+  // ============================================================
+
+  namespace bulk_parse {
+
+    #ifdef IP_SOCKETS_HAS_SIMD_PARSE
+
+      /// @brief Returns true if the SSE4.1 kernel can be used on this CPU (checked once).
+      inline bool simd_supported () {
+        static const bool supported = [] {
+          #if defined(_MSC_VER) && !defined(__clang__)
+            int info[4];
+            __cpuid (info, 1);
+            return (info[2] & (1 << 19)) != 0; // ECX bit 19 = SSE4.1
+          #else
+            __builtin_cpu_init ();
+            return __builtin_cpu_supports ("sse4.1") != 0;
+          #endif
+        } ();
+        return supported;
+      }
+
+      /// @brief Index of the lowest set bit, value must not be zero.
+      inline int _lowest_bit (uint32_t value) {
+        #if defined(_MSC_VER) && !defined(__clang__)
+          unsigned long index;
+          _BitScanForward (&index, value);
+          return (int)index;
+        #else
+          return __builtin_ctz (value);
+        #endif
+      }
+
+      /// @brief Shuffle patterns for every combination of octet lengths (1..3 digits each, 3^4 = 81 patterns).
+      /// @details Pattern moves the digits of octet N to bytes 4*N+1..4*N+3 right-aligned, unused bytes are zeroed,
+      ///   so every octet becomes [0, hundreds, tens, units].
+      inline const uint8_t* ip4_shuffle_table () {
+        struct table_t {
+          alignas (16) uint8_t data[81][16];
+          table_t () {
+            for (int index = 0; index < 81; index++) {
+              int lengths[4] = { index / 27 % 3 + 1, index / 9 % 3 + 1, index / 3 % 3 + 1, index % 3 + 1 };
+              int position   = 0;
+              for (int octet = 0; octet < 4; octet++) {
+                for (int i = 0; i < 4; i++) {
+                  int digit = i - (4 - lengths[octet]); // index of the digit inside the octet, negative = padding
+                  data[index][octet * 4 + i] = (digit >= 0) ? (uint8_t)(position + digit) : (uint8_t)0x80;
+                }
+                position += lengths[octet] + 1; // digits plus the dot
+              }
+            }
+          }
+        };
+        static const table_t table;
+        return table.data[0];
+      }
+
+      /// @brief Parses canonical dotted-quad text: exactly four 1..3 digit decimal octets, each <= 255.
+      /// @return true on success; false means "not canonical", the caller must fall back to the scalar parser,
+      ///   which gives the final answer (hex octets, "127.1", single number, trailing zero byte, ...).
+      IP_SOCKETS_TARGET_SSE41 inline bool parse_ip4_sse41 (const char* text, size_t size, ip4_t& result) {
+
+        if (size < 7 || size > 15)
+          return false;
+
+        // avoid touching memory past the text: load directly unless the 16 byte read would cross a page
+        __m128i input;
+        #if defined(__SANITIZE_ADDRESS__)
+          const bool direct = false;
+        #else
+          const bool direct = ((uintptr_t)text & 4095) <= 4096 - 16;
+        #endif
+        if (direct)
+          input = _mm_loadu_si128 ((const __m128i*)text);
+        else {
+          alignas (16) char buffer[16] = {};
+          std::memcpy (buffer, text, size);
+          input = _mm_load_si128 ((const __m128i*)buffer);
+        }
+
+        const uint32_t in_text = (1u << size) - 1;
+        const __m128i  digits  = _mm_sub_epi8 (input, _mm_set1_epi8 ('0'));
+        const uint32_t is_dot  = (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (input, _mm_set1_epi8 ('.'))) & in_text;
+        const uint32_t is_dig  = (uint32_t)_mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_min_epu8 (digits, _mm_set1_epi8 (9)), digits)) & in_text;
+
+        if ((is_dot | is_dig) != in_text)
+          return false;
+
+        // positions of the three dots give the octet lengths
+        uint32_t dots = is_dot;
+        if (dots == 0) return false;
+        int dot1 = _lowest_bit (dots); dots &= dots - 1; if (dots == 0) return false;
+        int dot2 = _lowest_bit (dots); dots &= dots - 1; if (dots == 0) return false;
+        int dot3 = _lowest_bit (dots); dots &= dots - 1; if (dots != 0) return false;
+
+        unsigned len0 = (unsigned)dot1 - 1, len1 = (unsigned)(dot2 - dot1 - 2), len2 = (unsigned)(dot3 - dot2 - 2), len3 = (unsigned)((int)size - dot3 - 2);
+        if (len0 > 2 || len1 > 2 || len2 > 2 || len3 > 2) // each length - 1 must be 0..2, negative values wrap to large numbers
+          return false;
+
+        const __m128i pattern = _mm_load_si128 ((const __m128i*)(ip4_shuffle_table () + (len0 * 27 + len1 * 9 + len2 * 3 + len3) * 16));
+        const __m128i aligned = _mm_shuffle_epi8 (digits, pattern);                                          // [0,h,t,u] x 4
+        const __m128i pairs   = _mm_maddubs_epi16 (aligned, _mm_setr_epi8 (0, 100, 10, 1, 0, 100, 10, 1,
+                                                                            0, 100, 10, 1, 0, 100, 10, 1)); // [h*100, t*10+u] x 4
+        const __m128i octets  = _mm_hadd_epi16 (pairs, pairs);                                               // octet values as uint16
+
+        if (_mm_movemask_epi8 (_mm_cmpgt_epi16 (octets, _mm_set1_epi16 (255))) != 0)
+          return false;
+
+        const uint32_t packed = (uint32_t)_mm_cvtsi128_si32 (_mm_packus_epi16 (octets, octets));
+        std::memcpy (result.data (), &packed, 4);
+        return true;
+      }
+
+    #endif // IP_SOCKETS_HAS_SIMD_PARSE
+
+  } // namespace bulk_parse
+
+  /// @brief Parses an array of text ipv4 addresses into a contiguous array of ip4_t.
+  /// @details Every item is parsed with exactly the grammar of ip4_t::from_str (hex octets, "127.1", single number, ...),
+  ///   results are identical to calling from_str on each item. Canonical dotted-quad items are parsed by an SSE4.1
+  ///   kernel when the CPU supports it, all other items go through the scalar parser.
+  /// @tparam View - any type with data() and size(), e.g. std::string, std::string_view, or a custom view.
+  /// @param items   - texts to parse.
+  /// @param count   - number of items.
+  /// @param results - receives count addresses; a failed item becomes 0.0.0.0.
+  /// @param success - bitmap of (count + 63) / 64 words, bit i of word i / 64 is set if item i parsed. May be nullptr.
+  /// @return Number of successfully parsed items.
+  ///
+  /// @code
+  ///   std::vector<std::string> lines = ...;
+  ///   std::vector<ip4_t>       ips (lines.size ());
+  ///   std::vector<uint64_t>    ok ((lines.size () + 63) / 64);
+  ///   size_t parsed = parse_bulk (lines.data (), lines.size (), ips.data (), ok.data ());
+  /// @endcode
+  template <class View>
+  inline size_t parse_bulk (const View* items, size_t count, ip4_t* results, uint64_t* success) {
+
+    if (success)
+      std::memset (success, 0, ((count + 63) / 64) * sizeof (uint64_t));
+
+    #ifdef IP_SOCKETS_HAS_SIMD_PARSE
+      const bool simd = bulk_parse::simd_supported ();
+    #endif
+
+    size_t parsed = 0;
+    for (size_t i = 0; i < count; i++) {
+      const char* text = items[i].data ();
+      size_t      size = items[i].size ();
+      bool        ok   = false;
+      #ifdef IP_SOCKETS_HAS_SIMD_PARSE
+        if (simd)
+          ok = bulk_parse::parse_ip4_sse41 (text, size, results[i]);
+        if (!ok)
+      #endif
+          results[i].from_str (text, size, &ok);
+      if (ok) {
+        parsed++;
+        if (success)
+          success[i / 64] |= uint64_t (1) << (i % 64);
+      }
+    }
+    return parsed;
+  }
+
+  /// @brief Parses an array of text ipv6 addresses into a contiguous array of ip6_t.
+  /// @details Same contract as the ipv4 overload, with the grammar of ip6_t::from_str (compression, embedded ipv4, ...).
+  ///   Every item goes through the scalar parser.
+  template <class View>
+  inline size_t parse_bulk (const View* items, size_t count, ip6_t* results, uint64_t* success) {
+
+    if (success)
+      std::memset (success, 0, ((count + 63) / 64) * sizeof (uint64_t));
+
+    size_t parsed = 0;
+    for (size_t i = 0; i < count; i++) {
+      bool ok = false;
+      results[i].from_str (items[i].data (), items[i].size (), &ok);
+      if (ok) {
+        parsed++;
+        if (success)
+          success[i / 64] |= uint64_t (1) << (i % 64);
+      }
+    }
+    return parsed;
+  }
+
+} // namespace ipsockets
@@ -0,0 +1,383 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_addr_map.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ipsockets {
+
+  // ============================================================
+  // flow_key_t — packed 5-tuple (source, destination, protocol)
+  // ============================================================
+
+  /// @brief Flow identifier: source address, destination address and protocol number, without padding holes.
+  /// @details 16 bytes for ipv4 and 40 bytes for ipv6; compared with memcmp and hashed as 64-bit words.
+  ///   The key is directional: reversed() gives the key of the reply direction.
+  template <ip_type_e Ip_type>
+  struct flow_key_t {
+
+    using ip_type   = ip_t<Ip_type>;
+    using addr_type = addr_t<Ip_type>;
+
+    ip_type  src_ip   = {};
+    ip_type  dst_ip   = {};
+    uint16_t src_port = 0;
+    uint16_t dst_port = 0;
+    uint8_t  protocol = 0;    ///< IPPROTO_UDP, IPPROTO_TCP, ...
+    uint8_t  reserved[3] = {}; ///< Always zero, keeps the key free of uninitialized bytes
+
+    flow_key_t () = default;
+
+    flow_key_t (const addr_type& src, const addr_type& dst, uint8_t protocol_)
+      : src_ip (src.ip), dst_ip (dst.ip), src_port (src.port), dst_port (dst.port), protocol (protocol_) {}
+
+    addr_type src () const { addr_type addr; addr.ip = src_ip; addr.port = src_port; return addr; } ///< @brief Returns the source address.
+    addr_type dst () const { addr_type addr; addr.ip = dst_ip; addr.port = dst_port; return addr; } ///< @brief Returns the destination address.
+
+    /// @brief Returns the key of the opposite direction (source and destination swapped).
+    flow_key_t reversed () const { return flow_key_t (dst (), src (), protocol); }
+
+    bool operator== (const flow_key_t& other) const { return std::memcmp (this, &other, sizeof (flow_key_t)) == 0; }
+    bool operator!= (const flow_key_t& other) const { return !(*this == other); }
+
+    /// @brief Returns a well mixed 64-bit hash of the whole key.
+    uint64_t hash () const {
+      uint64_t words[sizeof (flow_key_t) / 8];
+      std::memcpy (words, this, sizeof (words));
+      uint64_t result = 0;
+      for (size_t i = 0; i < sizeof (words) / 8; i++)
+        result = hashing::mix (result ^ words[i]);
+      return result;
+    }
+  };
+
+  static_assert (sizeof (flow_key_t<v4>) == 16, "flow_key_t<v4> must be packed");
+  static_assert (sizeof (flow_key_t<v6>) == 40, "flow_key_t<v6> must be packed");
+
+} // namespace ipsockets
+
+template <ipsockets::ip_type_e Ip_type>
+struct std::hash<ipsockets::flow_key_t<Ip_type>> {
+  std::size_t operator() (const ipsockets::flow_key_t<Ip_type>& key) const noexcept {
+    return (std::size_t)key.hash ();
+  }
+};
+
+namespace ipsockets {
+
+  // ============================================================
+  // flow_table_t — sharded flow table with timer-wheel aging for connection tracking
+  // ============================================================
+
+  /// @brief Default flow state: packet and byte counters.
+  struct flow_stats_t {
+    uint64_t packets = 0;
+    uint64_t bytes   = 0;
+  };
+
+  /// @brief Table of flows keyed by flow_key_t, safe to use from many threads, with idle flow expiration.
+  /// @details Flows are spread over a power-of-two number of shards by the top bits of the key hash; every shard is
+  ///   an addr_map_t behind its own mutex, so threads working on different flows rarely wait for each other.
+  ///   Time is given by the caller as ticks (seconds, milliseconds, ...), a flow expires when it was not updated
+  ///   for 'timeout' ticks. Every shard keeps a timer wheel of timeout + 1 (rounded up to a power of two) buckets;
+  ///   a new flow is put into the bucket of its expiry tick, updating a flow only stores the tick (the wheel is
+  ///   not touched), and expire() walks the buckets whose tick has passed: flows still idle are removed,
+  ///   refreshed flows are moved to the bucket of their new expiry tick. The walk takes the shard lock for at
+  ///   most sweep_batch records at a time, so lookups are never blocked behind a whole bucket.
+  ///
+  /// @code
+  ///   flow_table_t<v4> flows (30);                        // expire after 30 idle ticks (seconds here)
+  ///   flows.update (flow_key_t<v4> (from, local, IPPROTO_UDP), now, [&] (flow_stats_t& flow, bool created) {
+  ///     flow.packets++;
+  ///     flow.bytes += size;
+  ///   });
+  ///   ...
+  ///   flows.expire (now);                                 // from a timer, once per tick
+  /// @endcode
+  template <ip_type_e Ip_type, class Value = flow_stats_t>
+  struct flow_table_t {
+
+    using key_type = flow_key_t<Ip_type>;
+
+    static const size_t sweep_batch = 1024; ///< Records handled by expire() per shard lock
+
+    /// @brief Counters summed over all shards, see stats().
+    struct stats_t {
+      size_t   flows     = 0; ///< Live flows
+      size_t   capacity  = 0; ///< Allocated slots in all shards
+      uint64_t created   = 0; ///< Flows added by update()
+      uint64_t expired   = 0; ///< Flows removed by expire()
+      uint64_t erased    = 0; ///< Flows removed by erase()
+      uint64_t rejected  = 0; ///< update() calls refused because max_flows was reached
+
+      /// @brief Returns flows / capacity, 0 for an empty table.
+      double occupancy () const { return capacity ? (double)flows / (double)capacity : 0.0; }
+    };
+
+    ///	@param timeout_   - Idle ticks after which a flow expires (at least 1).
+    ///	@param max_flows_ - Upper bound for the number of flows, 0 = unlimited; divided evenly between the shards.
+    ///	@param shards_    - Number of shards, rounded up to a power of two; about 4x the number of threads is a good value.
+    flow_table_t (uint32_t timeout_, size_t max_flows_ = 0, size_t shards_ = 16) : timeout (timeout_ ? timeout_ : 1) {
+      while (shard_count < shards_)
+        shard_count *= 2;
+      while (((size_t)1 << shard_bits) < shard_count)
+        shard_bits++;
+      wheel_size = 16;
+      while (wheel_size <= timeout)
+        wheel_size *= 2;
+      shard_limit = max_flows_ ? (max_flows_ + shard_count - 1) / shard_count : 0;
+      shards.reset (new shard_t[shard_count]);
+      for (size_t i = 0; i < shard_count; i++)
+        shards[i].wheel.resize (wheel_size);
+    }
+
+    ///	@brief Finds the flow or creates it with a value-initialized Value, marks it seen at 'now' and calls fn on it.
+    ///	@param fn - Called as fn (Value& value, bool created) while the shard is locked; keep it short.
+    ///	@return false if the flow did not exist and the table is full (max_flows), fn is not called then.
+    template <class Fn>
+    bool update (const key_type& key, uint32_t now, Fn fn) {
+      shard_t&                    shard = _shard (key);
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      entry_t* entry = shard.flows.find (key);
+      bool     created = (entry == nullptr);
+      if (created) {
+        if (shard_limit && shard.flows.size () >= shard_limit) {
+          shard.rejected++;
+          return false;
+        }
+        entry         = shard.flows.emplace (key).first;
+        entry->serial = ++shard.serial;
+        shard.wheel[(now + timeout) & (wheel_size - 1)].push_back (record_t { key, now + timeout, entry->serial });
+        shard.created++;
+      }
+      entry->last_seen = now;
+      fn (entry->value, created);
+      return true;
+    }
+
+    ///	@brief Marks an existing flow seen at 'now' without changing its value.
+    ///	@return false if the flow does not exist.
+    bool touch (const key_type& key, uint32_t now) {
+      shard_t&                    shard = _shard (key);
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      entry_t* entry = shard.flows.find (key);
+      if (entry == nullptr)
+        return false;
+      entry->last_seen = now;
+      return true;
+    }
+
+    ///	@brief Copies the value of a flow.
+    ///	@return false if the flow does not exist.
+    bool find (const key_type& key, Value& result) const {
+      shard_t&                    shard = _shard (key);
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      const entry_t* entry = shard.flows.find (key);
+      if (entry == nullptr)
+        return false;
+      result = entry->value;
+      return true;
+    }
+
+    ///	@brief Returns true if the flow exists.
+    bool contains (const key_type& key) const {
+      shard_t&                    shard = _shard (key);
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      return shard.flows.contains (key);
+    }
+
+    ///	@brief Removes a flow (e.g. on TCP FIN/RST). Its wheel record is dropped lazily by expire().
+    ///	@return true if the flow existed.
+    bool erase (const key_type& key) {
+      shard_t&                    shard = _shard (key);
+      std::lock_guard<std::mutex> lock (shard.mutex);
+      if (!shard.flows.erase (key))
+        return false;
+      shard.erased++;
+      return true;
+    }
+
+    ///	@brief Removes flows idle for 'timeout' ticks at 'now'; call it at least once per wheel turn, usually every tick.
+    ///	@param on_expire - Called as on_expire (const key_type&, Value&) for every removed flow, under the shard lock.
+    ///	@return Number of removed flows.
+    template <class Fn>
+    size_t expire (uint32_t now, Fn on_expire) {
+      std::lock_guard<std::mutex> sweep_lock (sweep_mutex); // one sweeper at a time, lookups are not affected
+      size_t removed = 0;
+      for (size_t i = 0; i < shard_count; i++)
+        removed += _expire (shards[i], now, on_expire);
+      return removed;
+    }
+
+    ///	@brief Removes flows idle for 'timeout' ticks at 'now'.
+    size_t expire (uint32_t now) {
+      return expire (now, [] (const key_type&, Value&) {});
+    }
+
+    ///	@brief Calls fn (const key_type&, const Value&, uint32_t last_seen) for every flow, one shard locked at a time.
+    template <class Fn>
+    void for_each (Fn fn) const {
+      for (size_t i = 0; i < shard_count; i++) {
+        std::lock_guard<std::mutex> lock (shards[i].mutex);
+        shards[i].flows.for_each ([&] (const key_type& key, const entry_t& entry) { fn (key, (const Value&)entry.value, entry.last_seen); });
+      }
+    }
+
+    ///	@brief Returns the number of flows (a snapshot, shards are counted one by one).
+    size_t size () const {
+      size_t result = 0;
+      for (size_t i = 0; i < shard_count; i++) {
+        std::lock_guard<std::mutex> lock (shards[i].mutex);
+        result += shards[i].flows.size ();
+      }
+      return result;
+    }
+
+    ///	@brief Returns occupancy and eviction counters summed over all shards.
+    stats_t stats () const {
+      stats_t result;
+      for (size_t i = 0; i < shard_count; i++) {
+        std::lock_guard<std::mutex> lock (shards[i].mutex);
+        result.flows    += shards[i].flows.size ();
+        result.capacity += shards[i].flows.capacity ();
+        result.created  += shards[i].created;
+        result.expired  += shards[i].expired;
+        result.erased   += shards[i].erased;
+        result.rejected += shards[i].rejected;
+      }
+      return result;
+    }
+
+    ///	@brief Removes all flows, counters are kept.
+    void clear () {
+      std::lock_guard<std::mutex> sweep_lock (sweep_mutex);
+      for (size_t i = 0; i < shard_count; i++) {
+        std::lock_guard<std::mutex> lock (shards[i].mutex);
+        shards[i].flows.clear ();
+        for (std::vector<record_t>& bucket : shards[i].wheel)
+          bucket.clear ();
+      }
+    }
+
+    uint32_t get_timeout () const { return timeout; }     ///< @brief Returns the idle timeout in ticks.
+    size_t   get_shards ()  const { return shard_count; } ///< @brief Returns the number of shards.
+
+  protected:
+
+    struct entry_t {
+      Value    value     = Value ();
+      uint32_t last_seen = 0; ///< Tick of the last update()/touch()
+      uint32_t serial    = 0; ///< Matches the wheel record of this flow; older records of an erased key are stale
+    };
+
+    struct record_t {
+      key_type key;
+      uint32_t expiry; ///< Tick at which the flow expires unless it was seen again
+      uint32_t serial;
+    };
+
+    // not alignas(64): new[] ignores extended alignment before C++17, the trailing padding keeps the fields
+    // of neighbouring shards on different cache lines wherever the array starts
+    struct shard_t {
+      mutable std::mutex                 mutex;
+      addr_map_t<key_type, entry_t>      flows;
+      std::vector<std::vector<record_t>> wheel;        ///< wheel_size buckets, bucket = expiry tick % wheel_size
+      uint32_t                           serial   = 0;
+      uint32_t                           cursor   = 0; ///< Next tick to sweep
+      bool                               started  = false;
+      uint64_t                           created  = 0;
+      uint64_t                           expired  = 0;
+      uint64_t                           erased   = 0;
+      uint64_t                           rejected = 0;
+      char                               padding[64];
+    };
+
+    uint32_t                   timeout;
+    size_t                     shard_count = 1;
+    size_t                     shard_bits  = 0;
+    size_t                     shard_limit = 0;
+    uint32_t                   wheel_size  = 16;
+    std::unique_ptr<shard_t[]> shards;
+    std::mutex                 sweep_mutex;
+
+    /// @brief Selects the shard by the top hash bits; addr_map_t uses the low bits, so both stay independent.
+    shard_t& _shard (const key_type& key) const {
+      return shards[shard_bits ? (size_t)(key.hash () >> (64 - shard_bits)) : 0];
+    }
+
+    /// @brief Sweeps the buckets of the ticks (cursor, now] of one shard.
+    template <class Fn>
+    size_t _expire (shard_t& shard, uint32_t now, Fn& on_expire) {
+
+      uint32_t first;
+      {
+        std::lock_guard<std::mutex> lock (shard.mutex);
+        if (!shard.started) {
+          shard.started = true;
+          shard.cursor  = now - wheel_size + 1; // first call: every bucket may hold due records
+        }
+        if ((int32_t)(now - shard.cursor) < 0)
+          return 0;
+        // buckets repeat every wheel_size ticks, a longer gap is one full turn
+        first = ((now - shard.cursor) >= wheel_size) ? now - wheel_size + 1 : shard.cursor;
+        shard.cursor = now + 1;
+      }
+
+      size_t removed = 0;
+      for (uint32_t tick = first; tick != now + 1; tick++) {
+        uint32_t bucket_index = tick & (wheel_size - 1);
+        size_t   read  = 0;
+        size_t   write = 0;
+        bool     done  = false;
+        while (!done) {
+          std::lock_guard<std::mutex> lock (shard.mutex);
+          std::vector<record_t>&      bucket = shard.wheel[bucket_index]; // update() may append while the lock is released
+          for (size_t batch = 0; batch < sweep_batch && read < bucket.size (); batch++, read++) {
+            record_t record = bucket[read];
+            if ((int32_t)(record.expiry - now) > 0) { // not due yet (the wheel turned since it was scheduled)
+              bucket[write++] = record;
+              continue;
+            }
+            entry_t* entry = shard.flows.find (record.key);
+            if (entry == nullptr || entry->serial != record.serial)
+              continue; // flow was erased (and maybe recreated with its own record)
+            if ((int32_t)(now - entry->last_seen) >= (int32_t)timeout) {
+              on_expire ((const key_type&)record.key, entry->value);
+              shard.flows.erase (record.key);
+              shard.expired++;
+              removed++;
+              continue;
+            }
+            record.expiry = entry->last_seen + timeout;
+            uint32_t target = record.expiry & (wheel_size - 1);
+            if (target == bucket_index)
+              bucket[write++] = record;
+            else
+              shard.wheel[target].push_back (record);
+          }
+          if (read == bucket.size ()) {
+            bucket.resize (write);
+            done = true;
+          }
+        }
+      }
+      return removed;
+    }
+
+  };
+
+} // namespace ipsockets
@@ -0,0 +1,289 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_address.h"
+
+#include <algorithm> // std::fill_n, std::sort
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace ipsockets {
+
+  // ============================================================
+  // lpm_table_t — longest-prefix-match table (multibit trie, strides 16-8-8-...)
+  // ============================================================
+
+  /// @brief Maps prefixes to values and finds the value of the longest prefix containing an address.
+  /// @details The first 16 bits of the address index a root array of 65536 slots, every next byte indexes a
+  ///   256-slot node, so a lookup is at most 3 dependent loads for ipv4 and 15 for ipv6, without comparisons.
+  ///   Slots are leaf-pushed: every slot holds the value of the longest prefix covering it (or a child node),
+  ///   and remembers the length of that prefix, so inserting a short prefix never hides longer ones and
+  ///   erasing a prefix hands its slots to the next shorter covering prefix.
+  ///   Memory: 320 KiB for the root plus 1.25 KiB per node; a node exists for every distinct (length - 1) / 8
+  ///   byte path below /16 that has a prefix longer than the path.
+  ///   Not thread-safe for writes; concurrent lookups without writers are safe.
+  ///
+  /// @code
+  ///   lpm_table_t<v4, int> routes;
+  ///   routes.insert ("10.0.0.0/8", 1);
+  ///   routes.insert ("10.1.0.0/16", 2);
+  ///   const int* route = routes.lookup ("10.1.2.3"); // *route == 2
+  /// @endcode
+  template <ip_type_e Ip_type, class Value>
+  struct lpm_table_t {
+
+    using prefix_type = prefix_t<Ip_type>;
+    using ip_type     = ip_t<Ip_type>;
+
+    static const uint32_t root_bits  = 16;
+    static const uint32_t root_size  = 1u << root_bits;
+    static const uint32_t node_size  = 256;
+    static const uint32_t child_flag = 0x80000000u; ///< Slot holds a child node index instead of a value index + 1
+
+    lpm_table_t () {
+      clear ();
+    }
+
+    ///	@brief Adds a prefix or replaces the value of an existing one.
+    ///	@param prefix - Prefix; host bits are ignored (prefix_t constructors already mask them).
+    ///	@param value  - Value returned by lookup() for addresses whose longest match is this prefix.
+    ///	@return true if the prefix was added, false if its value was replaced.
+    bool insert (const prefix_type& prefix, const Value& value) {
+
+      typename sources_t::iterator it = sources.find (prefix);
+      if (it != sources.end ()) {
+        values[it->second] = value;
+        return false;
+      }
+
+      uint32_t index;
+      if (!free_values.empty ()) {
+        index = free_values.back ();
+        free_values.pop_back ();
+        values[index] = value;
+      }
+      else {
+        index = (uint32_t)values.size ();
+        values.push_back (value);
+      }
+      sources.emplace (prefix, index);
+
+      _paint (prefix, index + 1, prefix.length, 0, prefix.length, nullptr);
+      return true;
+    }
+
+    ///	@brief Removes a prefix; its addresses fall back to the next shorter covering prefix.
+    ///	@return true if the prefix was present.
+    bool erase (const prefix_type& prefix) {
+
+      typename sources_t::iterator it = sources.find (prefix);
+      if (it == sources.end ())
+        return false;
+
+      uint32_t index = it->second;
+      sources.erase (it);
+      values[index] = Value ();
+      free_values.push_back (index);
+
+      // the slots of the erased prefix go to the longest remaining prefix that covers it
+      uint32_t entry = 0;
+      uint8_t  owner = 0;
+      for (int length = (int)prefix.length - 1; length >= 0; length--) {
+        typename sources_t::const_iterator cover = sources.find (prefix_type (prefix.ip, (uint8_t)length));
+        if (cover != sources.end ()) {
+          entry = cover->second + 1;
+          owner = (uint8_t)length;
+          break;
+        }
+      }
+
+      std::vector<uint32_t> path;
+      _paint (prefix, entry, owner, prefix.length, prefix.length, &path);
+
+      // nodes on the path may now hold one value in all slots, fold them back into the parent slot
+      while (!path.empty ()) {
+        uint32_t slot  = path.back ();
+        uint32_t node  = entries[slot] & ~child_flag;
+        uint32_t base  = root_size + node * node_size;
+        bool     plain = (entries[base] & child_flag) == 0;
+        for (uint32_t i = 1; plain && i < node_size; i++)
+          plain = entries[base + i] == entries[base] && owners[base + i] == owners[base];
+        if (!plain)
+          break;
+        entries[slot] = entries[base];
+        owners[slot]  = owners[base];
+        free_nodes.push_back (node);
+        path.pop_back ();
+      }
+      return true;
+    }
+
+    ///	@brief Finds the value of the longest prefix that contains the address.
+    ///	@return Pointer to the value, or nullptr if no prefix matches. Valid until the next insert/erase.
+    const Value* lookup (const ip_type& ip) const {
+      uint32_t entry = entries[((uint32_t)ip[0] << 8) | ip[1]];
+      size_t   byte  = 2;
+      while (entry & child_flag)
+        entry = entries[root_size + ((entry & ~child_flag) << 8) + ip[byte++]];
+      return entry ? &values[entry - 1] : nullptr;
+    }
+
+    ///	@brief Returns the value stored for exactly this prefix, or nullptr.
+    const Value* find (const prefix_type& prefix) const {
+      typename sources_t::const_iterator it = sources.find (prefix);
+      return (it != sources.end ()) ? &values[it->second] : nullptr;
+    }
+
+    ///	@brief Calls fn (const prefix_type&, const Value&) for every stored prefix, in no particular order.
+    template <class Fn>
+    void for_each (Fn fn) const {
+      for (const typename sources_t::value_type& source : sources)
+        fn (source.first, values[source.second]);
+    }
+
+    ///	@brief Copies the trie into compact arrays, e.g. for lpm_compile().
+    ///	@details Erased nodes and value slots are dropped, nodes are renumbered breadth-first (a child always has a
+    ///	  bigger number than its parent), values are ordered by prefix (length, then address).
+    ///	@param out_entries  - Receives root slots then node slots, in the encoding used by lookup().
+    ///	@param out_values   - Receives the values; slot value index + 1 refers to this array.
+    ///	@param out_prefixes - Receives the prefix of every value, out_prefixes[i] belongs to out_values[i].
+    void export_compact (std::vector<uint32_t>& out_entries, std::vector<Value>& out_values, std::vector<prefix_type>& out_prefixes) const {
+
+      std::vector<std::pair<prefix_type, uint32_t>> sorted (sources.begin (), sources.end ());
+      std::sort (sorted.begin (), sorted.end (),
+                 [] (const std::pair<prefix_type, uint32_t>& a, const std::pair<prefix_type, uint32_t>& b) { return a.first < b.first; });
+
+      std::vector<uint32_t> remap (values.size (), 0);
+      out_values.clear ();
+      out_prefixes.clear ();
+      for (const std::pair<prefix_type, uint32_t>& source : sorted) {
+        remap[source.second] = (uint32_t)out_values.size () + 1;
+        out_values.push_back (values[source.second]);
+        out_prefixes.push_back (source.first);
+      }
+
+      // every slot is visited once in order; child nodes are appended raw and rewritten when the loop reaches them
+      out_entries.assign (entries.begin (), entries.begin () + root_size);
+      for (size_t i = 0; i < out_entries.size (); i++) {
+        uint32_t entry = out_entries[i];
+        if (entry & child_flag) {
+          uint32_t base = root_size + ((entry & ~child_flag) << 8);
+          out_entries[i] = (uint32_t)((out_entries.size () - root_size) / node_size) | child_flag;
+          out_entries.insert (out_entries.end (), entries.begin () + base, entries.begin () + base + node_size);
+        }
+        else if (entry)
+          out_entries[i] = remap[entry - 1];
+      }
+    }
+
+    ///	@brief Removes all prefixes and releases the nodes.
+    void clear () {
+      entries.assign (root_size, 0);
+      owners.assign (root_size, 0);
+      values.clear ();
+      free_values.clear ();
+      free_nodes.clear ();
+      sources.clear ();
+    }
+
+    size_t size () const { return sources.size (); } ///< @brief Returns the number of stored prefixes.
+
+    size_t nodes () const { return (entries.size () - root_size) / node_size - free_nodes.size (); } ///< @brief Returns the number of allocated trie nodes.
+
+    ///	@brief Returns the approximate number of bytes used by the trie arrays and values (without the prefix index).
+    size_t memory_usage () const {
+      return entries.capacity () * sizeof (uint32_t) + owners.capacity () + values.capacity () * sizeof (Value);
+    }
+
+  protected:
+
+    using sources_t = std::unordered_map<prefix_type, uint32_t>;
+
+    std::vector<uint32_t> entries;     ///< Root slots [0, root_size), then node_size slots per node
+    std::vector<uint8_t>  owners;      ///< Length of the prefix that wrote each value slot
+    std::vector<Value>    values;      ///< Values by index; slots store index + 1, 0 = no match
+    std::vector<uint32_t> free_values; ///< Value indexes released by erase()
+    std::vector<uint32_t> free_nodes;  ///< Node indexes released by erase()
+    sources_t             sources;     ///< Stored prefixes and their value index
+
+    /// @brief Returns the slot in the child node of 'slot', creating the node (filled with the slot value) if needed.
+    uint32_t _child (uint32_t slot, uint8_t byte) {
+      if ((entries[slot] & child_flag) == 0) {
+        uint32_t node;
+        if (!free_nodes.empty ()) {
+          node = free_nodes.back ();
+          free_nodes.pop_back ();
+        }
+        else {
+          node = (uint32_t)((entries.size () - root_size) / node_size);
+          entries.resize (entries.size () + node_size);
+          owners.resize (owners.size () + node_size);
+        }
+        uint32_t base = root_size + node * node_size;
+        std::fill_n (entries.begin () + base, node_size, entries[slot]);
+        std::fill_n (owners.begin () + base,  node_size, owners[slot]);
+        entries[slot] = node | child_flag;
+      }
+      return root_size + ((entries[slot] & ~child_flag) << 8) + byte;
+    }
+
+    /// @brief Writes entry/owner into every value slot covered by the prefix whose owner length is in [min_owner, max_owner].
+    /// @param path - If not null, receives the parent slots of the nodes walked through (for erase).
+    void _paint (const prefix_type& prefix, uint32_t entry, uint8_t owner, uint8_t min_owner, uint8_t max_owner, std::vector<uint32_t>* path) {
+
+      const ip_type& ip = prefix.ip;
+
+      uint32_t first;
+      uint32_t count;
+      if (prefix.length <= root_bits) {
+        first = ((uint32_t)ip[0] << 8) | ip[1];
+        count = 1u << (root_bits - prefix.length);
+      }
+      else {
+        uint32_t slot = ((uint32_t)ip[0] << 8) | ip[1];
+        uint32_t bits = root_bits;
+        size_t   byte = 2;
+        while (true) {
+          if (path) {
+            if ((entries[slot] & child_flag) == 0) return; // erase: the prefix was never painted below this slot
+            path->push_back (slot);
+          }
+          if (prefix.length <= bits + 8) {
+            first = _child (slot, ip[byte]);
+            count = 1u << (bits + 8 - prefix.length);
+            break;
+          }
+          slot  = _child (slot, ip[byte++]);
+          bits += 8;
+        }
+      }
+
+      for (uint32_t i = 0; i < count; i++)
+        _fill (first + i, entry, owner, min_owner, max_owner);
+    }
+
+    /// @brief Updates one slot, descending into its child node if it has one.
+    void _fill (uint32_t slot, uint32_t entry, uint8_t owner, uint8_t min_owner, uint8_t max_owner) {
+      if (entries[slot] & child_flag) {
+        uint32_t base = root_size + ((entries[slot] & ~child_flag) << 8);
+        for (uint32_t i = 0; i < node_size; i++)
+          _fill (base + i, entry, owner, min_owner, max_owner);
+      }
+      else if (min_owner <= owners[slot] && owners[slot] <= max_owner) {
+        entries[slot] = entry;
+        owners[slot]  = owner;
+      }
+    }
+
+  };
+
+} // namespace ipsockets
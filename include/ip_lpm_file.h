@@ -0,0 +1,371 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_lpm.h"
+
+#include <algorithm> // std::max
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32 // WINDOWS OS
+  #ifndef NOMINMAX
+    #define NOMINMAX
+  #endif
+  #include <windows.h>
+#else         // LINUX OS
+  #include <fcntl.h>    // Needed for open()
+  #include <sys/mman.h> // Needed for mmap()
+  #include <sys/stat.h> // Needed for fstat()
+  #include <unistd.h>   // Needed for close()
+#endif
+
+namespace ipsockets {
+
+  // ============================================================
+  // compiled lpm file — immutable, pointer-free lpm_table_t image that is queried in place (e.g. mmap'ed)
+  // ============================================================
+
+  // file layout, every section starts at a multiple of 64 bytes:
+  //   lpm_file_header_t
+  //   entries  - uint32_t[entry_count]: root slots then 256-slot nodes, same encoding as lpm_table_t
+  //   values   - Value[value_count], Value must be trivially copyable
+  //   prefixes - value_count packed ip_prefix_raw_t records (1 length byte + ceil(length / 8) bytes), record i belongs to value i
+  // numbers are stored in the byte order of the machine that compiled the file, lpm_view_t rejects a foreign byte order
+
+  struct lpm_file_header_t {
+    char     magic[8];        ///< "IPLPM\0\0\0"
+    uint32_t version;         ///< lpm_file_version
+    uint32_t byte_order;      ///< 0x01020304 written in the compiler byte order
+    uint32_t ip_type;         ///< 4 or 16 (ip_type_e)
+    uint32_t value_size;      ///< sizeof (Value)
+    uint64_t entry_count;
+    uint64_t value_count;
+    uint64_t entries_offset;
+    uint64_t values_offset;
+    uint64_t prefixes_offset;
+    uint64_t prefixes_size;   ///< Bytes in the prefix section
+    uint64_t file_size;
+  };
+
+  static const uint32_t lpm_file_version = 1;
+
+  /// @brief Serializes a table into the compiled lpm format.
+  /// @param table - Source table.
+  /// @param out   - Receives the file image.
+  template <ip_type_e Ip_type, class Value>
+  inline void lpm_compile (const lpm_table_t<Ip_type, Value>& table, std::vector<uint8_t>& out) {
+
+    static_assert (std::is_trivially_copyable<Value>::value, "compiled lpm values must be trivially copyable");
+    static_assert (alignof (Value) <= 64, "compiled lpm values must not need more than 64 byte alignment");
+
+    std::vector<uint32_t>           entries;
+    std::vector<Value>              values;
+    std::vector<prefix_t<Ip_type>>  prefixes;
+    table.export_compact (entries, values, prefixes);
+
+    auto align = [] (uint64_t offset) { return (offset + 63) & ~(uint64_t)63; };
+
+    lpm_file_header_t header = {};
+    std::memcpy (header.magic, "IPLPM\0\0\0", 8);
+    header.version         = lpm_file_version;
+    header.byte_order      = 0x01020304;
+    header.ip_type         = (uint32_t)Ip_type;
+    header.value_size      = (uint32_t)sizeof (Value);
+    header.entry_count     = entries.size ();
+    header.value_count     = values.size ();
+    header.entries_offset  = align (sizeof (lpm_file_header_t));
+    header.values_offset   = align (header.entries_offset + entries.size () * sizeof (uint32_t));
+    header.prefixes_offset = align (header.values_offset + values.size () * sizeof (Value));
+    for (const prefix_t<Ip_type>& prefix : prefixes)
+      header.prefixes_size += static_cast<const ip_prefix_raw_t&> (prefix).size ();
+    header.file_size       = header.prefixes_offset + header.prefixes_size;
+
+    out.assign ((size_t)header.file_size, 0);
+    std::memcpy (out.data (), &header, sizeof (header));
+    std::memcpy (out.data () + header.entries_offset, entries.data (), entries.size () * sizeof (uint32_t));
+    if (!values.empty ())
+      std::memcpy (out.data () + header.values_offset, values.data (), values.size () * sizeof (Value));
+    uint8_t* record = out.data () + header.prefixes_offset;
+    for (const prefix_t<Ip_type>& prefix : prefixes) {
+      const ip_prefix_raw_t& raw = prefix;
+      std::memcpy (record, &raw, raw.size ());
+      record += raw.size ();
+    }
+  }
+
+  /// @brief Compiles a table into a file; the file is written under a temporary name and renamed,
+  ///   so processes that map the old file keep a consistent copy.
+  /// @return true on success.
+  template <ip_type_e Ip_type, class Value>
+  inline bool lpm_compile (const lpm_table_t<Ip_type, Value>& table, const std::string& path) {
+
+    std::vector<uint8_t> image;
+    lpm_compile (table, image);
+
+    std::string temp = path + ".tmp";
+    std::FILE*  file = std::fopen (temp.c_str (), "wb");
+    if (file == nullptr)
+      return false;
+    bool written = std::fwrite (image.data (), 1, image.size (), file) == image.size ();
+    written      = (std::fclose (file) == 0) && written;
+    if (written) {
+      #ifdef _WIN32 // WINDOWS OS
+        written = MoveFileExA (temp.c_str (), path.c_str (), MOVEFILE_REPLACE_EXISTING) != 0;
+      #else         // LINUX OS
+        written = std::rename (temp.c_str (), path.c_str ()) == 0;
+      #endif
+    }
+    if (!written)
+      std::remove (temp.c_str ());
+    return written;
+  }
+
+  // ============================================================
+  // lpm_view_t — queries a compiled lpm image in place
+  // ============================================================
+
+  /// @brief Read-only longest-prefix-match over a compiled image (memory buffer or mapped file), no copying.
+  /// @details The image must stay alive and unchanged while the view is used. Lookup is the same walk as
+  ///   lpm_table_t::lookup(). Safe for any number of concurrent readers.
+  ///
+  /// @code
+  ///   lpm_file_t<v4, uint32_t> routes;
+  ///   if (routes.open ("/var/lib/routes.lpm")) {
+  ///     const uint32_t* next_hop = routes.view.lookup ("10.1.2.3");
+  ///   }
+  /// @endcode
+  template <ip_type_e Ip_type, class Value>
+  struct lpm_view_t {
+
+    using prefix_type = prefix_t<Ip_type>;
+    using ip_type     = ip_t<Ip_type>;
+    using table_type  = lpm_table_t<Ip_type, Value>;
+
+    lpm_view_t () = default;
+
+    ///	@brief Attaches the view to an image, see attach().
+    lpm_view_t (const void* data, size_t size) {
+      attach (data, size);
+    }
+
+    ///	@brief Checks the header and section bounds and attaches the view to an image.
+    ///	@param data - Image start, must be aligned to 64 bytes (page-aligned for mapped files).
+    ///	@param size - Image size in bytes.
+    ///	@return true if the image is a compiled table of this Ip_type/Value for this byte order.
+    bool attach (const void* data, size_t size) {
+
+      static_assert (std::is_trivially_copyable<Value>::value, "compiled lpm values must be trivially copyable");
+
+      detach ();
+      const uint8_t* bytes = (const uint8_t*)data;
+      if (bytes == nullptr || size < sizeof (lpm_file_header_t) || ((uintptr_t)bytes & 63) != 0)
+        return false;
+
+      const lpm_file_header_t& header = *(const lpm_file_header_t*)bytes;
+      if (std::memcmp (header.magic, "IPLPM\0\0\0", 8) != 0 || header.version != lpm_file_version ||
+          header.byte_order != 0x01020304 || header.ip_type != (uint32_t)Ip_type || header.value_size != sizeof (Value) ||
+          header.file_size != size)
+        return false;
+
+      if (header.entry_count > size / sizeof (uint32_t) || header.value_count > size / sizeof (Value) || header.prefixes_size > size ||
+          header.entries_offset > size || header.values_offset > size || header.prefixes_offset > size)
+        return false;
+
+      if (header.entry_count < table_type::root_size || (header.entry_count - table_type::root_size) % table_type::node_size != 0 ||
+          header.value_count >= table_type::child_flag ||
+          header.entries_offset < sizeof (lpm_file_header_t) || header.entries_offset % 64 != 0 ||
+          header.values_offset % 64 != 0 ||
+          header.entries_offset + header.entry_count * sizeof (uint32_t) > header.values_offset ||
+          header.values_offset + header.value_count * sizeof (Value) > header.prefixes_offset ||
+          header.prefixes_offset + header.prefixes_size != size)
+        return false;
+
+      entries     = (const uint32_t*)(bytes + header.entries_offset);
+      values      = (const Value*)(bytes + header.values_offset);
+      prefixes    = bytes + header.prefixes_offset;
+      entry_count = (size_t)header.entry_count;
+      value_count = (size_t)header.value_count;
+      prefix_size = (size_t)header.prefixes_size;
+      return true;
+    }
+
+    ///	@brief Detaches the view from its image.
+    void detach () {
+      entries     = nullptr;
+      values      = nullptr;
+      prefixes    = nullptr;
+      entry_count = value_count = prefix_size = 0;
+    }
+
+    ///	@brief Walks the whole trie and checks that every slot refers to an existing node or value and that no path
+    ///	  is deeper than the address; call once on images from untrusted sources before lookup().
+    bool verify () const {
+      if (entries == nullptr)
+        return false;
+      const size_t node_count = (entry_count - table_type::root_size) / table_type::node_size;
+      const size_t max_depth  = Ip_type - 2; // bytes after the 16 root bits
+      std::vector<uint8_t> depth (node_count, 0);
+      for (size_t i = 0; i < entry_count; i++) {
+        size_t   level = (i < table_type::root_size) ? 0 : depth[(i - table_type::root_size) / table_type::node_size];
+        uint32_t entry = entries[i];
+        if (entry & table_type::child_flag) {
+          size_t node = entry & ~table_type::child_flag;
+          // breadth-first numbering: a child comes after the slot that refers to it
+          if (node >= node_count || table_type::root_size + node * table_type::node_size <= i || level + 1 > max_depth)
+            return false;
+          depth[node] = (uint8_t)std::max<size_t> (depth[node], level + 1);
+        }
+        else if (entry > value_count)
+          return false;
+      }
+      return true;
+    }
+
+    ///	@brief Finds the value of the longest prefix that contains the address, nullptr if none (or not attached).
+    const Value* lookup (const ip_type& ip) const {
+      if (entries == nullptr)
+        return nullptr;
+      uint32_t entry = entries[((uint32_t)ip[0] << 8) | ip[1]];
+      size_t   byte  = 2;
+      while (entry & table_type::child_flag)
+        entry = entries[table_type::root_size + ((entry & ~table_type::child_flag) << 8) + ip[byte++]];
+      return entry ? &values[entry - 1] : nullptr;
+    }
+
+    ///	@brief Calls fn (const prefix_type&, const Value&) for every prefix, ordered by length then address.
+    template <class Fn>
+    void for_each (Fn fn) const {
+      const uint8_t* record = prefixes;
+      const uint8_t* end    = prefixes + prefix_size;
+      for (size_t i = 0; i < value_count && record < end; i++) {
+        const ip_prefix_raw_t& raw = *(const ip_prefix_raw_t*)record;
+        if (raw.length > prefix_type::max_length || record + raw.size () > end)
+          break;
+        fn (prefix_type (raw), values[i]);
+        record += raw.size ();
+      }
+    }
+
+    ///	@brief Rebuilds a mutable table from the image (e.g. to apply updates and compile again).
+    void load (table_type& table) const {
+      table.clear ();
+      for_each ([&] (const prefix_type& prefix, const Value& value) { table.insert (prefix, value); });
+    }
+
+    bool   valid () const { return entries != nullptr; } ///< @brief Returns true if the view is attached to an image.
+    size_t size ()  const { return value_count; }        ///< @brief Returns the number of prefixes in the image.
+
+  protected:
+
+    const uint32_t* entries     = nullptr;
+    const Value*    values      = nullptr;
+    const uint8_t*  prefixes    = nullptr;
+    size_t          entry_count = 0;
+    size_t          value_count = 0;
+    size_t          prefix_size = 0;
+  };
+
+  // ============================================================
+  // lpm_file_t — compiled lpm file mapped read-only into memory
+  // ============================================================
+
+  /// @brief Maps a compiled lpm file read-only and exposes it through an lpm_view_t.
+  /// @details Every process that maps the same file shares one copy in the page cache, so workers start
+  ///   without building the table. Replace the file with lpm_compile() (atomic rename) and call open() again
+  ///   to pick up a new version; the old mapping stays valid until close().
+  template <ip_type_e Ip_type, class Value>
+  struct lpm_file_t {
+
+    lpm_view_t<Ip_type, Value> view; ///< Valid while the file is open
+
+    lpm_file_t () = default;
+    lpm_file_t (const lpm_file_t&) = delete;
+    lpm_file_t& operator= (const lpm_file_t&) = delete;
+
+    ~lpm_file_t () {
+      close ();
+    }
+
+    ///	@brief Maps the file and attaches the view.
+    ///	@param path   - Compiled lpm file.
+    ///	@param verify - Also run lpm_view_t::verify() (one pass over the trie). Default: true.
+    ///	@return true on success; on failure the previous mapping (if any) is already closed.
+    bool open (const std::string& path, bool verify = true) {
+
+      close ();
+
+      #ifdef _WIN32 // WINDOWS OS
+        file = CreateFileA (path.c_str (), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+          return false;
+        LARGE_INTEGER file_size;
+        if (!GetFileSizeEx (file, &file_size) || file_size.QuadPart == 0) {
+          close ();
+          return false;
+        }
+        size    = (size_t)file_size.QuadPart;
+        mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        data    = mapping ? MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+      #else         // LINUX OS
+        int fd = ::open (path.c_str (), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+          return false;
+        struct stat info;
+        if (fstat (fd, &info) == -1 || info.st_size == 0) {
+          ::close (fd);
+          return false;
+        }
+        size = (size_t)info.st_size;
+        data = mmap (nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close (fd); // the mapping keeps the file referenced
+        if (data == MAP_FAILED)
+          data = nullptr;
+      #endif
+
+      if (data == nullptr || !view.attach (data, size) || (verify && !view.verify ())) {
+        close ();
+        return false;
+      }
+      return true;
+    }
+
+    ///	@brief Detaches the view and unmaps the file.
+    void close () {
+      view.detach ();
+      #ifdef _WIN32 // WINDOWS OS
+        if (data)                         UnmapViewOfFile (data);
+        if (mapping)                      CloseHandle (mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle (file);
+        mapping = nullptr;
+        file    = INVALID_HANDLE_VALUE;
+      #else         // LINUX OS
+        if (data)
+          munmap (data, size);
+      #endif
+      data = nullptr;
+      size = 0;
+    }
+
+  protected:
+
+    void*  data = nullptr;
+    size_t size = 0;
+    #ifdef _WIN32 // WINDOWS OS
+      HANDLE file    = INVALID_HANDLE_VALUE;
+      HANDLE mapping = nullptr;
+    #endif
+  };
+
+} // namespace ipsockets
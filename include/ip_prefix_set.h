@@ -0,0 +1,298 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_address.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace ipsockets {
+
+  namespace prefix_set_detail {
+
+    // range arithmetic on the numeric form of an address: uint32_t for ipv4, u128_t for ipv6 (see ip_number_t)
+
+    template <ip_type_e Ip_type>
+    struct number {
+      using type = ip_number_t<Ip_type>;
+      static const int bits = (Ip_type == v4) ? 32 : 128;
+      static type          load  (const ip_t<Ip_type>& ip)   { return ip.to_number (); }
+      static ip_t<Ip_type> store (const type& value)         { return ip_t<Ip_type> (value); }
+      static type          max   ()                          { return ~type (0); }
+      static type          inc   (const type& value)         { return value + type (1); }
+      static type          dec   (const type& value)         { return value - type (1); }
+      static type          low   (const type& value, int count) { return count >= bits ? max () : value | ((type (1) << count) - type (1)); } // value with 'count' low bits set
+      static int           tail  (const type& value)         { return countr_zero (value); } // trailing zero bits
+      static int           width (const type& first, const type& last) { // log2 of the biggest power of two <= last - first + 1
+        type span = last - first;
+        return (span == max ()) ? bits : bit_width (type (span + type (1))) - 1;
+      }
+    };
+
+  } // namespace prefix_set_detail
+
+  // ============================================================
+  // prefix_set_t — normalized set of addresses with prefix/range conversion and set algebra
+  // ============================================================
+
+  /// @brief Set of ip addresses stored as sorted, disjoint, non-adjacent inclusive ranges.
+  /// @details Building from n prefixes or ranges sorts once (O(n log n)); union, intersection and difference
+  ///   are linear merges of two sorted lists. prefixes() returns the minimal CIDR list covering exactly the set,
+  ///   i.e. overlapping and adjacent prefixes are aggregated.
+  ///   add() only appends; the set is normalized on the next read. Reading a set with pending add() calls
+  ///   from several threads at once is not safe.
+  ///
+  /// @code
+  ///   prefix_set_t<v4> allow ({ "10.0.0.0/25", "10.0.0.128/25", "10.0.1.0/24" });
+  ///   allow.prefixes ();                                // { 10.0.0.0/23 }
+  ///   prefix_set_t<v4> deny ({ "10.0.0.64/26" });
+  ///   (allow - deny).prefixes ();                       // { 10.0.0.0/26, 10.0.0.128/25, 10.0.1.0/24 }
+  ///   prefix_set_t<v4>::range_to_prefixes ("10.0.0.1", "10.0.0.6"); // { .1/32, .2/31, .4/31, .6/32 }
+  /// @endcode
+  template <ip_type_e Ip_type>
+  struct prefix_set_t {
+
+    using prefix_type = prefix_t<Ip_type>;
+    using ip_type     = ip_t<Ip_type>;
+
+    struct range_t {
+      ip_type first; ///< First address of the range
+      ip_type last;  ///< Last address of the range (inclusive)
+
+      bool operator== (const range_t& other) const { return first == other.first && last == other.last; }
+    };
+
+    prefix_set_t () = default;
+
+    ///	@brief Builds the set from prefixes.
+    prefix_set_t (const std::vector<prefix_type>& prefixes) {
+      for (const prefix_type& prefix : prefixes)
+        add (prefix);
+    }
+
+    ///	@brief Builds the set from prefixes.
+    prefix_set_t (std::initializer_list<prefix_type> prefixes) {
+      for (const prefix_type& prefix : prefixes)
+        add (prefix);
+    }
+
+    ///	@brief Builds the set from ranges (first > last ranges are ignored).
+    prefix_set_t (const std::vector<range_t>& ranges) {
+      for (const range_t& range : ranges)
+        add (range.first, range.last);
+    }
+
+    ///	@brief Adds all addresses of a prefix.
+    prefix_set_t& add (const prefix_type& prefix) {
+      range_t range = prefix_to_range (prefix);
+      return add (range.first, range.last);
+    }
+
+    ///	@brief Adds the addresses [first, last]; nothing is added if first > last.
+    prefix_set_t& add (const ip_type& first, const ip_type& last) {
+      if (!(last < first)) {
+        items.push_back (_range (num::load (first), num::load (last)));
+        sorted = false;
+      }
+      return *this;
+    }
+
+    ///	@brief Returns the normalized ranges: sorted, disjoint, with gaps between them.
+    std::vector<range_t> ranges () const {
+      _normalize ();
+      std::vector<range_t> result;
+      result.reserve (items.size ());
+      for (const item_t& item : items)
+        result.push_back (range_t { num::store (item.first), num::store (item.last) });
+      return result;
+    }
+
+    ///	@brief Returns the minimal list of prefixes covering exactly this set, sorted by address.
+    std::vector<prefix_type> prefixes () const {
+      _normalize ();
+      std::vector<prefix_type> result;
+      for (const item_t& item : items)
+        _append_prefixes (item.first, item.last, result);
+      return result;
+    }
+
+    ///	@brief Returns true if the address belongs to the set (binary search).
+    bool contains (const ip_type& ip) const {
+      _normalize ();
+      value_t value = num::load (ip);
+      typename std::vector<item_t>::const_iterator it =
+        std::upper_bound (items.begin (), items.end (), value, [] (const value_t& v, const item_t& item) { return v < item.first; });
+      return it != items.begin () && value <= (it - 1)->last;
+    }
+
+    ///	@brief Returns true if every address of the prefix belongs to the set.
+    bool contains (const prefix_type& prefix) const {
+      _normalize ();
+      range_t range = prefix_to_range (prefix);
+      value_t first = num::load (range.first), last = num::load (range.last);
+      typename std::vector<item_t>::const_iterator it =
+        std::upper_bound (items.begin (), items.end (), first, [] (const value_t& v, const item_t& item) { return v < item.first; });
+      return it != items.begin () && last <= (it - 1)->last;
+    }
+
+    bool   empty () const { _normalize (); return items.empty (); } ///< @brief Returns true if the set has no addresses.
+    size_t size ()  const { _normalize (); return items.size (); }  ///< @brief Returns the number of normalized ranges.
+
+    ///	@brief Returns the addresses that are in this set or in the other.
+    prefix_set_t unite (const prefix_set_t& other) const {
+      _normalize ();
+      other._normalize ();
+      prefix_set_t result;
+      result.items.resize (items.size () + other.items.size ());
+      std::merge (items.begin (), items.end (), other.items.begin (), other.items.end (), result.items.begin (),
+                  [] (const item_t& a, const item_t& b) { return a.first < b.first; });
+      result._merge ();
+      return result;
+    }
+
+    ///	@brief Returns the addresses that are in both sets.
+    prefix_set_t intersect (const prefix_set_t& other) const {
+      _normalize ();
+      other._normalize ();
+      prefix_set_t result;
+      size_t i = 0, j = 0;
+      while (i < items.size () && j < other.items.size ()) {
+        const item_t& a = items[i];
+        const item_t& b = other.items[j];
+        value_t first = (a.first < b.first) ? b.first : a.first;
+        value_t last  = (a.last  < b.last)  ? a.last  : b.last;
+        if (first <= last)
+          result.items.push_back (_range (first, last));
+        if (a.last < b.last) i++;
+        else                 j++;
+      }
+      return result;
+    }
+
+    ///	@brief Returns the addresses of this set that are not in the other.
+    prefix_set_t subtract (const prefix_set_t& other) const {
+      _normalize ();
+      other._normalize ();
+      prefix_set_t result;
+      size_t j = 0;
+      for (const item_t& a : items) {
+        value_t first = a.first;
+        bool    done  = false;
+        while (j < other.items.size () && other.items[j].last < first)
+          j++;
+        for (size_t k = j; k < other.items.size () && other.items[k].first <= a.last; k++) {
+          const item_t& b = other.items[k];
+          if (first < b.first)
+            result.items.push_back (_range (first, num::dec (b.first)));
+          if (a.last <= b.last) {
+            done = true;
+            break;
+          }
+          first = num::inc (b.last);
+        }
+        if (!done)
+          result.items.push_back (_range (first, a.last));
+      }
+      return result;
+    }
+
+    prefix_set_t operator| (const prefix_set_t& other) const { return unite (other); }     ///< @brief Union.
+    prefix_set_t operator& (const prefix_set_t& other) const { return intersect (other); } ///< @brief Intersection.
+    prefix_set_t operator- (const prefix_set_t& other) const { return subtract (other); }  ///< @brief Difference.
+
+    bool operator== (const prefix_set_t& other) const {
+      _normalize ();
+      other._normalize ();
+      return items.size () == other.items.size () &&
+             std::equal (items.begin (), items.end (), other.items.begin (),
+                         [] (const item_t& a, const item_t& b) { return a.first == b.first && a.last == b.last; });
+    }
+
+    bool operator!= (const prefix_set_t& other) const { return !(*this == other); }
+
+    ///	@brief Returns the first and the last address of a prefix.
+    static range_t prefix_to_range (const prefix_type& prefix) {
+      value_t first = num::load (prefix.network ());
+      return range_t { num::store (first), num::store (num::low (first, num::bits - prefix.length)) };
+    }
+
+    ///	@brief Returns the minimal list of prefixes covering exactly [first, last], empty if first > last.
+    static std::vector<prefix_type> range_to_prefixes (const ip_type& first, const ip_type& last) {
+      std::vector<prefix_type> result;
+      if (!(last < first))
+        _append_prefixes (num::load (first), num::load (last), result);
+      return result;
+    }
+
+  protected:
+
+    using num     = prefix_set_detail::number<Ip_type>;
+    using value_t = typename num::type;
+
+    struct item_t {
+      value_t first;
+      value_t last;
+    };
+
+    mutable std::vector<item_t> items;         ///< Ranges in numeric form
+    mutable bool                sorted = true; ///< items are normalized
+
+    static item_t _range (value_t first, value_t last) {
+      item_t item;
+      item.first = first;
+      item.last  = last;
+      return item;
+    }
+
+    void _normalize () const {
+      if (sorted)
+        return;
+      std::sort (items.begin (), items.end (), [] (const item_t& a, const item_t& b) { return a.first < b.first; });
+      _merge ();
+    }
+
+    /// @brief Merges overlapping and adjacent ranges of a list sorted by first address.
+    void _merge () const {
+      size_t out = 0;
+      for (size_t i = 0; i < items.size (); i++) {
+        if (out > 0) {
+          item_t& prev = items[out - 1];
+          if (prev.last == num::max () || items[i].first <= num::inc (prev.last)) {
+            if (prev.last < items[i].last)
+              prev.last = items[i].last;
+            continue;
+          }
+        }
+        items[out++] = items[i];
+      }
+      items.resize (out);
+      sorted = true;
+    }
+
+    /// @brief Splits [first, last] into the biggest aligned blocks, left to right.
+    static void _append_prefixes (value_t first, value_t last, std::vector<prefix_type>& out) {
+      while (true) {
+        int size_bits = num::width (first, last);
+        int align     = num::tail (first);
+        int bits      = (align < size_bits) ? align : size_bits;
+        out.push_back (prefix_type (num::store (first), (uint8_t)(num::bits - bits)));
+        value_t end = num::low (first, bits);
+        if (end == last)
+          break;
+        first = num::inc (end);
+      }
+    }
+
+  };
+
+} // namespace ipsockets
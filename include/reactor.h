@@ -0,0 +1,287 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "udp_socket.h"
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <unordered_map>
+
+// epoll is used on Linux, poll()/WSAPoll() everywhere else
+// define IP_SOCKETS_REACTOR_POLL before including this header to force the poll() backend on Linux
+#if defined(__linux__) && !defined(IP_SOCKETS_REACTOR_POLL)
+  #include <sys/epoll.h>
+  #define IP_SOCKETS_REACTOR_EPOLL 1
+#endif
+
+namespace ipsockets {
+
+  // ============================================================
+  // reactor_t — readiness notification for many sockets in one thread
+  // ============================================================
+
+  /// @brief Single-threaded event loop that calls a callback when a registered socket becomes readable/writable.
+  /// @details Registered sockets are switched to non-blocking mode, so callbacks can call recv/recvfrom/accept/send
+  ///   until they return error_would_block (no more data) without ever blocking the loop.
+  ///   Level-triggered: a callback is called again on the next iteration while data remains unread.
+  ///   add/modify/remove must be called from the reactor thread (including from callbacks) or before run();
+  ///   only stop() may be called from another thread.
+  ///
+  /// @code
+  ///   reactor_t reactor;
+  ///   tcp_socket_t<v4, socket_type_e::server> server;
+  ///   server.open ("0.0.0.0:8080");
+  ///   reactor.add (server, reactor_t::ev_read, [&] (uint32_t) {
+  ///     addr4_t from;
+  ///     auto client = server.accept (from);
+  ///     ...
+  ///   });
+  ///   reactor.run ();
+  /// @endcode
+  struct reactor_t {
+
+    enum event_e : uint32_t {
+      ev_read  = 1, ///< Socket has data to read (or pending connection for listening TCP socket)
+      ev_write = 2, ///< Socket has space in the send buffer (or non-blocking connect completed)
+      ev_error = 4  ///< Error or hang-up on the socket (always reported, no need to subscribe)
+    };
+
+    using callback_t = std::function<void (uint32_t events)>; ///< Receives a combination of event_e flags
+
+    static const int max_events = 256; ///< Maximum number of events dispatched per run_once() iteration
+
+    ///	@brief Creates the reactor (epoll instance on Linux).
+    reactor_t () {
+      #ifdef IP_SOCKETS_REACTOR_EPOLL
+        epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+      #endif
+    }
+
+    reactor_t (const reactor_t&) = delete;
+    reactor_t& operator= (const reactor_t&) = delete;
+
+    ~reactor_t () {
+      #ifdef IP_SOCKETS_REACTOR_EPOLL
+        if (epoll_fd != -1)
+          ::close (epoll_fd);
+      #endif
+    }
+
+    ///	@brief Registers an opened socket and switches it to non-blocking mode.
+    ///	@param socket   - Any udp_socket_t/tcp_socket_t object; must stay alive until remove().
+    ///	@param events   - Combination of ev_read/ev_write.
+    ///	@param callback - Called from run()/run_once() with the ready events.
+    ///	@return Error code:
+    ///	  - no_error on success
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_already_opened if socket already registered
+    ///	  - error_other if the OS call failed
+    template <class Socket>
+    int add (Socket& socket, uint32_t events, callback_t callback) {
+
+      if (socket.state != state_e::opened) return error_closed_or_not_open;
+      if (entries.count (socket.sock))     return error_already_opened;
+
+      bool was_nonblocking = socket.nonblocking;
+      if (!was_nonblocking && socket.set_nonblocking (true) != no_error)
+        return error_other;
+
+      #ifdef IP_SOCKETS_REACTOR_EPOLL
+        epoll_event ev = {};
+        ev.events  = _to_epoll (events);
+        ev.data.fd = socket.sock;
+        if (epoll_ctl (epoll_fd, EPOLL_CTL_ADD, socket.sock, &ev) == -1) {
+          if (!was_nonblocking) socket.set_nonblocking (false);
+          return error_other;
+        }
+      #endif
+
+      entry_t& entry        = entries[socket.sock];
+      entry.callback        = std::make_shared<callback_t> (std::move (callback));
+      entry.events          = events;
+      entry.was_nonblocking = was_nonblocking;
+      poll_dirty            = true;
+      return no_error;
+    }
+
+    ///	@brief Changes the set of events a registered socket is waiting for (e.g. enable ev_write while output is queued).
+    ///	@return no_error, error_closed_or_not_open if socket is not registered, error_other if the OS call failed.
+    template <class Socket>
+    int modify (Socket& socket, uint32_t events) {
+
+      typename entries_t::iterator it = entries.find (socket.sock);
+      if (it == entries.end ()) return error_closed_or_not_open;
+
+      #ifdef IP_SOCKETS_REACTOR_EPOLL
+        epoll_event ev = {};
+        ev.events  = _to_epoll (events);
+        ev.data.fd = socket.sock;
+        if (epoll_ctl (epoll_fd, EPOLL_CTL_MOD, socket.sock, &ev) == -1)
+          return error_other;
+      #endif
+
+      it->second.events = events;
+      poll_dirty        = true;
+      return no_error;
+    }
+
+    ///	@brief Unregisters a socket and restores its previous blocking mode. Must be called before closing the socket.
+    ///	@return no_error, or error_closed_or_not_open if socket is not registered.
+    template <class Socket>
+    int remove (Socket& socket) {
+
+      typename entries_t::iterator it = entries.find (socket.sock);
+      if (it == entries.end ()) return error_closed_or_not_open;
+
+      #ifdef IP_SOCKETS_REACTOR_EPOLL
+        epoll_event ev = {}; // non-null pointer required by kernels before 2.6.9
+        epoll_ctl (epoll_fd, EPOLL_CTL_DEL, socket.sock, &ev);
+      #endif
+
+      if (!it->second.was_nonblocking && socket.state == state_e::opened)
+        socket.set_nonblocking (false);
+      entries.erase (it);
+      poll_dirty = true;
+      return no_error;
+    }
+
+    ///	@brief Waits for events at most timeout_ms and dispatches callbacks of ready sockets.
+    ///	@param timeout_ms - Maximum wait time in milliseconds, 0 = just check, -1 = wait forever.
+    ///	@return Number of dispatched callbacks (>= 0), or error_other if the OS call failed.
+    int run_once (int timeout_ms) {
+
+      int dispatched = 0;
+
+      #ifdef IP_SOCKETS_REACTOR_EPOLL
+        epoll_event ready[max_events];
+        int n = epoll_wait (epoll_fd, ready, max_events, timeout_ms);
+        if (n == -1)
+          return (errno == EINTR) ? 0 : error_other;
+        for (int i = 0; i < n; i++)
+          dispatched += _dispatch (ready[i].data.fd, _from_epoll (ready[i].events));
+      #else
+        if (poll_dirty) {
+          poll_fds.clear ();
+          for (typename entries_t::value_type& entry : entries) {
+            pollfd_t pfd = {};
+            pfd.fd       = entry.first;
+            pfd.events   = _to_poll (entry.second.events);
+            poll_fds.push_back (pfd);
+          }
+          poll_dirty = false;
+        }
+        if (poll_fds.empty ()) {
+          if (timeout_ms > 0) std::this_thread::sleep_for (std::chrono::milliseconds (timeout_ms));
+          return 0;
+        }
+        #ifdef _WIN32 // WINDOWS OS
+          int n = WSAPoll (poll_fds.data (), (ULONG)poll_fds.size (), timeout_ms);
+        #else         // OTHER POSIX OS
+          int n = poll (poll_fds.data (), (nfds_t)poll_fds.size (), timeout_ms);
+        #endif
+        #ifdef _WIN32 // WINDOWS OS
+          if (n == SOCKET_ERROR) return (WSAGetLastError () == WSAEINTR) ? 0 : error_other;
+        #else         // OTHER POSIX OS
+          if (n == SOCKET_ERROR) return (errno == EINTR) ? 0 : error_other;
+        #endif
+        // callbacks may add/remove sockets, so iterate over a snapshot of ready descriptors
+        ready_fds.clear ();
+        for (pollfd_t& pfd : poll_fds)
+          if (pfd.revents != 0)
+            ready_fds.emplace_back (pfd.fd, _from_poll (pfd.revents));
+        for (std::pair<socket_t, uint32_t>& ready : ready_fds)
+          dispatched += _dispatch (ready.first, ready.second);
+      #endif
+
+      return dispatched;
+    }
+
+    ///	@brief Runs the event loop until stop() is called.
+    ///	@param interval_ms - Maximum time of one wait; stop() from another thread is noticed within this interval. Default: 500.
+    void run (int interval_ms = 500) {
+      stopped = false;
+      while (!stopped)
+        if (run_once (interval_ms) < 0)
+          break;
+    }
+
+    ///	@brief Asks run() to return; safe to call from callbacks and from other threads.
+    void stop () {
+      stopped = true;
+    }
+
+    size_t size () const { return entries.size (); } ///< @brief Returns the number of registered sockets.
+
+  protected:
+
+    struct entry_t {
+      std::shared_ptr<callback_t> callback;                ///< Shared so a callback may remove its own socket while running
+      uint32_t                    events          = 0;     ///< Subscribed event_e flags
+      bool                        was_nonblocking = false; ///< Blocking mode of the socket before add()
+    };
+
+    using entries_t = std::unordered_map<socket_t, entry_t>;
+
+    entries_t         entries;          ///< Registered sockets by OS descriptor
+    std::atomic<bool> stopped { false };
+    bool              poll_dirty = true; ///< poll() backend: descriptor array must be rebuilt
+
+    #ifdef IP_SOCKETS_REACTOR_EPOLL
+      int epoll_fd = -1;
+    #else
+      #ifdef _WIN32 // WINDOWS OS
+        using pollfd_t = WSAPOLLFD;
+      #else         // OTHER POSIX OS
+        using pollfd_t = pollfd;
+      #endif
+      std::vector<pollfd_t>                     poll_fds;
+      std::vector<std::pair<socket_t, uint32_t>> ready_fds;
+    #endif
+
+    /// @brief Calls the callback registered for the descriptor, if it is still registered.
+    int _dispatch (socket_t fd, uint32_t events) {
+      typename entries_t::iterator it = entries.find (fd);
+      if (it == entries.end ())
+        return 0;
+      events &= it->second.events | ev_error;
+      if (events == 0)
+        return 0;
+      std::shared_ptr<callback_t> callback = it->second.callback; // keep alive if callback removes its socket
+      (*callback) (events);
+      return 1;
+    }
+
+    #ifdef IP_SOCKETS_REACTOR_EPOLL
+      static uint32_t _to_epoll (uint32_t events) {
+        return ((events & ev_read) ? (uint32_t)EPOLLIN : 0u) | ((events & ev_write) ? (uint32_t)EPOLLOUT : 0u);
+      }
+
+      static uint32_t _from_epoll (uint32_t events) {
+        return ((events & EPOLLIN) ? (uint32_t)ev_read : 0u) | ((events & EPOLLOUT) ? (uint32_t)ev_write : 0u) |
+               ((events & (EPOLLERR | EPOLLHUP)) ? (uint32_t)ev_error : 0u);
+      }
+    #else
+      static short _to_poll (uint32_t events) {
+        return (short)(((events & ev_read) ? POLLIN : 0) | ((events & ev_write) ? POLLOUT : 0));
+      }
+
+      static uint32_t _from_poll (short events) {
+        return ((events & POLLIN) ? (uint32_t)ev_read : 0u) | ((events & POLLOUT) ? (uint32_t)ev_write : 0u) |
+               ((events & (POLLERR | POLLHUP | POLLNVAL)) ? (uint32_t)ev_error : 0u);
+      }
+    #endif
+
+  };
+
+} // namespace ipsockets
@@ -0,0 +1,209 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "udp_socket.h"
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
+#ifdef _WIN32 // WINDOWS OS
+  // SetThreadAffinityMask() is declared in windows.h, which is already pulled in by winsock2.h
+#else         // LINUX OS
+  #include <pthread.h> // Needed for pthread_setaffinity_np() to pin worker threads
+  #include <sched.h>   // Needed for cpu_set_t
+  #if defined(__linux__)
+    #include <linux/filter.h> // Needed for classic BPF program (sock_filter, sock_fprog, SKF_AD_CPU)
+    #ifndef SO_ATTACH_REUSEPORT_CBPF
+      #define SO_ATTACH_REUSEPORT_CBPF 51 // available since linux 4.5, older headers may not define it
+    #endif
+  #endif
+#endif
+
+namespace ipsockets {
+
+  // ============================================================
+  // reuseport_group_t — N server sockets on one address, one worker thread per socket/CPU
+  // ============================================================
+
+  /// @brief Group of server sockets bound to the same address with SO_REUSEPORT.
+  /// @details The kernel distributes incoming datagrams (UDP) or connections (TCP) between the sockets,
+  ///   so every worker thread has its own receive queue instead of all threads contending for one socket.
+  ///   Optionally a classic BPF program is attached to the group which selects the socket by the number
+  ///   of the CPU that processes the packet (cpu % size), so with pinned workers a packet is handled
+  ///   on the same core where the kernel received it.
+  ///
+  ///   Socket is udp_socket_t<Ip_type, socket_type_e::server> or tcp_socket_t<Ip_type, socket_type_e::server>.
+  ///
+  /// @code
+  ///   reuseport_group_t<udp_socket_t<v4, socket_type_e::server>> group (log_e::info);
+  ///   group.open ("0.0.0.0:2000", 0, 1000, true); // one socket per CPU + CPU steering
+  ///   group.start ([&group] (udp_socket_t<v4, socket_type_e::server>& sock, size_t index) {
+  ///     char buf[1500]; addr4_t from;
+  ///     while (group.running)
+  ///       if (sock.recvfrom (buf, sizeof (buf), from) > 0) { ... }
+  ///   });
+  ///   ...
+  ///   group.stop ();
+  /// @endcode
+  template <class Socket>
+  struct reuseport_group_t {
+
+    using server_t  = Socket;
+    using address_t = typename Socket::address_t;
+    using worker_t  = std::function<void (Socket& sock, size_t index)>; ///< Worker body, runs while running is true
+
+    std::vector<std::unique_ptr<Socket>> sockets;  ///< Opened sockets, index i is served by worker thread i pinned to CPU i
+    std::vector<std::thread>             threads;  ///< Worker threads started by start()
+    std::atomic<bool>                    running { false }; ///< Set by start(), cleared by stop()/close(): workers loop while it is true
+    log_e                                log_level;
+
+    ///	@brief Constructor for the group, sockets are created in open().
+    ///	@param log_level_ - Logging level for every socket in the group (default: log_e::info).
+    reuseport_group_t (log_e log_level_ = log_e::info) : log_level (log_level_) {}
+
+    reuseport_group_t (const reuseport_group_t&) = delete;
+
+    ~reuseport_group_t () {
+      stop ();
+    }
+
+    ///	@brief Opens count server sockets on the same address with SO_REUSEPORT.
+    ///	@param address      - The local address:port to bind to (port must be non-zero, otherwise each socket gets its own port).
+    ///	@param count        - Number of sockets, 0 = one per hardware thread (std::thread::hardware_concurrency()).
+    ///	@param timeout_ms   - Receive timeout of every socket in milliseconds (SO_RCVTIMEO). Default: 1000.
+    ///	@param cpu_steering - Attach BPF program that selects socket by current CPU number (Linux only). Default: false.
+    ///	@return Error code:
+    ///	  - no_error on success
+    ///	  - error_already_opened if group is already opened
+    ///	  - error_open_failed if any socket failed to open (all sockets are closed again)
+    ///	  - error_not_allowed if SO_REUSEPORT or cpu_steering is not supported on this platform
+    int open (const address_t& address, size_t count = 0, uint32_t timeout_ms = 1000, bool cpu_steering = false) {
+
+      if (!sockets.empty ()) return error_already_opened;
+
+      if (count == 0) count = std::thread::hardware_concurrency ();
+      if (count == 0) count = 1;
+
+      for (size_t i = 0; i < count; i++) {
+        sockets.emplace_back (new Socket (log_level));
+        sockets.back ()->reuse_port = true;
+        int res = sockets.back ()->open (address, timeout_ms);
+        if (res != no_error) {
+          close ();
+          return (res == error_not_allowed) ? error_not_allowed : error_open_failed;
+        }
+      }
+
+      if (cpu_steering) {
+        int res = _attach_cpu_steering ();
+        if (res != no_error) {
+          close ();
+          return res;
+        }
+      }
+
+      return no_error;
+    }
+
+    ///	@brief Starts one worker thread per socket.
+    ///	@param worker - Function executed in thread i with sockets[i]; should return when running becomes false
+    ///	  (a blocked recv/accept then fails at once, see stop()).
+    ///	@param pin    - Pin thread i to CPU i (modulo number of CPUs). Default: true.
+    void start (worker_t worker, bool pin = true) {
+      running = true;
+      unsigned cpus = std::thread::hardware_concurrency ();
+      for (size_t i = 0; i < sockets.size (); i++) {
+        threads.emplace_back (worker, std::ref (*sockets[i]), i);
+        if (pin && cpus != 0)
+          _pin_thread (threads.back (), (unsigned)(i % cpus));
+      }
+    }
+
+    ///	@brief Stops the workers and closes all sockets.
+    ///	@details Clears running, shuts the sockets down (this wakes workers blocked in recv/accept, close() alone
+    ///	  does not on Linux), joins the worker threads and only then closes the sockets, so a descriptor is never
+    ///	  released while a worker may still use it.
+    void stop () {
+      _shutdown ();
+      for (std::thread& thread : threads)
+        if (thread.joinable ())
+          thread.join ();
+      threads.clear ();
+      for (std::unique_ptr<Socket>& sock : sockets)
+        sock->close ();
+      sockets.clear ();
+    }
+
+    ///	@brief Stops the workers without waiting for them.
+    ///	@details Without worker threads the sockets are closed at once; otherwise they are only shut down
+    ///	  and closed by stop() (or the destructor) after the workers have returned.
+    void close () {
+      _shutdown ();
+      if (threads.empty ()) {
+        for (std::unique_ptr<Socket>& sock : sockets)
+          sock->close ();
+        sockets.clear ();
+      }
+    }
+
+    size_t size () const { return sockets.size (); } ///< @brief Returns the number of sockets in the group.
+
+  protected:
+
+    /// @brief Clears running and shuts down every socket in both directions to wake up blocked workers.
+    void _shutdown () {
+      running = false;
+      for (std::unique_ptr<Socket>& sock : sockets)
+        if (sock->sock != INVALID_SOCKET)
+          #ifdef _WIN32 // WINDOWS OS
+            ::shutdown (sock->sock, SD_BOTH);
+          #else         // LINUX OS
+            ::shutdown (sock->sock, SHUT_RDWR); // also wakes unconnected UDP and listening TCP sockets, errors are expected
+          #endif
+    }
+
+    /// @brief Attaches classic BPF program "return cpu % size" to the reuseport group (any member socket works).
+    int _attach_cpu_steering () {
+      #if defined(__linux__)
+        sock_filter code[] = {
+          { BPF_LD  | BPF_W   | BPF_ABS, 0, 0, (uint32_t)(SKF_AD_OFF + SKF_AD_CPU) }, // A = current cpu
+          { BPF_ALU | BPF_MOD | BPF_K,   0, 0, (uint32_t)sockets.size ()           }, // A = A % sockets count
+          { BPF_RET | BPF_A,             0, 0, 0                                   }  // return A as socket index
+        };
+        sock_fprog prog = { (unsigned short)(sizeof (code) / sizeof (code[0])), code };
+        int res = setsockopt (sockets.front ()->sock, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, (char*)&prog, sizeof (prog));
+        return (res == SOCKET_ERROR) ? error_not_allowed : no_error;
+      #else
+        return error_not_allowed;
+      #endif
+    }
+
+    /// @brief Pins a thread to one CPU, failures are ignored (thread just stays unpinned).
+    static void _pin_thread (std::thread& thread, unsigned cpu) {
+      #ifdef _WIN32 // WINDOWS OS
+        if (cpu < sizeof (DWORD_PTR) * 8)
+          SetThreadAffinityMask (thread.native_handle (), (DWORD_PTR)1 << cpu);
+      #elif defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO (&set);
+        CPU_SET (cpu, &set);
+        pthread_setaffinity_np (thread.native_handle (), sizeof (cpu_set_t), &set);
+      #else         // MACOS and others do not support hard affinity
+        (void)thread;
+        (void)cpu;
+      #endif
+    }
+
+  };
+
+} // namespace ipsockets
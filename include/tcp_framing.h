@@ -0,0 +1,401 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "tcp_socket.h"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ipsockets {
+
+  // ============================================================
+  // framing_t — how messages are delimited in a TCP byte stream
+  // ============================================================
+
+  /// @brief Message framing: a length prefix (u16/u32 big-endian or varint) before the payload, or a delimiter after it.
+  struct framing_t {
+
+    enum kind_e : uint8_t {
+      length_u16,    ///< 2-byte big-endian length, then payload
+      length_u32,    ///< 4-byte big-endian length, then payload
+      length_varint, ///< LEB128 length (7 bits per byte, low bits first, at most 5 bytes), then payload
+      delimited      ///< Payload, then the delimiter (e.g. "\n" or "\r\n\r\n"); the payload must not contain it
+    };
+
+    kind_e      kind = length_u32;
+    std::string delimiter;        ///< Delimiter of kind delimited
+
+    static framing_t u16 ()                                { return framing_t { length_u16,    std::string () }; }
+    static framing_t u32 ()                                { return framing_t { length_u32,    std::string () }; }
+    static framing_t varint ()                             { return framing_t { length_varint, std::string () }; }
+    static framing_t split (const std::string& delim)     { return framing_t { delimited,     delim }; }
+
+    static const int header_max = 5; ///< Longest length prefix in bytes (varint of a 32-bit length)
+
+    ///	@brief Writes the length prefix of a payload.
+    ///	@return Number of bytes written to out (0 for delimited framing).
+    int encode (uint32_t len, char* out) const {
+      switch (kind) {
+        case length_u16: {
+          uint16_t be = orders::htonT<uint16_t> ((uint16_t)len);
+          memcpy (out, &be, sizeof (be));
+          return (int)sizeof (be);
+        }
+        case length_u32: {
+          uint32_t be = orders::htonT<uint32_t> (len);
+          memcpy (out, &be, sizeof (be));
+          return (int)sizeof (be);
+        }
+        case length_varint: {
+          int n = 0;
+          while (len >= 0x80) {
+            out[n++] = (char)(len | 0x80);
+            len    >>= 7;
+          }
+          out[n++] = (char)len;
+          return n;
+        }
+        default:
+          return 0;
+      }
+    }
+
+    ///	@brief Reads a length prefix from the start of data.
+    ///	@param      data  - Received bytes.
+    ///	@param      avail - Number of bytes at data.
+    ///	@param[out] len   - Payload length.
+    ///	@return Prefix size in bytes, 0 if more bytes are needed, -1 if the prefix is malformed (varint longer than 5 bytes or above 32 bits).
+    int decode (const char* data, std::size_t avail, uint32_t& len) const {
+      switch (kind) {
+        case length_u16: {
+          if (avail < 2) return 0;
+          uint16_t be;
+          memcpy (&be, data, sizeof (be));
+          len = orders::ntohT<uint16_t> (be);
+          return 2;
+        }
+        case length_u32: {
+          if (avail < 4) return 0;
+          uint32_t be;
+          memcpy (&be, data, sizeof (be));
+          len = orders::ntohT<uint32_t> (be);
+          return 4;
+        }
+        case length_varint: {
+          uint32_t value = 0;
+          for (int n = 0; n < header_max; n++) {
+            if ((std::size_t)n >= avail) return 0;
+            uint8_t byte = (uint8_t)data[n];
+            if (n == header_max - 1 && byte > 0x0f) // the 5th byte holds bits 28..31 only
+              return -1;
+            value |= (uint32_t)(byte & 0x7f) << (7 * n);
+            if ((byte & 0x80) == 0) {
+              len = value;
+              return n + 1;
+            }
+          }
+          return -1;
+        }
+        default:
+          return -1;
+      }
+    }
+
+  };
+
+  /// @brief Message returned by frame_reader_t::read(): points into the reader buffer, valid until the next read().
+  struct frame_view_t {
+    const char* data = nullptr; ///< First payload byte
+    std::size_t size = 0;       ///< Payload size (the length prefix or the delimiter is not included)
+  };
+
+  // ============================================================
+  // frame_reader_t — whole messages out of a TCP socket
+  // ============================================================
+
+  /// @brief Splits the byte stream of a connected TCP socket into messages.
+  /// @details Receives into one reusable buffer with a single recv() per call whenever the buffered bytes
+  ///   do not hold a whole message, so many small messages cost one syscall, and returns views into that
+  ///   buffer without copying. The buffer grows up to the longest message (limited by max_frame).
+  ///   Works with blocking and non-blocking sockets: a partial message stays buffered until the next read().
+  ///   The socket is not owned and must outlive the reader.
+  ///
+  /// @code
+  ///   frame_reader_t<v4> reader (client, framing_t::split ("\r\n"));
+  ///   frame_view_t line;
+  ///   while (reader.read (line) >= 0)
+  ///     handle (line.data, line.size);
+  /// @endcode
+  template <ip_type_e Ip_type>
+  struct frame_reader_t {
+
+    using tcp_t = tcp_socket_t<Ip_type, socket_type_e::client>;
+
+    static const std::size_t default_bufsize   = 65536;
+    static const std::size_t default_max_frame = 16 << 20;
+
+    ///	@param sock_      - Connected socket to read from.
+    ///	@param framing_   - Message framing.
+    ///	@param max_frame_ - Longest accepted payload, longer messages fail with error_other (default: 16MB).
+    ///	@param bufsize    - Initial buffer size (default: 64KB).
+    frame_reader_t (tcp_t& sock_, const framing_t& framing_, std::size_t max_frame_ = default_max_frame, std::size_t bufsize = default_bufsize)
+      : sock (sock_), framing (framing_), max_frame (max_frame_), buffer (bufsize ? bufsize : 1) {}
+
+    ///	@brief Returns the next message, receiving more data when the buffered bytes do not hold one.
+    ///	@param[out] frame - View of the message payload, valid until the next call.
+    ///	@return Payload size (>= 0) on success, or error code:
+    ///	  - error codes of tcp_socket_t::recv() (error_tcp_closed, error_timeout, error_would_block, ...)
+    ///	    — bytes of an unfinished message stay buffered
+    ///	  - error_other if a message is longer than max_frame or its length prefix is malformed
+    ///	    (the stream cannot be resynchronized, close the connection)
+    int read (frame_view_t& frame) {
+      while (true) {
+        int res = _parse (frame);
+        if (res != 0)
+          return (res > 0) ? (int)frame.size : error_other;
+        res = _receive ();
+        if (res < 0)
+          return res;
+      }
+    }
+
+    std::size_t buffered () const { return end - begin; } ///< @brief Returns the number of received bytes not returned as messages yet.
+
+  protected:
+
+    tcp_t&            sock;
+    framing_t         framing;
+    std::size_t       max_frame;
+    std::vector<char> buffer;
+    std::size_t       begin   = 0; ///< First byte not returned yet
+    std::size_t       end     = 0; ///< End of received bytes
+    std::size_t       scanned = 0; ///< Delimited framing: bytes after begin already searched for the delimiter
+    std::size_t       need    = 0; ///< Bytes after begin the unfinished message needs (0 = unknown)
+
+    /// @brief Takes one message out of the buffer: 1 = found, 0 = more data needed, -1 = protocol error.
+    int _parse (frame_view_t& frame) {
+      const char* data  = buffer.data () + begin;
+      std::size_t avail = end - begin;
+
+      if (framing.kind == framing_t::delimited) {
+        const std::string& delim = framing.delimiter;
+        std::size_t        dlen  = delim.size ();
+        std::size_t        pos   = (scanned + 1 > dlen) ? scanned + 1 - dlen : 0; // a delimiter may start in the scanned tail
+        while (dlen != 0 && pos + dlen <= avail) {
+          const char* hit = (const char*)memchr (data + pos, delim[0], avail - dlen + 1 - pos);
+          if (hit == nullptr)
+            break;
+          pos = (std::size_t)(hit - data);
+          if (memcmp (hit, delim.data (), dlen) == 0) {
+            frame.data = data;
+            frame.size = pos;
+            begin     += pos + dlen;
+            scanned    = 0;
+            need       = 0;
+            return 1;
+          }
+          pos++;
+        }
+        scanned = avail;
+        if (avail > max_frame + dlen)
+          return -1;
+        need = 0;
+        return 0;
+      }
+
+      uint32_t len    = 0;
+      int      header = framing.decode (data, avail, len);
+      if (header < 0 || len > max_frame)
+        return -1;
+      if (header == 0 || avail < header + (std::size_t)len) {
+        need = (header == 0) ? 0 : header + (std::size_t)len;
+        return 0;
+      }
+      frame.data = data + header;
+      frame.size = len;
+      begin     += header + (std::size_t)len;
+      need       = 0;
+      return 1;
+    }
+
+    /// @brief One recv() into the free space after the buffered bytes; moves them to the front or grows the buffer first if needed.
+    int _receive () {
+      std::size_t avail = end - begin;
+      std::size_t want  = (need > avail) ? need : avail + 1;
+      if (buffer.size () - begin < want || avail == 0) {
+        if (want > buffer.size ())
+          buffer.resize (std::max (want, buffer.size () * 2));
+        if (begin != 0)
+          memmove (buffer.data (), buffer.data () + begin, avail);
+        begin = 0;
+        end   = avail;
+      }
+      int res = sock.recv (buffer.data () + end, (int)std::min (buffer.size () - end, (std::size_t)INT_MAX));
+      if (res > 0)
+        end += (std::size_t)res;
+      return res;
+    }
+
+  };
+
+  // ============================================================
+  // frame_writer_t — coalescing message writer for a TCP socket
+  // ============================================================
+
+  /// @brief Frames messages and sends many small ones with one send().
+  /// @details Messages are appended to a buffer that is sent when it would exceed flush_size or on flush().
+  ///   A message as big as flush_size goes out at once together with the buffered bytes (one sendv(),
+  ///   no copy). Bytes a non-blocking socket does not take stay buffered: wait_writable() and flush() again.
+  ///   The buffer does not grow without bound: when it cannot be drained below flush_size, write() refuses
+  ///   the message with error_would_block (backpressure for non-blocking producers).
+  ///   The socket is not owned and must outlive the writer; the destructor does not flush.
+  ///
+  /// @code
+  ///   frame_writer_t<v4> writer (client, framing_t::u32 ());
+  ///   for (const std::string& msg : messages)
+  ///     writer.write (msg.data (), (int)msg.size ());
+  ///   writer.flush ();
+  /// @endcode
+  template <ip_type_e Ip_type>
+  struct frame_writer_t {
+
+    using tcp_t = tcp_socket_t<Ip_type, socket_type_e::client>;
+
+    static const std::size_t default_flush_size = 65536;
+
+    ///	@param sock_       - Connected socket to write to.
+    ///	@param framing_    - Message framing.
+    ///	@param flush_size_ - Buffer size that triggers a send (default: 64KB).
+    frame_writer_t (tcp_t& sock_, const framing_t& framing_, std::size_t flush_size_ = default_flush_size)
+      : sock (sock_), framing (framing_), flush_size (flush_size_) {
+      buffer.reserve (flush_size);
+    }
+
+    ///	@brief Frames a message and queues it, sending the queue first when the message does not fit.
+    ///	@param data - Message payload.
+    ///	@param len  - Payload size (at most 65535 for u16 framing).
+    ///	@return no_error if the message was sent or buffered, or error code:
+    ///	  - error_not_allowed if len does not fit the length prefix
+    ///	  - error_would_block if the socket is non-blocking, has no space and the buffer is full:
+    ///	    the message is not queued, wait_writable() and write it again
+    ///	  - error codes of tcp_socket_t::sendv() other than error_would_block (the connection is broken)
+    int write (const char* data, int len) {
+
+      if (len < 0 || (framing.kind == framing_t::length_u16 && len > 0xffff))
+        return error_not_allowed;
+
+      char        prefix[framing_t::header_max];
+      int         plen   = framing.encode ((uint32_t)len, prefix);
+      const char* suffix = framing.delimiter.data ();
+      int         slen   = (int)framing.delimiter.size ();
+      std::size_t total  = (std::size_t)plen + (std::size_t)len + (std::size_t)slen;
+
+      if (buffer.size () + total <= flush_size) {
+        _append (prefix, plen);
+        _append (data,   len);
+        _append (suffix, slen);
+        return no_error;
+      }
+      if (total < flush_size) { // small message: send the queue, then start a new one
+        int res = flush ();
+        if (res != no_error && res != error_would_block)
+          return res;
+        if (buffer.size () + total > flush_size)
+          return error_would_block;
+        _append (prefix, plen);
+        _append (data,   len);
+        _append (suffix, slen);
+        return no_error;
+      }
+
+      io_vec_t parts[4];
+      int      count = 0;
+      if (!buffer.empty ()) parts[count++] = io_vec_t (buffer.data (), (int)buffer.size ());
+      int      message = count;
+      if (plen > 0)         parts[count++] = io_vec_t (prefix, plen);
+      parts[count++] = io_vec_t (data, len);
+      if (slen > 0)         parts[count++] = io_vec_t (suffix, slen);
+      bool dropped = false;
+      int  res     = _send (parts, count, message, &dropped);
+      return (res == error_would_block && !dropped) ? no_error : res; // a partly sent message is buffered to the end
+    }
+
+    ///	@brief Sends all buffered messages.
+    ///	@return no_error when the buffer is empty, or error code:
+    ///	  - error_would_block if the socket is non-blocking and has no space (the rest stays buffered)
+    ///	  - other error codes of tcp_socket_t::sendv()
+    int flush () {
+      if (buffer.empty ())
+        return no_error;
+      io_vec_t part (buffer.data (), (int)buffer.size ());
+      return _send (&part, 1);
+    }
+
+    std::size_t pending () const { return buffer.size (); } ///< @brief Returns the number of bytes waiting for flush().
+
+  protected:
+
+    tcp_t&            sock;
+    framing_t         framing;
+    std::size_t       flush_size;
+    std::vector<char> buffer;   ///< Framed messages not sent yet
+
+    void _append (const char* data, int len) {
+      buffer.insert (buffer.end (), data, data + len);
+    }
+
+    /// @brief Sends parts (parts[0] may be the buffer itself) until all is sent; the unsent tail replaces the buffer.
+    /// @details Parts from index message on are a new message: if none of its bytes was sent it is not buffered
+    ///   and *dropped is set, so the stream never holds half a message twice or a message the caller was told failed.
+    ///   On a hard error the sent bytes are removed from the buffer too, a later flush() does not resend them.
+    int _send (io_vec_t* parts, int count, int message = INT_MAX, bool* dropped = nullptr) {
+      int  first   = 0;
+      bool partial = false; // parts[first] is partly sent
+      int  res     = no_error;
+      while (first < count) {
+        res = sock.sendv (parts + first, count - first);
+        if (res < 0)
+          break;
+        while (first < count && res >= parts[first].len) {
+          res -= parts[first++].len;
+          partial = false;
+        }
+        if (first < count && res > 0) {
+          parts[first].buf += res;
+          parts[first].len -= res;
+          partial = true;
+        }
+        res = no_error;
+      }
+
+      if (first == count) {
+        buffer.clear ();
+        return no_error;
+      }
+
+      // keep the unsent tail in order (parts[0] may point into the buffer, so collect it aside)
+      bool drop = message < count && (first < message || (first == message && !partial));
+      int  last = drop ? message : count;
+      std::vector<char> rest;
+      rest.reserve (flush_size);
+      for (int i = first; i < last; i++)
+        rest.insert (rest.end (), parts[i].buf, parts[i].buf + parts[i].len);
+      buffer.swap (rest);
+      if (dropped)
+        *dropped = drop;
+      return (res == no_error) ? error_would_block : res;
+    }
+
+  };
+
+} // namespace ipsockets
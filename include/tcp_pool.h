@@ -0,0 +1,324 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "ip_addr_map.h"
+#include "tcp_socket.h"
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace ipsockets {
+
+  // ============================================================
+  // tcp_pool_t — reusable client connections per endpoint
+  // ============================================================
+
+  /// @brief Thread-safe pool of connected TCP client sockets keyed by remote address.
+  /// @details acquire() hands out an idle connection to the endpoint if one is alive, otherwise connects a new one.
+  ///   A connection taken from the pool is checked with one non-blocking recv(MSG_PEEK): an idle connection
+  ///   must have nothing to read, so pending data (a late response) or end of stream means it is dropped.
+  ///   Per endpoint at most max_total connections exist (idle + leased) and at most max_idle are kept idle;
+  ///   idle connections older than idle_timeout_ms are closed by acquire() and evict().
+  ///   The lease returns the connection in its destructor; call discard() when the connection state is unknown
+  ///   (e.g. after a timeout in the middle of a response). The pool must outlive its leases.
+  ///
+  /// @code
+  ///   tcp_pool_t<v4> pool;
+  ///   int err;
+  ///   tcp_pool_t<v4>::lease_t conn = pool.acquire ("10.0.0.5:8080", &err);
+  ///   if (conn) {
+  ///     conn->send (request, len);
+  ///     if (conn->recv (buf, sizeof (buf)) <= 0)
+  ///       conn.discard ();
+  ///   }                                   // back to the pool
+  /// @endcode
+  template <ip_type_e Ip_type>
+  struct tcp_pool_t {
+
+    using tcp_t      = tcp_socket_t<Ip_type, socket_type_e::client>;
+    using address_t  = addr_t<Ip_type>;
+    using clock_type = std::chrono::steady_clock;
+
+    /// @brief Pool limits and settings of new connections.
+    struct config_t {
+      size_t   max_idle           = 8;     ///< Idle connections kept per endpoint, more are closed on release
+      size_t   max_total          = 64;    ///< Connections per endpoint (idle + leased), acquire() fails above it
+      uint32_t idle_timeout_ms    = 30000; ///< Idle connections older than this are closed (0 = never)
+      uint32_t timeout_ms         = 1000;  ///< Receive timeout of new connections (SO_RCVTIMEO)
+      uint32_t connect_timeout_ms = 5000;  ///< Connect timeout of new connections
+      log_e    log_level          = log_e::error; ///< Log level of new connections
+    };
+
+    /// @brief Pool counters.
+    struct stats_t {
+      uint64_t connects = 0; ///< New connections opened
+      uint64_t reuses   = 0; ///< Idle connections handed out again
+      uint64_t dead     = 0; ///< Idle connections dropped by the liveness check
+      uint64_t evicted  = 0; ///< Idle connections closed for age or the max_idle limit
+      uint64_t rejected = 0; ///< acquire() calls refused by max_total
+    };
+
+    /// @brief Leased connection: use it as a tcp_t pointer, it goes back to the pool when destroyed.
+    struct lease_t {
+
+      lease_t () = default;
+      lease_t (lease_t&& other) : pool (other.pool), address (other.address), sock (std::move (other.sock)), is_reused (other.is_reused) {
+        other.pool = nullptr;
+      }
+      lease_t& operator= (lease_t&& other) {
+        if (this != &other) {
+          release ();
+          pool       = other.pool;
+          address    = other.address;
+          sock       = std::move (other.sock);
+          is_reused  = other.is_reused;
+          other.pool = nullptr;
+        }
+        return *this;
+      }
+      lease_t (const lease_t&) = delete;
+      lease_t& operator= (const lease_t&) = delete;
+
+      ~lease_t () { release (); }
+
+      tcp_t* operator-> () const { return sock.get (); } ///< @brief Accesses the connected socket.
+      tcp_t& operator* ()  const { return *sock; }       ///< @brief Accesses the connected socket.
+      explicit operator bool () const { return sock != nullptr; } ///< @brief Returns true if the lease holds a connection.
+      bool reused () const { return is_reused; }        ///< @brief Returns true if the connection came from the idle list.
+
+      ///	@brief Returns the connection to the pool now (also done by the destructor).
+      ///	@note A closed socket, or one left in non-blocking mode, is not kept.
+      void release () {
+        if (pool && sock)
+          pool->_release (address, std::move (sock));
+        pool = nullptr;
+        sock.reset ();
+      }
+
+      ///	@brief Closes the connection instead of returning it, e.g. when a response was not read to the end.
+      void discard () {
+        if (sock)
+          sock->close ();
+        release ();
+      }
+
+    protected:
+
+      friend struct tcp_pool_t;
+
+      tcp_pool_t*            pool      = nullptr;
+      address_t              address   = {};
+      std::unique_ptr<tcp_t> sock;
+      bool                   is_reused = false;
+    };
+
+    tcp_pool_t () = default;
+    explicit tcp_pool_t (const config_t& config_) : config (config_) {}
+
+    tcp_pool_t (const tcp_pool_t&) = delete;
+    tcp_pool_t& operator= (const tcp_pool_t&) = delete;
+
+    ~tcp_pool_t () {
+      clear ();
+    }
+
+    ///	@brief Returns a connected socket to the endpoint: a live idle one if there is, otherwise a new connection.
+    ///	@param      address - Remote address:port.
+    ///	@param[out] error   - Optional, set to no_error, or to the reason of an empty lease:
+    ///	  - error_would_block if max_total connections to the endpoint already exist
+    ///	  - error codes of tcp_socket_t::open() (error_open_failed, error_timeout, ...)
+    ///	@return Lease holding the socket; an empty lease (false) on failure.
+    lease_t acquire (const address_t& address, int* error = nullptr) {
+
+      lease_t lease;
+      lease.pool    = this;
+      lease.address = address;
+
+      clock_type::time_point now = clock_type::now ();
+      while (true) {
+        std::unique_ptr<tcp_t> sock;
+        {
+          std::lock_guard<std::mutex> lock (mutex);
+          endpoint_t& endpoint = endpoints[address];
+          _expire (endpoint, now);
+          if (!endpoint.idle.empty ()) {
+            sock = std::move (endpoint.idle.back ().sock); // most recently used first: its path and windows are warm
+            endpoint.idle.pop_back ();
+          }
+          else if (endpoint.total >= config.max_total) {
+            counters.rejected++;
+            lease.pool = nullptr;
+            if (error)
+              *error = error_would_block;
+            return lease;
+          }
+          else
+            endpoint.total++; // reserve the slot before connecting without the lock
+        }
+
+        if (sock) {
+          if (_alive (*sock)) {
+            std::lock_guard<std::mutex> lock (mutex);
+            counters.reuses++;
+            lease.sock      = std::move (sock);
+            lease.is_reused = true;
+            if (error)
+              *error = no_error;
+            return lease;
+          }
+          sock->close ();
+          std::lock_guard<std::mutex> lock (mutex);
+          counters.dead++;
+          endpoints[address].total--;
+          continue;
+        }
+
+        sock.reset (new tcp_t (config.log_level));
+        int res = sock->open (address, config.timeout_ms, config.connect_timeout_ms);
+        std::lock_guard<std::mutex> lock (mutex);
+        if (res != no_error) {
+          endpoints[address].total--;
+          lease.pool = nullptr;
+          if (error)
+            *error = res;
+          return lease;
+        }
+        counters.connects++;
+        lease.sock = std::move (sock);
+        if (error)
+          *error = no_error;
+        return lease;
+      }
+    }
+
+    ///	@brief Closes idle connections older than idle_timeout_ms on all endpoints and forgets endpoints without connections.
+    ///	@return Number of closed connections.
+    size_t evict () {
+      std::lock_guard<std::mutex> lock (mutex);
+      clock_type::time_point now    = clock_type::now ();
+      size_t              closed = 0;
+      std::vector<address_t> unused;
+      endpoints.for_each ([&] (const address_t& address, endpoint_t& endpoint) {
+        closed += _expire (endpoint, now);
+        if (endpoint.total == 0)
+          unused.push_back (address);
+      });
+      for (const address_t& address : unused)
+        endpoints.erase (address);
+      return closed;
+    }
+
+    ///	@brief Closes all idle connections; leased ones are closed when they come back.
+    void clear () {
+      std::lock_guard<std::mutex> lock (mutex);
+      endpoints.for_each ([&] (const address_t&, endpoint_t& endpoint) {
+        for (idle_t& idle : endpoint.idle)
+          idle.sock->close ();
+        endpoint.total -= endpoint.idle.size ();
+        endpoint.idle.clear ();
+      });
+    }
+
+    ///	@brief Returns the number of idle connections to the endpoint.
+    size_t idle (const address_t& address) {
+      std::lock_guard<std::mutex> lock (mutex);
+      const endpoint_t* endpoint = endpoints.find (address);
+      return endpoint ? endpoint->idle.size () : 0;
+    }
+
+    ///	@brief Returns the number of connections to the endpoint (idle + leased).
+    size_t total (const address_t& address) {
+      std::lock_guard<std::mutex> lock (mutex);
+      const endpoint_t* endpoint = endpoints.find (address);
+      return endpoint ? endpoint->total : 0;
+    }
+
+    ///	@brief Returns a copy of the pool counters.
+    stats_t stats () {
+      std::lock_guard<std::mutex> lock (mutex);
+      return counters;
+    }
+
+    const config_t& get_config () const { return config; } ///< @brief Returns the pool settings.
+
+  protected:
+
+    struct idle_t {
+      std::unique_ptr<tcp_t> sock;
+      clock_type::time_point    since; ///< Time the connection became idle
+    };
+
+    struct endpoint_t {
+      std::vector<idle_t> idle;            ///< Idle connections, the most recently released last
+      size_t              total = 0; ///< Idle + leased connections
+    };
+
+    config_t                          config;
+    std::mutex                        mutex;
+    addr_map_t<address_t, endpoint_t> endpoints;
+    stats_t                           counters;
+
+    /// @brief Cheap liveness check of an idle connection: nothing to read and no error.
+    static bool _alive (tcp_t& sock) {
+      if (sock.state != state_e::opened)
+        return false;
+      char byte;
+      #ifdef _WIN32 // WINDOWS OS
+        // no MSG_DONTWAIT: a zero-timeout poll, a readable idle connection has either data or end of stream
+        WSAPOLLFD pfd = {};
+        pfd.fd        = sock.sock;
+        pfd.events    = POLLRDNORM;
+        (void)byte;
+        return WSAPoll (&pfd, 1, 0) == 0;
+      #else         // LINUX OS
+        int res = (int)::recv (sock.sock, &byte, 1, MSG_PEEK | MSG_DONTWAIT);
+        return res == SOCKET_ERROR && (errno == EAGAIN || errno == EWOULDBLOCK);
+      #endif
+    }
+
+    /// @brief Closes the idle connections of an endpoint that waited longer than idle_timeout_ms (mutex is held).
+    size_t _expire (endpoint_t& endpoint, clock_type::time_point now) {
+      if (config.idle_timeout_ms == 0 || endpoint.idle.empty ())
+        return 0;
+      clock_type::time_point limit = now - std::chrono::milliseconds (config.idle_timeout_ms);
+      size_t              stale = 0;
+      while (stale < endpoint.idle.size () && endpoint.idle[stale].since < limit) // the oldest are first
+        endpoint.idle[stale++].sock->close ();
+      endpoint.idle.erase (endpoint.idle.begin (), endpoint.idle.begin () + (std::ptrdiff_t)stale);
+      endpoint.total   -= stale;
+      counters.evicted += stale;
+      return stale;
+    }
+
+    /// @brief Takes a connection back from a lease.
+    void _release (const address_t& address, std::unique_ptr<tcp_t> sock) {
+      std::lock_guard<std::mutex> lock (mutex);
+      endpoint_t* endpoint = endpoints.find (address);
+      if (endpoint == nullptr) // cannot happen while the lease exists, keep the counters consistent anyway
+        return;
+      if (sock->state == state_e::opened && !sock->nonblocking && endpoint->idle.size () < config.max_idle) {
+        idle_t idle;
+        idle.sock  = std::move (sock);
+        idle.since = clock_type::now ();
+        endpoint->idle.push_back (std::move (idle));
+        return;
+      }
+      if (sock->state == state_e::opened)
+        counters.evicted++;
+      sock->close ();
+      endpoint->total--;
+    }
+
+  };
+
+} // namespace ipsockets
@@ -11,8 +11,119 @@
 
 #include "udp_socket.h"
 
+#include <climits>
+#include <memory>
+#include <mutex>
+
+#if defined(__linux__)
+  #include <linux/errqueue.h> // Needed for sock_extended_err of MSG_ZEROCOPY completion notifications
+  #ifndef SO_ZEROCOPY
+    #define SO_ZEROCOPY 60                  // available since linux 4.14, older headers may not define it
+  #endif
+  #ifndef MSG_ZEROCOPY
+    #define MSG_ZEROCOPY 0x4000000
+  #endif
+  #ifndef SO_EE_ORIGIN_ZEROCOPY
+    #define SO_EE_ORIGIN_ZEROCOPY 5
+  #endif
+  #ifndef SO_EE_CODE_ZEROCOPY_COPIED
+    #define SO_EE_CODE_ZEROCOPY_COPIED 1
+  #endif
+  #define IP_SOCKETS_HAS_ZEROCOPY 1
+  #include <sys/sendfile.h> // Needed for sendfile() in send_file()
+  #define IP_SOCKETS_HAS_SENDFILE 1
+  #if defined(_GNU_SOURCE)
+    #define IP_SOCKETS_HAS_SPLICE 1 // splice() and F_SETPIPE_SZ are declared in fcntl.h
+  #endif
+#elif defined(_WIN32)
+  #include <io.h> // Needed for _lseeki64() and _read() in the send_file() fallback
+#endif
+
 namespace ipsockets {
 
+  // ============================================================
+  // accept_registry_t — accepted connections of one server socket
+  // ============================================================
+
+  /// @brief Thread-safe registry of descriptors accepted by a server socket, O(1) insert and remove.
+  /// @details Descriptors live in a slot array; a handle is slot index + generation counter of the slot,
+  ///   so a stale handle (slot already freed and reused) never removes someone else's descriptor.
+  ///   The registry is shared (std::shared_ptr) between the server and its accepted sockets: whoever
+  ///   comes first closes the descriptor — the accepted socket in close(), or the server in its destructor.
+  struct accept_registry_t {
+
+    /// @brief Registers a descriptor and returns its handle.
+    uint64_t add (socket_t sock) {
+      std::lock_guard<std::mutex> lock (mutex);
+      uint32_t index;
+      if (free_slots.empty ()) {
+        index = (uint32_t)slots.size ();
+        slots.emplace_back ();
+      }
+      else {
+        index = free_slots.back ();
+        free_slots.pop_back ();
+      }
+      slots[index].sock = sock;
+      count++;
+      return ((uint64_t)slots[index].gen << 32) | index;
+    }
+
+    /// @brief Unregisters a descriptor, the caller closes it.
+    /// @return true if the descriptor was registered, false if it was already closed by close_all().
+    bool remove (uint64_t handle) {
+      std::lock_guard<std::mutex> lock (mutex);
+      uint32_t index = (uint32_t)handle;
+      if (index >= slots.size () || slots[index].gen != (uint32_t)(handle >> 32) || slots[index].sock == INVALID_SOCKET)
+        return false;
+      _release (index);
+      return true;
+    }
+
+    /// @brief Closes and unregisters every descriptor (used by the server destructor).
+    void close_all () {
+      std::lock_guard<std::mutex> lock (mutex);
+      for (uint32_t index = 0; index < slots.size (); index++)
+        if (slots[index].sock != INVALID_SOCKET) {
+          closesocket (slots[index].sock);
+          _release (index);
+        }
+    }
+
+    /// @brief Returns the number of registered descriptors.
+    size_t size () {
+      std::lock_guard<std::mutex> lock (mutex);
+      return count;
+    }
+
+  protected:
+
+    struct slot_t {
+      socket_t sock = INVALID_SOCKET;
+      uint32_t gen  = 0;              ///< Incremented when the slot is freed, invalidates old handles
+    };
+
+    std::mutex            mutex;
+    std::vector<slot_t>   slots;
+    std::vector<uint32_t> free_slots;
+    size_t                count = 0;
+
+    void _release (uint32_t index) {
+      slots[index].sock = INVALID_SOCKET;
+      slots[index].gen++;
+      free_slots.push_back (index);
+      count--;
+    }
+
+  };
+
+  /// @brief Range of send_zerocopy() ids whose buffers the kernel no longer references, filled by reap_zerocopy().
+  struct zerocopy_range_t {
+    uint32_t first  = 0;     ///< First completed id
+    uint32_t last   = 0;     ///< Last completed id (inclusive)
+    bool     copied = false; ///< The data was copied anyway (loopback, device without scatter-gather, zero-copy disabled)
+  };
+
   // ============================================================
   // tcp_socket_t — TCP socket implementation
   // ============================================================
@@ -24,25 +135,54 @@ namespace ipsockets {
     using typename base_socket_t::address_t;
 
     tcp_socket_t<Ip_type, socket_type_e::server>* parent = nullptr; ///< Pointer to parent server socket (non-null only for accepted client sockets)
-    std::vector<socket_t>                         accept_clients;   ///< OS descriptors of accepted connections (server only); closed automatically in destructor
+    std::shared_ptr<accept_registry_t>            accept_clients;   ///< Server: accepted connections, closed automatically in destructor; accepted socket: registry of its server
+    uint64_t                                      accept_handle = 0; ///< Accepted socket: handle of its descriptor in accept_clients
+    bool                                          zerocopy      = false; ///< SO_ZEROCOPY is enabled, see enable_zerocopy()
+    uint32_t                                      zerocopy_next = 0; ///< Id of the next send_zerocopy() call that sends data
+    uint32_t                                      zerocopy_base = 0; ///< Value of zerocopy_next when SO_ZEROCOPY was enabled, kernel ids count from there
+    uint32_t                                      zerocopy_copy = 0; ///< First id sent without SO_ZEROCOPY that reap_zerocopy() did not report yet
+    uint32_t                                      zerocopy_done = 0; ///< Number of ids reported by reap_zerocopy()
+    int                                           splice_pipe[2] = { -1, -1 }; ///< splice_from(): pipe between the sockets, created on first use
+    int                                           splice_size    = 0; ///< Capacity of splice_pipe in bytes
+    std::vector<char>                             splice_buffer; ///< splice_from() without splice(): buffer between the sockets
+    int                                           splice_offset  = 0; ///< Position of the unsent bytes in splice_buffer
+    int                                           splice_left    = 0; ///< Bytes received by splice_from() but not sent yet
 
     ///	@brief Constructor for TCP socket.
     ///	@param log_level - Logging level for this socket instance (default: log_e::info).
     tcp_socket_t (log_e log_level = log_e::info)
-      : base_socket_t (log_level, SOCK_STREAM, IPPROTO_TCP, _get_tname ()) {}
+      : base_socket_t (log_level, SOCK_STREAM, IPPROTO_TCP, _get_tname ()) {
+      if (Socket_type == socket_type_e::server)
+        accept_clients = std::make_shared<accept_registry_t> ();
+    }
 
     tcp_socket_t (tcp_socket_t&& other_socket) : base_socket_t (std::move(other_socket)) {
       parent               = other_socket.parent;
       other_socket.parent  = nullptr;
       accept_clients       = std::move (other_socket.accept_clients);
+      accept_handle        = other_socket.accept_handle;
+      if (Socket_type == socket_type_e::server) // the moved-from server can be opened again, it needs its own registry
+        other_socket.accept_clients = std::make_shared<accept_registry_t> ();
+      zerocopy             = other_socket.zerocopy;
+      zerocopy_next        = other_socket.zerocopy_next;
+      zerocopy_base        = other_socket.zerocopy_base;
+      zerocopy_copy        = other_socket.zerocopy_copy;
+      zerocopy_done        = other_socket.zerocopy_done;
+      splice_pipe[0]       = other_socket.splice_pipe[0];
+      splice_pipe[1]       = other_socket.splice_pipe[1];
+      splice_size          = other_socket.splice_size;
+      splice_buffer        = std::move (other_socket.splice_buffer);
+      splice_offset        = other_socket.splice_offset;
+      splice_left          = other_socket.splice_left;
+      other_socket.splice_pipe[0] = other_socket.splice_pipe[1] = -1;
+      other_socket.splice_left    = 0;
     }
 
     tcp_socket_t (const tcp_socket_t& socket) = delete;
 
     ~tcp_socket_t () {
-      if (parent == nullptr)
-        for (socket_t& accept_sock : accept_clients)
-          closesocket (accept_sock);
+      if (parent == nullptr && accept_clients)
+        accept_clients->close_all ();
       close ();
     }
 
@@ -70,6 +210,19 @@ namespace ipsockets {
       return result;
     }
 
+    ///	@brief Opens a TCP server socket with tuning options; accepted sockets inherit them.
+    ///	@param address            - The local address:port to bind to.
+    ///	@param options_           - Options set before bind (e.g. no_delay = 1 for every accepted connection), stored in the options member.
+    ///	@param timeout_ms         - Receive timeout in milliseconds (SO_RCVTIMEO), also affects accept() timeout on Linux. Default: 1000.
+    ///	@param max_incoming_queue - Maximum number of pending connections in the listen queue. Default: 1000.
+    ///	@return no_error on success, error_open_failed or error_not_allowed on failure.
+    template <socket_type_e SOCK = Socket_type, std::enable_if_t<SOCK == socket_type_e::server, bool> = true>
+    int open (const address_t& address, const socket_options_t& options_, uint32_t timeout_ms = 1000, int max_incoming_queue = 1000) {
+      if (this->state != state_e::opened)
+        this->options = options_;
+      return open (address, timeout_ms, max_incoming_queue);
+    }
+
     ///	@brief Opens a TCP client socket: connects to remote address with timeout.
     ///	@param address            - The remote address:port to connect to.
     ///	@param timeout_ms         - Receive timeout in milliseconds (SO_RCVTIMEO). Default: 1000.
@@ -83,6 +236,19 @@ namespace ipsockets {
       return base_socket_t::open (address, timeout_ms, connect_timeout_ms);
     }
 
+    ///	@brief Opens a TCP client socket with tuning options set before connect.
+    ///	@param address            - The remote address:port to connect to.
+    ///	@param options_           - Options to set (TCP_NODELAY, buffer sizes, keepalive, ...), stored in the options member.
+    ///	@param timeout_ms         - Receive timeout in milliseconds (SO_RCVTIMEO). Default: 1000.
+    ///	@param connect_timeout_ms - Connect timeout in milliseconds (max wait for TCP handshake). Default: 5000.
+    ///	@return no_error on success, error_open_failed, error_timeout or error_not_allowed on failure.
+    template <socket_type_e SOCK = Socket_type, std::enable_if_t<SOCK == socket_type_e::client, bool> = true>
+    int open (const address_t& address, const socket_options_t& options_, uint32_t timeout_ms = 1000, uint32_t connect_timeout_ms = 5000) {
+      if (this->state != state_e::opened)
+        this->options = options_;
+      return open (address, timeout_ms, connect_timeout_ms);
+    }
+
     ///	@brief Receives data on a connected TCP socket.
     ///	@param[out] buf     - Buffer to store received data.
     ///	@param      buf_len - Maximum number of bytes to receive.
@@ -91,6 +257,7 @@ namespace ipsockets {
     ///	  - error_closed_or_not_open if socket not opened
     ///	  - error_not_allowed if called on server socket
     ///	  - error_timeout on receive timeout
+    ///	  - error_would_block if the socket is non-blocking and no data is queued
     ///	  - error_other for other errors
     ///	@pre Socket must be opened in client mode and connected to a remote peer.
     int recv (char* buf, int buf_len) {
@@ -107,14 +274,273 @@ namespace ipsockets {
 
     }
 
+    ///	@brief Receives data on a connected TCP socket, filling several buffers in order (scatter read).
+    ///	@param vecs  - Array of buffers to receive into.
+    ///	@param count - Number of buffers in vecs (at most iov_max are used per call).
+    ///	@return Number of bytes received on success, or the same error codes as recv() (error_tcp_closed when the peer closed the connection).
+    int recvv (const io_vec_t* vecs, int count) {
+      int result = base_socket_t::recvv (vecs, count);
+      return (result == 0)
+        ? this->log_and_return ('<', "recvv", error_tcp_closed)
+        : result;
+    }
+
+    ///	@brief Enables zero-copy sending (SO_ZEROCOPY) for send_zerocopy() on a connected socket.
+    ///	@return no_error on success, or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on server socket, or the OS does not support SO_ZEROCOPY (linux 4.14+ only);
+    ///	    send_zerocopy() still works then, with ordinary copying sends
+    ///	@details Zero-copy pays off for large writes (64KB and more): the kernel pins the user pages instead of copying them,
+    ///	  but every send costs a page pinning and a completion notification, so small writes are faster with send().
+    int enable_zerocopy () {
+
+      if (this->state       != state_e::opened)         return this->log_and_return ('-', "enable_zerocopy", error_closed_or_not_open);
+      if (this->socket_type == socket_type_e::server)   return this->log_and_return ('-', "enable_zerocopy", error_not_allowed);
+      if (zerocopy)                                     return no_error;
+
+      #ifdef IP_SOCKETS_HAS_ZEROCOPY // LINUX OS
+        int ov = 1;
+        if (setsockopt (this->sock, SOL_SOCKET, SO_ZEROCOPY, (char*)&ov, sizeof (ov)) == SOCKET_ERROR)
+          return this->log_and_return ('-', "setsockopt", error_not_allowed, "set SO_ZEROCOPY is not supported");
+        zerocopy      = true;
+        zerocopy_base = zerocopy_next;
+        return this->log_and_return ('-', "setsockopt", no_error, "set SO_ZEROCOPY");
+      #else
+        return this->log_and_return ('-', "setsockopt", error_not_allowed, "set SO_ZEROCOPY is not supported");
+      #endif
+    }
+
+    ///	@brief Sends data without copying it into the kernel (MSG_ZEROCOPY) when enable_zerocopy() succeeded.
+    ///	@param      buf     - Buffer containing data to send. It must stay unchanged until reap_zerocopy() reports the id.
+    ///	@param      buf_len - Number of bytes to send.
+    ///	@param[out] id      - Optional, set to the id of this send when some data was sent. Ids go up by one per such call.
+    ///	@return Number of bytes sent on success (may be less than buf_len, send the rest with the next call), or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on server socket
+    ///	  - error_would_block if the socket is non-blocking and the send buffer is full, or the limit of pinned pages
+    ///	    is reached (ENOBUFS): reap completions, then retry
+    ///	  - error_other for other errors
+    ///	@details Without SO_ZEROCOPY the data is copied as by send() and the id is reported by the next reap_zerocopy()
+    ///	  as copied, so the caller keeps a single code path for both cases.
+    int send_zerocopy (const char* buf, int buf_len, uint32_t* id = nullptr) {
+
+      if (this->state       != state_e::opened)         return this->log_and_return ('>', "send_zerocopy", error_closed_or_not_open);
+      if (this->socket_type == socket_type_e::server)   return this->log_and_return ('>', "send_zerocopy", error_not_allowed);
+
+      #ifdef IP_SOCKETS_HAS_ZEROCOPY // LINUX OS
+        int res = ::send (this->sock, buf, buf_len, zerocopy ? MSG_ZEROCOPY : 0);
+        int err = this->_get_err ();
+        if (res == SOCKET_ERROR && err == ENOBUFS && zerocopy)
+          return this->log_and_return ('>', "send_zerocopy", error_would_block);
+      #else
+        int res = ::send (this->sock, buf, buf_len, 0);
+        int err = this->_get_err ();
+      #endif
+
+      if (res == SOCKET_ERROR) return this->log_and_return ('>', "send_zerocopy", err);
+
+      // the kernel numbers only the calls that queued data, an empty or failed send does not take an id
+      if (res > 0) {
+        if (id)
+          *id = zerocopy_next;
+        zerocopy_next++;
+      }
+      return this->log_and_return ('>', "send_zerocopy", no_error, "sended", res);
+    }
+
+    ///	@brief Collects send_zerocopy() completions without blocking: buffers of the reported ids may be reused.
+    ///	@param[out] ranges - Array to fill with ranges of completed ids, in order.
+    ///	@param      count  - Size of the ranges array.
+    ///	@return Number of filled ranges (0 if nothing completed since the last call), or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_other for other errors
+    ///	@details Completions are read from the socket error queue (recvmsg with MSG_ERRQUEUE). A pending completion
+    ///	  wakes up wait_readable() and is reported by poll_sockets() as poll_error. Ranges with copied == true mean the kernel
+    ///	  fell back to copying, then plain send() is cheaper for this route.
+    int reap_zerocopy (zerocopy_range_t* ranges, int count) {
+
+      if (this->state != state_e::opened) return this->log_and_return ('<', "reap_zerocopy", error_closed_or_not_open);
+
+      int filled = 0;
+
+      // ids sent before SO_ZEROCOPY was enabled (or without it) were copied, their buffers are free already
+      uint32_t copied_end = zerocopy ? zerocopy_base : zerocopy_next;
+      if (zerocopy_copy != copied_end && filled < count) {
+        ranges[filled].first  = zerocopy_copy;
+        ranges[filled].last   = copied_end - 1;
+        ranges[filled].copied = true;
+        zerocopy_done        += copied_end - zerocopy_copy;
+        zerocopy_copy         = copied_end;
+        filled++;
+      }
+
+      #ifdef IP_SOCKETS_HAS_ZEROCOPY // LINUX OS
+        while (zerocopy && filled < count && zerocopy_pending () != 0) {
+
+          union {
+            char    buf[CMSG_SPACE (sizeof (sock_extended_err) + sizeof (sockaddr_in6))];
+            cmsghdr align;
+          } control;
+          msghdr msg = {};
+          msg.msg_control    = control.buf;
+          msg.msg_controllen = sizeof (control.buf);
+
+          if (::recvmsg (this->sock, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == SOCKET_ERROR) {
+            int err = this->_get_err ();
+            if (err == EAGAIN || err == EWOULDBLOCK || err == EINTR)
+              break;
+            return (filled > 0) ? filled : this->log_and_return ('<', "reap_zerocopy", err);
+          }
+
+          for (cmsghdr* cm = CMSG_FIRSTHDR (&msg); cm != nullptr; cm = CMSG_NXTHDR (&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP   && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR)))
+              continue;
+            sock_extended_err ee;
+            memcpy (&ee, CMSG_DATA (cm), sizeof (ee));
+            if (ee.ee_errno != 0 || ee.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+              continue;
+            // ee_info..ee_data is an inclusive range of kernel ids, the kernel merges consecutive completions
+            ranges[filled].first  = zerocopy_base + ee.ee_info;
+            ranges[filled].last   = zerocopy_base + ee.ee_data;
+            ranges[filled].copied = (ee.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0;
+            zerocopy_done        += ee.ee_data - ee.ee_info + 1;
+            filled++;
+          }
+        }
+      #endif
+
+      return filled;
+    }
+
+    ///	@brief Returns the number of send_zerocopy() ids not reported by reap_zerocopy() yet (buffers still in use).
+    uint32_t zerocopy_pending () const {
+      return zerocopy_next - zerocopy_done;
+    }
+
+    ///	@brief Sends a part of a file straight from the page cache (sendfile), the data does not pass through user space.
+    ///	@param fd     - Descriptor of a file opened for reading (a CRT descriptor from _open() on Windows).
+    ///	@param offset - Position in the file to send from. The file position of fd is not used and not changed (on linux).
+    ///	@param count  - Number of bytes to send.
+    ///	@return Number of bytes sent on success (less than count at the end of the file, or if a non-blocking socket is full), or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on server socket
+    ///	  - error_would_block if the socket is non-blocking and the send buffer is full
+    ///	  - error_other for other errors (including a bad or unreadable fd)
+    ///	@details Large files are sent with a loop: offset += result while result > 0.
+    ///	  Without sendfile() (non-linux) the file is read with pread()/_read() in 64KB pieces and sent with send().
+    int send_file (int fd, int64_t offset, int count) {
+
+      if (this->state       != state_e::opened)         return this->log_and_return ('>', "send_file", error_closed_or_not_open);
+      if (this->socket_type == socket_type_e::server)   return this->log_and_return ('>', "send_file", error_not_allowed);
+      if (count <= 0)                                   return 0;
+
+      #ifdef IP_SOCKETS_HAS_SENDFILE // LINUX OS
+        off_t   pos = (off_t)offset;
+        ssize_t res = ::sendfile (this->sock, fd, &pos, (size_t)count);
+        if (res == SOCKET_ERROR) return this->log_and_return ('>', "send_file", this->_get_err ());
+        return this->log_and_return ('>', "send_file", no_error, "sended", (int)res);
+      #else
+        char chunk[65536];
+        int  sent = 0;
+        while (sent < count) {
+          int want = std::min (count - sent, (int)sizeof (chunk));
+          #ifdef _WIN32 // WINDOWS OS
+            int got = (_lseeki64 (fd, offset + sent, SEEK_SET) < 0) ? -1 : _read (fd, chunk, (unsigned)want);
+          #else
+            int got = (int)::pread (fd, chunk, (size_t)want, (off_t)(offset + sent));
+          #endif
+          if (got < 0) {
+            if (sent > 0) break;
+            return this->log_and_return ('>', "send_file", error_other, "read file");
+          }
+          if (got == 0) break; // end of file
+          int res = ::send (this->sock, chunk, got, 0);
+          if (res == SOCKET_ERROR) {
+            if (sent > 0) break; // report what was sent, the error repeats on the next call
+            return this->log_and_return ('>', "send_file", this->_get_err ());
+          }
+          sent += res;
+          if (res < got) break;  // non-blocking socket is full
+        }
+        return this->log_and_return ('>', "send_file", no_error, "sended", sent);
+      #endif
+    }
+
+    ///	@brief Forwards data received on another connection to this one through a kernel pipe (splice), for proxies.
+    ///	@param from  - Connected socket to read from. Its SO_RCVTIMEO and non-blocking mode apply to the read.
+    ///	@param count - Maximum number of bytes to move by this call (also limited by the pipe size).
+    ///	@return Number of bytes sent to this socket (0 if the received data is still waiting for space, see splice_pending()), or error code:
+    ///	  - error_tcp_closed if `from` was closed by its peer
+    ///	  - error_timeout if no data arrived on `from` within its SO_RCVTIMEO
+    ///	  - error_would_block if `from` has no data, or this socket has no space (both non-blocking)
+    ///	  - error_closed_or_not_open if a socket is not opened
+    ///	  - error_other for other errors
+    ///	@details The pipe is created on the first call and closed by close(). Received bytes that a non-blocking
+    ///	  socket could not take yet stay in the pipe, the next call sends them before reading `from` again.
+    ///	  Without splice() (non-linux, or no pipe could be created) the data goes through a 64KB buffer with recv()/send().
+    template <socket_type_e SOCK = Socket_type, std::enable_if_t<SOCK == socket_type_e::client, bool> = true>
+    int splice_from (tcp_socket_t& from, int count) {
+
+      if (this->state != state_e::opened) return this->log_and_return ('>', "splice_from", error_closed_or_not_open);
+      if (from.state  != state_e::opened) return from.log_and_return ('<', "splice_from", error_closed_or_not_open);
+
+      int sent = 0;
+      if (splice_left > 0) {
+        sent = _splice_flush ();
+        if (sent < 0 || splice_left > 0)
+          return sent;
+      }
+
+      int capacity = _splice_open ();
+      int want     = std::min (count, capacity);
+      if (want <= 0)
+        return sent;
+
+      #ifdef IP_SOCKETS_HAS_SPLICE // LINUX OS
+        int got = (splice_pipe[0] != -1)
+          ? (int)::splice (from.sock, nullptr, splice_pipe[1], nullptr, (size_t)want, SPLICE_F_MOVE)
+          : (int)::recv (from.sock, splice_buffer.data (), (size_t)want, 0);
+      #else
+        int got = (int)::recv (from.sock, splice_buffer.data (), want, 0);
+      #endif
+
+      if (got == 0)            return from.log_and_return ('<', "splice_from", error_tcp_closed);
+      if (got == SOCKET_ERROR) return (sent > 0) ? sent : from.log_and_return ('<', "splice_from", from._get_err ());
+
+      splice_offset = 0;
+      splice_left   = got;
+      int res = _splice_flush ();
+      if (res < 0)
+        return (sent > 0 || res == error_would_block) ? sent : res; // received bytes wait in the pipe for the next call
+      return sent + res;
+    }
+
+    ///	@brief Returns the number of bytes received by splice_from() that this socket did not take yet.
+    int splice_pending () const {
+      return splice_left;
+    }
+
     ///	@brief Closes the TCP socket and removes it from parent's accepted connections list.
     ///	@return Error code or no_error on successful close.
     ///	@note Accepted sockets will be automatically closed when the server object is destroyed.
+    ///	  Safe to call from any thread, also after the server was destroyed (the descriptor is not closed twice).
     int close () {
-      if (this->state == state_e::opened && parent)
-        for (size_t i = 0; i < parent->accept_clients.size (); i++)
-          if (parent->accept_clients[i] == this->sock)
-            parent->accept_clients.erase (parent->accept_clients.begin () + i);
+      if (this->state != state_e::created && parent && accept_clients) {
+        if (!accept_clients->remove (accept_handle))
+          this->sock = INVALID_SOCKET; // already closed by the server, the number may belong to another socket now
+        accept_clients.reset ();
+      }
+      zerocopy      = false;
+      zerocopy_next = zerocopy_base = zerocopy_copy = zerocopy_done = 0;
+      #ifdef IP_SOCKETS_HAS_SPLICE // LINUX OS
+        if (splice_pipe[0] != -1) {
+          ::close (splice_pipe[0]);
+          ::close (splice_pipe[1]);
+          splice_pipe[0] = splice_pipe[1] = -1;
+        }
+      #endif
+      splice_offset = splice_left = 0;
       return base_socket_t::close ();
     }
 
@@ -128,8 +554,11 @@ namespace ipsockets {
     ///	@details Platform-specific behavior:
     ///	  - On Linux: Uses SO_RCVTIMEO socket option for timeout handling
     ///	  - On Windows: Uses WSAPoll() with timeout from SO_RCVTIMEO (or default 1000ms) to simulate accept timeout
+    ///	  - In non-blocking mode (set_nonblocking()) does not wait at all, failure without a pending connection is error_would_block
     ///	@note The accepted socket is automatically added to parent's accepted connections list
     ///	  and will have its parent pointer set to this server socket.
+    ///	  It inherits the options of this server socket (see open() overload with socket_options_t); options that could
+    ///	  not be applied are logged and left out of its options member, the connection is returned anyway.
     template <socket_type_e SOCK = Socket_type, std::enable_if_t<SOCK == socket_type_e::server, bool> = true>
     tcp_socket_t<Ip_type, socket_type_e::client> accept (address_t& address_from, bool* success = nullptr) {
 
@@ -139,11 +568,14 @@ namespace ipsockets {
 
       int cerr = no_error;
 
-      if (this->state       != state_e::opened) cerr = error_closed_or_not_open;
-      if (this->socket_type != socket_type_e::server) cerr = error_not_allowed;
+      if (this->state       != state_e::opened || !accept_clients) cerr = error_closed_or_not_open;
+      if (this->socket_type != socket_type_e::server)                cerr = error_not_allowed;
 
       if (cerr != no_error) {
         this->log_and_return ('-', "accept", cerr);
+        address_from = {};
+        if (success)
+          *success = false;
         return result;
       }
 
@@ -162,6 +594,7 @@ namespace ipsockets {
           int   optlen   = sizeof (tv_dword);
           if (getsockopt (this->sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&tv_dword, &optlen) != SOCKET_ERROR)
             tv_ms = (int)tv_dword;
+          if (this->nonblocking) tv_ms = 0;
 
           WSAPOLLFD pfd;
           pfd.fd     = this->sock;
@@ -173,6 +606,7 @@ namespace ipsockets {
           if (getsockopt (this->sock, SOL_SOCKET, SO_RCVTIMEO, (char*)&tv_val, &tv_len) != SOCKET_ERROR)
             tv_ms = (int)(tv_val.tv_sec * 1000 + tv_val.tv_usec / 1000);
           if (tv_ms <= 0) tv_ms = 1000;
+          if (this->nonblocking) tv_ms = 0;
 
           pollfd pfd;
           pfd.fd     = this->sock;
@@ -182,7 +616,7 @@ namespace ipsockets {
 
         if (rv == 0) {
           result.sock = INVALID_SOCKET;
-          cerr        = error_timeout;
+          cerr        = (this->nonblocking) ? error_would_block : error_timeout;
         }
         else if (rv > 0 && (pfd.revents & (POLLIN
           #ifdef _WIN32
@@ -209,20 +643,36 @@ namespace ipsockets {
       address_from          = this->sockaddr2address (addr_from);
 
       result.address_remote = address_from;
-      result.address_local  = result._getsockname ();
-      result.state          = state_e::opened;
-      //result.log_level      = this->log_level; set via constructor
-      result.parent         = this;
-      result.tname          = std::string ("tcp<") + ((this->ip_type == v4) ? "ip4," : "ip6,") + "accept>";
-
-      result.log_and_return ('-', "accept", no_error);
-      accept_clients.push_back (result.sock);
+      _attach_accepted (result, "accept");
       if (success)
         *success = true;
       return result;
 
     }
 
+    ///	@brief Wraps a connection accepted outside of accept() (e.g. by uring_engine_t) into a client socket of this server.
+    ///	@param fd - OS descriptor of the accepted connection; ownership passes to the returned socket.
+    ///	@return tcp_socket_t<Ip_type, socket_type_e::client> A client socket representing the accepted connection,
+    ///	  exactly as if it was returned by accept(). If fd is invalid or this server socket is not opened,
+    ///	  fd is closed and a default-constructed client socket is returned (with state == state_e::state_created).
+    template <socket_type_e SOCK = Socket_type, std::enable_if_t<SOCK == socket_type_e::server, bool> = true>
+    tcp_socket_t<Ip_type, socket_type_e::client> adopt (socket_t fd) {
+
+      tcp_socket_t<Ip_type, socket_type_e::client> result (this->log_level);
+
+      if (fd == INVALID_SOCKET || this->state != state_e::opened || !accept_clients) {
+        if (fd != INVALID_SOCKET)
+          closesocket (fd);
+        this->log_and_return ('-', "adopt", (fd == INVALID_SOCKET) ? error_not_allowed : error_closed_or_not_open);
+        return result;
+      }
+
+      result.sock           = fd;
+      result.address_remote = result._getpeername ();
+      _attach_accepted (result, "adopt");
+      return result;
+    }
+
     ///	@brief Resolves a hostname to an IP address using DNS.
     ///	@param      hostname  - Hostname to resolve (e.g., "example.com").
     ///	@param[out] success   - Optional output flag. If non-null, set to true on successful resolution, false on failure.
@@ -238,23 +688,106 @@ namespace ipsockets {
 
   private:
 
+    /// @brief Creates the splice_from() pipe (or the fallback buffer) once, returns how many bytes it holds.
+    int _splice_open () {
+      #ifdef IP_SOCKETS_HAS_SPLICE // LINUX OS
+        if (splice_pipe[0] != -1)
+          return splice_size;
+        if (splice_buffer.empty () && pipe2 (splice_pipe, O_CLOEXEC | O_NONBLOCK) == 0) {
+          fcntl (splice_pipe[0], F_SETPIPE_SZ, 1 << 20); // bigger pipe, fewer calls; above /proc/sys/fs/pipe-max-size the default 64KB stays
+          splice_size = fcntl (splice_pipe[0], F_GETPIPE_SZ);
+          if (splice_size <= 0)
+            splice_size = 65536;
+          this->log_and_return ('-', "splice_from", no_error, "pipe created");
+          return splice_size;
+        }
+        splice_pipe[0] = splice_pipe[1] = -1;
+      #endif
+      if (splice_buffer.empty ())
+        splice_buffer.resize (65536);
+      return (int)splice_buffer.size ();
+    }
+
+    /// @brief Sends splice_left bytes held by the pipe (or the fallback buffer) to this socket.
+    /// @return Number of bytes sent, or error code if nothing was sent.
+    int _splice_flush () {
+      int sent = 0;
+      while (splice_left > 0) {
+        #ifdef IP_SOCKETS_HAS_SPLICE // LINUX OS
+          int res = (splice_pipe[0] != -1)
+            ? (int)::splice (splice_pipe[0], nullptr, this->sock, nullptr, (size_t)splice_left, SPLICE_F_MOVE)
+            : (int)::send (this->sock, splice_buffer.data () + splice_offset, (size_t)splice_left, 0);
+        #else
+          int res = (int)::send (this->sock, splice_buffer.data () + splice_offset, splice_left, 0);
+        #endif
+        if (res == SOCKET_ERROR) {
+          int err = this->_get_err ();
+          return (sent > 0) ? this->log_and_return ('>', "splice_from", no_error, "sended", sent) : this->log_and_return ('>', "splice_from", err);
+        }
+        if (res == 0)
+          break;
+        splice_offset += res;
+        splice_left   -= res;
+        sent          += res;
+      }
+      return this->log_and_return ('>', "splice_from", no_error, "sended", sent);
+    }
+
     /// @brief Returns default type name for logging in static methods (e.g. resolve()).
     static inline std::string _get_tname () {
       return std::string ("tcp<") + ((Ip_type == v4) ? "ip4," : "ip6,") + ((Socket_type == socket_type_e::server) ? "server>" : "client>");
     }
 
+    /// @brief Common tail of accept() and adopt(): marks the connection opened and registers it in accept_clients (O(1), thread-safe).
+    void _attach_accepted (tcp_socket_t<Ip_type, socket_type_e::client>& result, const char* func) {
+      result.address_local  = result._getsockname ();
+      result.state          = state_e::opened;
+      //result.log_level      = this->log_level; set via constructor
+      result.parent         = this;
+      result.tname          = std::string ("tcp<") + ((this->ip_type == v4) ? "ip4," : "ip6,") + "accept>";
+
+      result.log_and_return ('-', func, no_error);
+
+      // inherit tuning options: Linux copies them from the listening socket except TCP_QUICKACK, elsewhere set them again;
+      // set_options() records in result.options only what it applied, a failure leaves the connection usable
+      #ifdef __linux__
+        socket_options_t own;
+        own.quick_ack            = this->options.quick_ack;
+        result.options           = this->options;
+        result.options.quick_ack = -1;
+      #else
+        socket_options_t own = this->options;
+      #endif
+      if (result.set_options (own) != no_error)
+        result.log_and_return ('-', func, error_not_allowed, "server options not applied to the accepted socket");
+
+      result.accept_clients = accept_clients;
+      result.accept_handle  = accept_clients->add (result.sock);
+    }
+
   };
 
   // ============================================================
   // tcp_streambuf_t — std::streambuf adapter for tcp_socket_t
   // ============================================================
 
+  /// @brief std::streambuf over a TCP socket with direct access to the receive buffer.
+  /// @details The receive buffer is linear: unread bytes are moved to its front only when there is no room after
+  ///   them, so the get area is always contiguous and peek() hands it out without copying. Reads and writes
+  ///   bigger than the buffers go straight between the socket and the caller's memory (xsgetn()/xsputn()).
+  ///   Moving the streambuf keeps buffered input and output.
   template <ip_type_e Ip_type, socket_type_e Socket_type>
   struct tcp_streambuf_t : public std::streambuf {
 
     using tcp_t     = tcp_socket_t<Ip_type, Socket_type>;
     using address_t = addr_t<Ip_type>;
 
+    /// @brief Unread bytes of the receive buffer, returned by peek(). Valid until the next read from the stream.
+    struct view_t {
+      const char* data = nullptr; ///< First unread byte
+      std::size_t size = 0;       ///< Number of unread bytes at data
+    };
+
     tcp_t             sock;
     std::vector<char> input_buffer;
     std::vector<char> output_buffer;
@@ -263,6 +796,7 @@ namespace ipsockets {
     int last_write_error = no_error;
 
     static const std::size_t default_bufsize = 8192;
+    static const std::size_t putback_size    = 8;    ///< Already read bytes kept before the unread ones on refill, for unget()/putback()
 
     /// @brief Constructs a streambuf from an already-opened TCP socket.
     /// @param sock_   - TCP socket (moved into the streambuf).
@@ -283,30 +817,45 @@ namespace ipsockets {
       output_buffer    (std::move (other.output_buffer)),
       last_read_error  (other.last_read_error),
       last_write_error (other.last_write_error) {
-      // recalculate get area pointers relative to new buffer
-      // after move, the old pointers are invalid, reset to empty
-      setg (input_buffer.data (), input_buffer.data (), input_buffer.data ());     // set get area to empty (will be filled on first read)
-      setp (output_buffer.data (), output_buffer.data () + output_buffer.size ()); // set put area to full buffer
+      // the copied area pointers are offsets into the moved buffers: keep unread input and unsent output
+      std::ptrdiff_t read  = gptr ()  - eback ();
+      std::ptrdiff_t end   = egptr () - eback ();
+      std::ptrdiff_t put   = pptr ()  - pbase ();
+      setg (input_buffer.data (), input_buffer.data () + read, input_buffer.data () + end);
+      setp (output_buffer.data (), output_buffer.data () + output_buffer.size ());
+      pbump ((int)put);
+      other.setg (nullptr, nullptr, nullptr); // the moved-from object must not flush our output in its destructor
+      other.setp (nullptr, nullptr);
     }
 
     ~tcp_streambuf_t () {
       flush ();
     }
 
-    /// @brief Sends all buffered output data through the socket.
-    /// @return true on success, false on error.
+    /// @brief Sends all buffered output data through the socket, repeating partial sends.
+    /// @return true on success, false on error (see last_write_error); bytes not sent stay buffered for the next flush().
     bool flush () {
-      std::ptrdiff_t size = pptr () - pbase ();
-      if (size > 0) {
-        int n = sock.send (pbase (), (int)size);
-        if (n != (int)size) {
-          last_write_error = n;
-          return false;
-        }
-        last_write_error = no_error;
-      }
-      setp (output_buffer.data (), output_buffer.data () + output_buffer.size ()); // reset put area to full buffer
-      return true;
+      if (pptr () == pbase ())
+        return true;
+      _write (nullptr, 0);
+      return pptr () == pbase ();
+    }
+
+    /// @brief Returns at least n unread bytes without consuming them, receiving more data if needed.
+    /// @param n - Number of bytes wanted; 0 returns what is buffered without touching the socket.
+    /// @return View of all unread bytes. It is shorter than n if the connection was closed or failed (see last_read_error).
+    /// @details The receive buffer grows when n exceeds it. A line parser asks for one byte more than
+    ///   the previous view held until it finds the delimiter, then calls consume().
+    view_t peek (std::size_t n = 0) {
+      while ((std::size_t)(egptr () - gptr ()) < n && _fill (n))
+        ;
+      return view_t { gptr (), (std::size_t)(egptr () - gptr ()) };
+    }
+
+    /// @brief Marks n bytes of the last peek() view as read (at most the number of unread bytes).
+    void consume (std::size_t n) {
+      std::size_t unread = (std::size_t)(egptr () - gptr ());
+      gbump ((int)std::min (n, unread));
     }
 
     state_e   state ()          const { return sock.state; }          ///< @brief Returns the current socket state.
@@ -322,7 +871,7 @@ namespace ipsockets {
           return traits_type::eof ();         // flush failed, return eof to indicate error
         *pptr () = traits_type::to_char_type (ch);
         pbump (1);
-      }     
+      }
       else if (!flush ())                     // if ch is eof, just flush the buffer
         return traits_type::eof ();           // flush failed, return eof to indicate error
       return traits_type::not_eof (ch);
@@ -332,15 +881,8 @@ namespace ipsockets {
     int_type underflow () override {
       if (gptr () < egptr ())
         return traits_type::to_int_type (*gptr ());
-
-      int n = sock.recv (input_buffer.data (), (int)input_buffer.size ());
-      if (n <= 0) {
-        last_read_error = n;
+      if (!_fill (1))
         return traits_type::eof ();
-      }
-      last_read_error = no_error;
-
-      setg (input_buffer.data (), input_buffer.data (), input_buffer.data () + n); // set get area to the newly read data
       return traits_type::to_int_type (*gptr ());
     }
 
@@ -349,6 +891,110 @@ namespace ipsockets {
       return flush () ? 0 : -1;
     }
 
+    // istream::read(): buffered bytes first, a remainder as big as the buffer is received straight into s
+    std::streamsize xsgetn (char* s, std::streamsize n) override {
+      std::streamsize done = 0;
+      while (done < n) {
+        std::streamsize unread = egptr () - gptr ();
+        if (unread > 0) {
+          std::streamsize take = std::min (unread, n - done);
+          memcpy (s + done, gptr (), (size_t)take);
+          gbump ((int)take);
+          done += take;
+        }
+        else if (n - done >= (std::streamsize)input_buffer.size ()) {
+          int res = sock.recv (s + done, (int)std::min (n - done, (std::streamsize)INT_MAX));
+          if (res <= 0) {
+            last_read_error = res;
+            break;
+          }
+          last_read_error = no_error;
+          done           += res;
+          setg (input_buffer.data (), input_buffer.data (), input_buffer.data ()); // putback context is not in the buffer anymore
+        }
+        else if (!_fill (1))
+          break;
+      }
+      return done;
+    }
+
+    // ostream::write(): small data is buffered, data as big as the buffer is sent together with the buffered bytes (one sendv())
+    std::streamsize xsputn (const char* s, std::streamsize n) override {
+      std::streamsize space = epptr () - pptr ();
+      if (n >= (std::streamsize)output_buffer.size ())
+        return _write (s, n);
+      std::streamsize take = std::min (n, space);
+      memcpy (pptr (), s, (size_t)take);
+      pbump ((int)take);
+      if (take == n)
+        return n;
+      if (!flush ())
+        return take;
+      memcpy (pptr (), s + take, (size_t)(n - take));
+      pbump ((int)(n - take));
+      return n;
+    }
+
+    /// @brief Receives more data after the unread bytes; makes room first by moving them to the front (or growing the buffer to hold want bytes).
+    /// @return false if the connection was closed or failed (last_read_error is set).
+    bool _fill (std::size_t want) {
+      std::size_t unread = (std::size_t)(egptr () - gptr ());
+      std::size_t keep   = std::min ((std::size_t)(gptr () - eback ()), (std::size_t)putback_size);
+      std::size_t need   = std::max (want, unread + 1);
+      std::size_t tail   = (std::size_t)(input_buffer.data () + input_buffer.size () - egptr ());
+
+      if (unread == 0 || tail < need - unread) { // moving is cheap when nothing is unread, otherwise only when out of room
+        char* from = gptr () - keep;
+        if (keep + need > input_buffer.size ()) {
+          std::vector<char> grown (std::max (keep + need, input_buffer.size () * 2));
+          memcpy (grown.data (), from, keep + unread);
+          input_buffer.swap (grown);
+        }
+        else if (from != input_buffer.data ())
+          memmove (input_buffer.data (), from, keep + unread);
+        setg (input_buffer.data (), input_buffer.data () + keep, input_buffer.data () + keep + unread);
+      }
+
+      char* end = input_buffer.data () + input_buffer.size ();
+      int   res = sock.recv (egptr (), (int)std::min ((std::size_t)(end - egptr ()), (std::size_t)INT_MAX));
+      if (res <= 0) {
+        last_read_error = res;
+        return false;
+      }
+      last_read_error = no_error;
+      setg (eback (), gptr (), egptr () + res);
+      return true;
+    }
+
+    /// @brief Sends the buffered output followed by len bytes of data, gathered into one sendv() per attempt, until all is sent or an error.
+    /// @return Number of bytes of data sent. Buffered bytes that were not sent are kept at the front of the buffer.
+    std::streamsize _write (const char* data, std::streamsize len) {
+      std::size_t     head      = (std::size_t)(pptr () - pbase ());
+      std::size_t     head_sent = 0;
+      std::streamsize sent      = 0;
+      while (head_sent < head || sent < len) {
+        io_vec_t parts[2];
+        int      count = 0;
+        if (head_sent < head) parts[count++] = io_vec_t (pbase () + head_sent, (int)(head - head_sent));
+        if (sent < len)       parts[count++] = io_vec_t (data + sent, (int)std::min (len - sent, (std::streamsize)INT_MAX));
+        int res = sock.sendv (parts, count);
+        if (res <= 0) {
+          last_write_error = (res == 0) ? error_other : res;
+          break;
+        }
+        std::size_t from_head = std::min ((std::size_t)res, head - head_sent);
+        head_sent += from_head;
+        sent      += res - (int)from_head;
+      }
+      if (head_sent == head && sent == len)
+        last_write_error = no_error;
+      if (head_sent != 0)
+        memmove (output_buffer.data (), pbase () + head_sent, head - head_sent);
+      setp (output_buffer.data (), output_buffer.data () + output_buffer.size ());
+      pbump ((int)(head - head_sent));
+      return sent;
+    }
+
   };
 
   // ============================================================
@@ -11,6 +11,8 @@
 #include "ip_address.h"
 
 #include <algorithm>
+#include <atomic>
+#include <cstdio>  //snprintf
 #include <cstring> //memset
 #include <iostream>
 #include <sstream>
@@ -68,12 +70,44 @@
   #include <unistd.h> // Needed for close()
   #include <fcntl.h>  // Needed for fcntl() to set non-blocking mode
   #include <poll.h>   // Needed for poll() to implement connect with timeout
+  #include <netinet/tcp.h> // Needed for TCP_NODELAY, TCP_CORK, TCP_KEEPIDLE and other TCP level options
   #ifndef closesocket
     #define closesocket(s) ::close(s) // windows uses closesocket(), while linux uses standard close() for descriptors
   #endif
   using socket_t = int;
   #define SOCKET_ERROR   -1
   #define INVALID_SOCKET -1 // since windows returns a pointer, error will be different value "~0" (inverted zero)
+  #if defined(__linux__) && defined(_GNU_SOURCE)
+    #define IP_SOCKETS_HAS_MMSG 1 // recvmmsg() and sendmmsg() are declared in sys/socket.h
+  #endif
+  #if defined(__linux__)
+    #include <netinet/udp.h> // Needed for UDP_SEGMENT and UDP_GRO segmentation offload options
+    #ifndef SOL_UDP
+      #define SOL_UDP 17
+    #endif
+    #ifndef UDP_SEGMENT
+      #define UDP_SEGMENT 103 // available since linux 4.18, older headers may not define it
+    #endif
+    #ifndef UDP_GRO
+      #define UDP_GRO 104     // available since linux 5.0, older headers may not define it
+    #endif
+    #define IP_SOCKETS_HAS_UDP_OFFLOAD 1
+  #endif
+#endif
+
+// compile-time log floor: messages below this level are removed from the binary regardless of log_level
+// 0 = debug (everything can be enabled at run time), 1 = info, 2 = error, 3 = none (no logging code at all)
+#ifndef IP_SOCKETS_CPP_LITE_LOG_LEVEL
+  #define IP_SOCKETS_CPP_LITE_LOG_LEVEL 0
+#endif
+
+// marks rarely executed functions (message formatting) so they are placed out of the hot path
+#if defined(__GNUC__) || defined(__clang__)
+  #define IP_SOCKETS_COLD __attribute__ ((cold, noinline))
+#elif defined(_MSC_VER)
+  #define IP_SOCKETS_COLD __declspec (noinline)
+#else
+  #define IP_SOCKETS_COLD
 #endif
 
 // server:
@@ -165,6 +199,9 @@ namespace ipsockets {
     none
   };
 
+  /// @brief Lowest log level compiled into the library, set by IP_SOCKETS_CPP_LITE_LOG_LEVEL (0..3).
+  static constexpr log_e compiled_log_level = (log_e)IP_SOCKETS_CPP_LITE_LOG_LEVEL;
+
   enum class state_e {
     created,  ///< socket object created (or was closed); no OS descriptor allocated
     prepared, ///< OS descriptor allocated (socket() called); bind/connect may be in progress or failed
@@ -189,7 +226,8 @@ namespace ipsockets {
     error_unreachable        = -6, ///< Destination unreachable (ECONNREFUSED, WSAECONNRESET, ICMP error)
     error_not_allowed        = -7, ///< Operation not allowed (e.g. recv on server socket, setsockopt failed)
     error_invalid_address    = -8, ///< Invalid remote address specified (EADDRNOTAVAIL)
-    error_other              = -9  ///< Unrecognized OS error (original OS error code is logged)
+    error_other              = -9, ///< Unrecognized OS error (original OS error code is logged)
+    error_would_block        = -10 ///< Non-blocking socket: no data to read / no space to write right now (EWOULDBLOCK)
   };
 
   template <ip_type_e Ip_type>
@@ -210,6 +248,225 @@ namespace ipsockets {
   template <ip_type_e Ip_type>
   using make_sockaddr_in_t = typename make_sockaddr_in<Ip_type>::type;
 
+  /// @brief Datagram descriptor for udp_socket_t::recv_batch(): caller provides the buffer, socket fills the rest.
+  template <ip_type_e Ip_type>
+  struct udp_recv_msg_t {
+    char*           buf     = nullptr; ///< [in]  Buffer to store received datagram
+    int             buf_len = 0;       ///< [in]  Capacity of buf in bytes
+    int             len     = 0;       ///< [out] Number of bytes received into buf
+    addr_t<Ip_type> address = {};      ///< [out] Sender address of the datagram
+  };
+
+  /// @brief Datagram descriptor for udp_socket_t::send_batch() and udp_socket_t::sendto_batch().
+  template <ip_type_e Ip_type>
+  struct udp_send_msg_t {
+    const char*     buf     = nullptr; ///< Data to send
+    int             len     = 0;       ///< Number of bytes to send from buf
+    addr_t<Ip_type> address = {};      ///< Destination address (ignored by send_batch())
+  };
+
+  /// @brief Buffer descriptor for the gather/scatter calls sendv(), sendtov() and recvv().
+  struct io_vec_t {
+    char* buf = nullptr; ///< Data to send, or buffer to receive into
+    int   len = 0;       ///< Number of bytes in buf
+
+    io_vec_t () = default;
+    io_vec_t (char* data, int length) : buf (data), len (length) {}
+    io_vec_t (const char* data, int length) : buf ((char*)data), len (length) {} ///< For sendv()/sendtov(), they never write into buf
+  };
+
+  /// @brief UDP segmentation offload settings for udp_socket_t::open().
+  /// @details On Linux the kernel (or NIC) splits one large buffer into gso_size datagrams (UDP_SEGMENT)
+  ///   and coalesces consecutive received datagrams of one flow into one buffer (UDP_GRO).
+  ///   On other platforms send_gso()/sendto_gso() split the buffer in user space and recvfrom_gro()
+  ///   returns single datagrams, so the same code works everywhere.
+  struct udp_offload_t {
+    uint16_t gso_size = 0;     ///< Default segment size for send_gso()/sendto_gso(), 0 = segment size must be passed per call
+    bool     gro      = false; ///< Enable receive coalescing, segment size is reported by recvfrom_gro()
+  };
+
+  /// @brief Socket tuning options for open(), set_options() and sockets returned by tcp_socket_t::accept().
+  /// @details Fields left at their defaults (-1 or 0) are not touched, so the OS defaults stay in effect.
+  ///   open() applies them after socket() and before bind()/connect(), which is required for buffer sizes
+  ///   (TCP window scale is negotiated in the handshake). TCP options are ignored on UDP sockets.
+  ///   Sockets accepted by a server socket inherit its options: Linux copies them from the listening socket
+  ///   (except TCP_QUICKACK, which is set again), other platforms set all of them again.
+  struct socket_options_t {
+    int8_t   no_delay        = -1; ///< TCP_NODELAY: 1 sends small segments at once (no Nagle), 0 = off, -1 = untouched
+    int8_t   cork            = -1; ///< TCP_CORK (TCP_NOPUSH on BSD/macOS): 1 holds partial segments until uncorked
+    int8_t   quick_ack       = -1; ///< TCP_QUICKACK (Linux): 1 disables delayed ACKs, the kernel may reset it later
+    int8_t   keepalive       = -1; ///< SO_KEEPALIVE: 1 probes idle connections
+    int32_t  send_buffer     = 0;  ///< SO_SNDBUF in bytes, 0 = untouched
+    int32_t  recv_buffer     = 0;  ///< SO_RCVBUF in bytes, 0 = untouched
+    int32_t  keep_idle_s     = 0;  ///< TCP_KEEPIDLE (TCP_KEEPALIVE on macOS): idle seconds before the first probe
+    int32_t  keep_interval_s = 0;  ///< TCP_KEEPINTVL: seconds between probes
+    int32_t  keep_count      = 0;  ///< TCP_KEEPCNT: unanswered probes before the connection is dropped
+    uint32_t user_timeout_ms = 0;  ///< TCP_USER_TIMEOUT (Linux): unacknowledged data older than this drops the connection
+    uint32_t notsent_lowat   = 0;  ///< TCP_NOTSENT_LOWAT: unsent bytes above which the socket is not writable
+    uint32_t busy_poll_us    = 0;  ///< SO_BUSY_POLL (Linux): busy poll the device queue on blocking receive, in microseconds
+  };
+
+  // ============================================================
+  // log sink — destination of socket log messages
+  // ============================================================
+
+  /// @brief One log message as structured fields; the text is produced only by the sink (possibly on another thread).
+  struct log_record_t {
+    static const int64_t fd_static = -2; ///< fd value of messages from static functions (resolve)
+
+    char        tname[32] = {};      ///< Socket type name, e.g. "udp<ip4,client>"
+    int64_t     fd        = -1;      ///< OS descriptor, -1 if the socket has none
+    const char* func      = "";      ///< Function name (string literal)
+    char        dir       = '-';     ///< '>' send, '<' receive, '-' other
+    ip_type_e   ip_type   = v4;      ///< Address family of local/remote
+    addr6_t     local     = {};      ///< Local address, ipv4 is stored as ipv4-mapped ipv6 (see log_address())
+    addr6_t     remote    = {};      ///< Remote address, same encoding as local
+    int         bytes     = -1;      ///< Bytes transferred, -1 if not applicable
+    int         err       = 0;       ///< Original OS error code, 0 if none
+    int         cerr      = 0;       ///< error_e code
+    const char* mes       = nullptr; ///< Additional message (string literal) or nullptr
+    std::string text;                ///< Preformatted tail of rare messages (resolve), replaces addresses and error text
+  };
+
+  /// @brief Converts a socket address to the log_record_t encoding.
+  inline addr6_t log_address (const addr4_t& address) { return addr6_t (ip6_t (address.ip), address.port); }
+  inline addr6_t log_address (const addr6_t& address) { return address; }
+
+  /// @brief Appends the text of a record (one line, with trailing newline) to out.
+  /// @details Layout: tname: [fd].func() [local -> remote] mes (N bytes | status[, system answer: text]), e.g.
+  ///   udp<ip4,client>: [3].send() [127.0.0.1:59032 -> 127.0.0.1:2999] sended 7 bytes
+  ///   udp<ip4,client>: [3].recv() [127.0.0.1:59032 <- 127.0.0.1:2999] unreachable error, system answer: Connection refused
+  inline std::string& format_log_record (const log_record_t& record, std::string& out) {
+
+    out += record.tname;
+    out += ": ";
+
+    char fd_text[24];
+    if      (record.fd == log_record_t::fd_static) out += "[static]";
+    else if (record.fd < 0)                         out += "[undefined]";
+    else {
+      snprintf (fd_text, sizeof (fd_text), "[%llx]", (unsigned long long)record.fd);
+      out += fd_text;
+    }
+
+    out += '.';
+    out += record.func;
+    out += "() ";
+
+    if (!record.text.empty ()) {
+      out += record.text;
+      out += '\n';
+      return out;
+    }
+
+    const addr6_t* addrs[2] = { &record.local, &record.remote };
+    std::string    names[2];
+    for (int i = 0; i < 2; i++)
+      if (addrs[i]->port == 0)
+        names[i] = "undefined";
+      else if (record.ip_type == v4) {
+        ip4_t ip4;
+        memcpy (ip4.data (), addrs[i]->ip.data () + 12, 4); // ipv4-mapped ::ffff:x.x.x.x
+        names[i] = addr4_t (ip4, addrs[i]->port).to_str ();
+      }
+      else
+        names[i] = addrs[i]->to_str ();
+
+    out += '[';
+    out += names[0];
+    out += (record.dir == '>') ? " -> " : (record.dir == '<') ? " <- " : " <> ";
+    out += names[1];
+    out += "] ";
+
+    if (record.mes) {
+      out += record.mes;
+      out += ' ';
+    }
+
+    if (record.bytes >= 0) {
+      out += std::to_string (record.bytes);
+      out += " bytes\n";
+      return out;
+    }
+
+    const char* ctext;
+    switch (record.cerr) {
+      case no_error:                 ctext = "success";                            break;
+      case error_tcp_closed:         ctext = "error, socket closed by other side"; break;
+      case error_already_opened:     ctext = "error, socket already opened";       break;
+      case error_open_failed:        ctext = "error, failed to open socket";       break;
+      case error_closed_or_not_open: ctext = "error, use closed socket";           break;
+      case error_timeout:            ctext = "receive timeout";                    break;
+      case error_unreachable:        ctext = "unreachable error";                  break;
+      case error_not_allowed:        ctext = "error, not allowed on this mode";    break;
+      case error_invalid_address:    ctext = "error address";                      break;
+      case error_would_block:        ctext = "would block";                        break;
+      default:                       ctext = "error";                              break;
+    }
+    out += ctext;
+
+    if (record.err <= 0) {
+      out += '\n';
+      return out;
+    }
+
+    // get error description text
+    out += ", system answer: ";
+    #ifdef _WIN32 // WINDOWS OS
+      LPSTR sysmes       = NULL;
+      DWORD dwLanguageId = 0x0409; // us-en    for russian leave 0x0000;
+      DWORD dwFlags      = FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS;
+      FormatMessageA (dwFlags, NULL, record.err, dwLanguageId, (LPSTR)&sysmes, 0, NULL);
+      if (sysmes) out += sysmes; // system text already ends with a newline
+      else        out += '\n';
+      LocalFree (sysmes);
+    #else         // LINUX OS
+      out += strerror (record.err);
+      out += '\n';
+    #endif
+    return out;
+
+  }
+
+  /// @brief Destination of log messages of all sockets, see set_log_sink().
+  /// @details write() is called on the thread that produced the message, so it must be thread safe.
+  struct log_sink_t {
+    virtual ~log_sink_t () = default;
+    virtual void write (const log_record_t& record) = 0; ///< Consumes one message
+    virtual void flush () {}                              ///< Writes out buffered messages, if any
+  };
+
+  /// @brief Default sink: formats the record on the calling thread and prints it to std::cout.
+  struct cout_log_sink_t : log_sink_t {
+    void write (const log_record_t& record) override {
+      std::string line;
+      format_log_record (record, line);
+      std::cout << line;
+    }
+    void flush () override {
+      std::cout.flush ();
+    }
+  };
+
+  /// @brief Returns the storage of the current sink pointer (nullptr means the default cout sink).
+  inline std::atomic<log_sink_t*>& log_sink_slot () {
+    static std::atomic<log_sink_t*> sink { nullptr };
+    return sink;
+  }
+
+  /// @brief Routes log messages of all sockets to sink; nullptr restores the default std::cout sink.
+  /// @details The sink must outlive every socket that may still log (including their destructors).
+  inline void set_log_sink (log_sink_t* sink) {
+    log_sink_slot ().store (sink, std::memory_order_release);
+  }
+
+  /// @brief Returns the sink log messages are currently written to.
+  inline log_sink_t& get_log_sink () {
+    static cout_log_sink_t default_sink;
+    log_sink_t* sink = log_sink_slot ().load (std::memory_order_acquire);
+    return (sink != nullptr) ? *sink : default_sink;
+  }
+
   // forward declaration for friend access from tcp_socket_t
   template <ip_type_e Ip_type, socket_type_e Socket_type>
   struct tcp_socket_t;
@@ -235,10 +492,21 @@ namespace ipsockets {
     address_t address_local  = {};  ///< Local address:port assigned after open() (by kernel for clients, explicit for servers)
     address_t address_remote = {};  ///< Remote address:port (peer for clients, empty for servers until sendto/recvfrom)
 
+    udp_offload_t offload     = {};    ///< Segmentation offload settings, applied by open() (see open() overload with udp_offload_t); change them on an opened socket with set_offload()
+    socket_options_t options  = {};    ///< Tuning options, applied by open() and set_options(), inherited by accepted TCP sockets
+    bool          reuse_port  = false; ///< Server only: set SO_REUSEPORT before bind so several sockets share one address (see reuseport_group_t)
+    bool          nonblocking = false; ///< true after set_nonblocking(true): calls return immediately instead of waiting for SO_RCVTIMEO
+
     const int   type;      ///< OS socket type: SOCK_DGRAM (UDP), SOCK_RAW (UDP) or SOCK_STREAM (TCP), set at construction time
     const int   protocol;  ///< OS protocol: IPPROTO_UDP or IPPROTO_TCP, set at construction time
     std::string tname;     ///< Human-readable socket name for log messages, e.g. "udp<ip4,client>" or "tcp<ip6,server>"
 
+    static const int batch_max = 64; ///< Maximum number of datagrams handled by one recv_batch()/send_batch()/sendto_batch() call
+    static const int iov_max   = 64; ///< Maximum number of buffers handled by one sendv()/sendtov()/recvv() call
+
+    using recv_msg_t = udp_recv_msg_t<Ip_type>; ///< Datagram descriptor for recv_batch()
+    using send_msg_t = udp_send_msg_t<Ip_type>; ///< Datagram descriptor for send_batch()/sendto_batch()
+
     ///	@brief Constructor for UDP socket.
     ///	@param log_level_ - Logging level for this socket instance (default: log_e::info).
     udp_socket_t (log_e log_level_ = log_e::info, udp_type_e udp_type = udp_type_e::dgram)
@@ -251,10 +519,11 @@ namespace ipsockets {
 
     udp_socket_t (udp_socket_t&& os)
       : state (os.state), log_level (os.log_level), sock (os.sock),
-        address_local (os.address_local), address_remote (os.address_remote),
-        type (os.type), protocol (os.protocol), tname(std::move(os.tname)) {
+        address_local (os.address_local), address_remote (os.address_remote), offload (os.offload), options (os.options),
+        reuse_port (os.reuse_port), nonblocking (os.nonblocking), type (os.type), protocol (os.protocol), tname (os.tname) {
       os.state          = state_e::created;
       os.sock           = INVALID_SOCKET;
+      os.nonblocking    = false;
       os.address_local  = {};
       os.address_remote = {};
     }
@@ -298,6 +567,132 @@ namespace ipsockets {
       return sockaddr2address (addr);
     }
 
+    /// @brief poll()/WSAPoll() on this socket alone, see wait_readable().
+    int _wait (const char* func, short events, int timeout_ms) {
+
+      if (state != state_e::opened) return log_and_return ('-', func, error_closed_or_not_open);
+
+      #ifdef _WIN32 // WINDOWS OS
+        WSAPOLLFD pfd = {};
+        pfd.fd        = sock;
+        pfd.events    = events;
+        int rv        = WSAPoll (&pfd, 1, timeout_ms);
+      #else         // LINUX OS
+        pollfd pfd = {};
+        pfd.fd     = sock;
+        pfd.events = events;
+        int rv     = ::poll (&pfd, 1, timeout_ms);
+      #endif
+
+      if (rv == SOCKET_ERROR)     return log_and_return ('-', func, _get_err ());
+      if (rv == 0)                return error_timeout;
+      if (pfd.revents & POLLNVAL) return log_and_return ('-', func, error_closed_or_not_open);
+      return log_and_return ('-', func, no_error);
+    }
+
+    /// @brief setsockopt() of one int option with logging; any OS failure (EINVAL, ENOPROTOOPT, EPERM, ...) is error_not_allowed.
+    int _set_option (int level, int name, int value, const char* text) {
+      int res = setsockopt (sock, level, name, (char*)&value, sizeof (value));
+      if (res == SOCKET_ERROR) {
+        log_and_return ('-', "setsockopt", _get_err (), text);
+        return error_not_allowed;
+      }
+      return log_and_return ('-', "setsockopt", no_error, text);
+    }
+
+    /// @brief Sets UDP_SEGMENT and UDP_GRO where settings differ from current (Linux UDP sockets; elsewhere nothing to set).
+    int _apply_offload (const udp_offload_t& settings, const udp_offload_t& current) {
+      int res = no_error;
+      #ifdef IP_SOCKETS_HAS_UDP_OFFLOAD // LINUX OS
+        if (protocol != IPPROTO_UDP)
+          return res;
+        if (res == no_error && settings.gso_size != current.gso_size) res = _set_option (SOL_UDP, UDP_SEGMENT, settings.gso_size, "set UDP_SEGMENT");
+        if (res == no_error && settings.gro      != current.gro)      res = _set_option (SOL_UDP, UDP_GRO,     settings.gro,      "set UDP_GRO");
+      #else
+        (void)settings;
+        (void)current;
+      #endif
+      return res;
+    }
+
+    /// @brief Sets the fields of opts that are not left at their defaults (see socket_options_t), stops at the first failure.
+    int _apply_options (const socket_options_t& opts) {
+
+      int  res = no_error;
+      bool tcp = (protocol == IPPROTO_TCP);
+
+      if (res == no_error && opts.send_buffer > 0)    res = _set_option (SOL_SOCKET, SO_SNDBUF, opts.send_buffer, "set SO_SNDBUF");
+      if (res == no_error && opts.recv_buffer > 0)    res = _set_option (SOL_SOCKET, SO_RCVBUF, opts.recv_buffer, "set SO_RCVBUF");
+      if (res == no_error && opts.busy_poll_us != 0) {
+        #ifdef SO_BUSY_POLL // LINUX OS
+          res = _set_option (SOL_SOCKET, SO_BUSY_POLL, (int)opts.busy_poll_us, "set SO_BUSY_POLL");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "SO_BUSY_POLL is not supported");
+        #endif
+      }
+
+      if (!tcp)
+        return res;
+
+      if (res == no_error && opts.no_delay >= 0)      res = _set_option (IPPROTO_TCP, TCP_NODELAY,  opts.no_delay,  "set TCP_NODELAY");
+      if (res == no_error && opts.keepalive >= 0)     res = _set_option (SOL_SOCKET,  SO_KEEPALIVE, opts.keepalive, "set SO_KEEPALIVE");
+      if (res == no_error && opts.cork >= 0) {
+        #if defined(TCP_CORK)      // LINUX OS
+          res = _set_option (IPPROTO_TCP, TCP_CORK, opts.cork, "set TCP_CORK");
+        #elif defined(TCP_NOPUSH)  // BSD, MACOS
+          res = _set_option (IPPROTO_TCP, TCP_NOPUSH, opts.cork, "set TCP_NOPUSH");
+        #else                      // WINDOWS OS
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_CORK is not supported");
+        #endif
+      }
+      if (res == no_error && opts.quick_ack >= 0) {
+        #ifdef TCP_QUICKACK // LINUX OS
+          res = _set_option (IPPROTO_TCP, TCP_QUICKACK, opts.quick_ack, "set TCP_QUICKACK");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_QUICKACK is not supported");
+        #endif
+      }
+      if (res == no_error && opts.keep_idle_s > 0) {
+        #if defined(TCP_KEEPIDLE)    // LINUX, BSD, WINDOWS 10+
+          res = _set_option (IPPROTO_TCP, TCP_KEEPIDLE, opts.keep_idle_s, "set TCP_KEEPIDLE");
+        #elif defined(TCP_KEEPALIVE) // MACOS
+          res = _set_option (IPPROTO_TCP, TCP_KEEPALIVE, opts.keep_idle_s, "set TCP_KEEPALIVE");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_KEEPIDLE is not supported");
+        #endif
+      }
+      if (res == no_error && opts.keep_interval_s > 0) {
+        #ifdef TCP_KEEPINTVL
+          res = _set_option (IPPROTO_TCP, TCP_KEEPINTVL, opts.keep_interval_s, "set TCP_KEEPINTVL");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_KEEPINTVL is not supported");
+        #endif
+      }
+      if (res == no_error && opts.keep_count > 0) {
+        #ifdef TCP_KEEPCNT
+          res = _set_option (IPPROTO_TCP, TCP_KEEPCNT, opts.keep_count, "set TCP_KEEPCNT");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_KEEPCNT is not supported");
+        #endif
+      }
+      if (res == no_error && opts.user_timeout_ms != 0) {
+        #ifdef TCP_USER_TIMEOUT // LINUX OS
+          res = _set_option (IPPROTO_TCP, TCP_USER_TIMEOUT, (int)opts.user_timeout_ms, "set TCP_USER_TIMEOUT");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_USER_TIMEOUT is not supported");
+        #endif
+      }
+      if (res == no_error && opts.notsent_lowat != 0) {
+        #ifdef TCP_NOTSENT_LOWAT // LINUX, MACOS
+          res = _set_option (IPPROTO_TCP, TCP_NOTSENT_LOWAT, (int)opts.notsent_lowat, "set TCP_NOTSENT_LOWAT");
+        #else
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "TCP_NOTSENT_LOWAT is not supported");
+        #endif
+      }
+
+      return res;
+    }
+
     static int _get_err () {
       #ifdef _WIN32 // WINDOWS OS
         return WSAGetLastError ();
@@ -389,6 +784,176 @@ namespace ipsockets {
       return res;
     }
 
+    ///	@brief Common part of send_batch() and sendto_batch().
+    ///	@param msgs      - Array of datagram descriptors.
+    ///	@param count     - Number of descriptors in msgs.
+    ///	@param with_addr - true to send each datagram to its own address, false for connected socket.
+    ///	@param func      - Function name for log messages.
+    int _send_batch (const send_msg_t* msgs, int count, bool with_addr, const char* func) {
+
+      if (count <= 0)        return log_and_return ('>', func, error_not_allowed);
+      if (count > batch_max) count = batch_max;
+
+      // convert destinations once, consecutive datagrams to the same address reuse previous sockaddr
+      sockaddr_in_t addrs[batch_max];
+      int           addr_idx[batch_max];
+      if (with_addr)
+        for (int i = 0; i < count; i++) {
+          if (i > 0 && msgs[i].address == msgs[i - 1].address)
+            addr_idx[i] = addr_idx[i - 1];
+          else {
+            addr_idx[i] = i;
+            addrs[i]    = address2sockaddr (msgs[i].address);
+          }
+        }
+
+      int res   = 0;
+      int err   = no_error;
+      int total = 0;
+
+      #ifdef IP_SOCKETS_HAS_MMSG // LINUX OS
+        mmsghdr hdrs[batch_max];
+        iovec   iovs[batch_max];
+        memset (hdrs, 0, sizeof (mmsghdr) * count);
+        for (int i = 0; i < count; i++) {
+          iovs[i].iov_base           = (void*)msgs[i].buf;
+          iovs[i].iov_len            = (size_t)msgs[i].len;
+          hdrs[i].msg_hdr.msg_iov    = &iovs[i];
+          hdrs[i].msg_hdr.msg_iovlen = 1;
+          if (with_addr) {
+            hdrs[i].msg_hdr.msg_name    = &addrs[addr_idx[i]];
+            hdrs[i].msg_hdr.msg_namelen = sizeof (sockaddr_in_t);
+          }
+        }
+        res = ::sendmmsg (sock, hdrs, (unsigned int)count, 0);
+        err = _get_err ();
+        for (int i = 0; i < res; i++)
+          total += (int)hdrs[i].msg_len;
+      #else
+        for (; res < count; res++) {
+          int len = (with_addr)
+            ? ::sendto (sock, msgs[res].buf, msgs[res].len, 0, (sockaddr*)&addrs[addr_idx[res]], sizeof (sockaddr_in_t))
+            : ::send   (sock, msgs[res].buf, msgs[res].len, 0);
+          if (len == SOCKET_ERROR) {
+            if (res == 0) {
+              err = _get_err ();
+              res = SOCKET_ERROR;
+            }
+            break;
+          }
+          total += len;
+        }
+      #endif
+
+      if (res == SOCKET_ERROR) return log_and_return ('>', func, err);
+
+      if (with_addr)
+        address_remote = msgs[res - 1].address;
+      log_and_return ('>', func, no_error, "sended", total);
+      return res;
+    }
+
+    ///	@brief Common part of sendv() and sendtov(): one sendmsg()/WSASend() with up to iov_max buffers.
+    ///	@param vecs    - Buffers to send.
+    ///	@param count   - Number of buffers (> 0).
+    ///	@param addr_to - Destination in sockaddr format, or nullptr for connected socket.
+    ///	@param func    - Function name for log messages.
+    int _sendv (const io_vec_t* vecs, int count, const sockaddr_in_t* addr_to, const char* func) {
+
+      if (count > iov_max)
+        count = iov_max;
+
+      #ifdef _WIN32 // WINDOWS OS
+        WSABUF bufs[iov_max];
+        for (int i = 0; i < count; i++) {
+          bufs[i].buf = vecs[i].buf;
+          bufs[i].len = (ULONG)vecs[i].len;
+        }
+        DWORD sent = 0;
+        int   res  = (addr_to)
+          ? WSASendTo (sock, bufs, (DWORD)count, &sent, 0, (const sockaddr*)addr_to, sizeof (sockaddr_in_t), nullptr, nullptr)
+          : WSASend   (sock, bufs, (DWORD)count, &sent, 0, nullptr, nullptr);
+        if (res != SOCKET_ERROR)
+          res = (int)sent;
+      #else         // LINUX OS
+        iovec iovs[iov_max];
+        for (int i = 0; i < count; i++) {
+          iovs[i].iov_base = vecs[i].buf;
+          iovs[i].iov_len  = (size_t)vecs[i].len;
+        }
+        msghdr msg = {};
+        msg.msg_name    = (void*)addr_to;
+        msg.msg_namelen = (addr_to) ? sizeof (sockaddr_in_t) : 0;
+        msg.msg_iov     = iovs;
+        msg.msg_iovlen  = (size_t)count;
+        int res = (int)::sendmsg (sock, &msg, 0);
+      #endif
+      int err = _get_err ();
+
+      if (res == SOCKET_ERROR) return log_and_return ('>', func, err);
+      else                     return log_and_return ('>', func, no_error, "sended", res);
+    }
+
+    ///	@brief Common part of send_gso() and sendto_gso().
+    ///	@param buf          - Buffer with data to send.
+    ///	@param data_len     - Number of bytes to send.
+    ///	@param addr_to      - Destination in sockaddr format, or nullptr for connected socket.
+    ///	@param segment_size - Size of one datagram, 0 to use offload.gso_size.
+    ///	@param func         - Function name for log messages.
+    int _send_gso (const char* buf, int data_len, const sockaddr_in_t* addr_to, uint16_t segment_size, const char* func) {
+
+      if (data_len < 0)      return log_and_return ('>', func, error_not_allowed);
+      if (segment_size == 0) segment_size = offload.gso_size;
+      if (segment_size == 0) return log_and_return ('>', func, error_not_allowed, "segment size is not set");
+
+      int res = 0;
+      int err = no_error;
+
+      #ifdef IP_SOCKETS_HAS_UDP_OFFLOAD // LINUX OS
+        // one syscall, the kernel splits the buffer into segment_size datagrams (the last one may be shorter)
+        union {
+          char    buf[CMSG_SPACE (sizeof (uint16_t))];
+          cmsghdr align;
+        } control;
+        iovec  iov = { (void*)buf, (size_t)data_len };
+        msghdr msg = {};
+        msg.msg_name    = (void*)addr_to;
+        msg.msg_namelen = (addr_to) ? sizeof (sockaddr_in_t) : 0;
+        msg.msg_iov     = &iov;
+        msg.msg_iovlen  = 1;
+        // always pass the size: the socket default may be stale if offload was changed without set_offload()
+        memset (&control, 0, sizeof (control));
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = sizeof (control.buf);
+        cmsghdr* cm        = CMSG_FIRSTHDR (&msg);
+        cm->cmsg_level     = SOL_UDP;
+        cm->cmsg_type      = UDP_SEGMENT;
+        cm->cmsg_len       = CMSG_LEN (sizeof (uint16_t));
+        memcpy (CMSG_DATA (cm), &segment_size, sizeof (uint16_t));
+        res = (int)::sendmsg (sock, &msg, 0);
+        err = _get_err ();
+      #else
+        // software fallback: one syscall per segment
+        do {
+          int len    = (data_len - res < segment_size) ? data_len - res : segment_size;
+          int sended = (addr_to)
+            ? ::sendto (sock, buf + res, len, 0, (const sockaddr*)addr_to, sizeof (sockaddr_in_t))
+            : ::send   (sock, buf + res, len, 0);
+          if (sended == SOCKET_ERROR) {
+            if (res == 0) {
+              err = _get_err ();
+              res = SOCKET_ERROR;
+            }
+            break;
+          }
+          res += len;
+        } while (res < data_len);
+      #endif
+
+      if (res == SOCKET_ERROR) return log_and_return ('>', func, err);
+      else                     return log_and_return ('>', func, no_error, "sended", res);
+    }
+
   public:
 
     ///	@brief Opens a UDP socket and binds it to a local address (server) or connects to a remote address (client).
@@ -405,6 +970,7 @@ namespace ipsockets {
     ///	@details For server sockets:
     ///	  - Binds to the specified local address:port
     ///	  - Sets SO_REUSEADDR option to allow multiple listeners
+    ///	  - Sets SO_REUSEPORT option if reuse_port member is true
     ///	@details For client sockets:
     ///	  - Connects to the specified remote address:port with timeout via non-blocking connect + poll
     ///	  - Kernel automatically assigns local address:port
@@ -445,6 +1011,19 @@ namespace ipsockets {
         else                            log_and_return ('-', "setsockopt", no_error,    "set SO_REUSEADDR");
       }
 
+      // if requested, let several server sockets bind the same address, kernel balances incoming load between them
+      if (socket_type == socket_type_e::server && reuse_port) {
+        #ifdef SO_REUSEPORT // LINUX, BSD, MACOS
+          res = _set_option (SOL_SOCKET, SO_REUSEPORT, 1, "set SO_REUSEPORT");
+        #else         // WINDOWS OS
+          res = log_and_return ('-', "setsockopt", error_not_allowed, "SO_REUSEPORT is not supported");
+        #endif
+        if (res != no_error) {
+          close ();
+          return res;
+        }
+      }
+
       // set timeout for recv and recvfrom to periodically "unstick" and allow checking conditions
       #ifdef _WIN32 // WINDOWS OS
         DWORD   tv =   timeout_ms; // in windows this value is stored in DWORD and should be in ms
@@ -455,11 +1034,27 @@ namespace ipsockets {
       if (res == SOCKET_ERROR) return log_and_return ('-', "setsockopt", _get_err(), "set SO_RCVTIMEO");
       else                            log_and_return ('-', "setsockopt", no_error,   "set SO_RCVTIMEO");
 
+      // segmentation offload: default segment size for send_gso() and coalescing of received datagrams
+      res = _apply_offload (offload, udp_offload_t ());
+      if (res != no_error) {
+        close ();
+        return res;
+      }
+
+      // tuning options: buffer sizes must be known before the handshake, everything else is simply set early
+      res = _apply_options (options);
+      if (res != no_error) {
+        close ();
+        return res;
+      }
+
       sockaddr_in_t addr = address2sockaddr (address);
       res = (socket_type == socket_type_e::server) ? ::bind (sock, (sockaddr*)&addr, sizeof (sockaddr_in_t)) : _connect  (addr, connect_timeout_ms);
       int err = _get_err ();
 
-      address_local  = (socket_type == socket_type_e::server) ? address     : _getsockname ();
+      // query the real local address once (kernel-chosen port for clients and for servers bound to port 0),
+      // send/recv calls rely on it instead of asking the kernel on every call
+      address_local  = (socket_type == socket_type_e::server && res == SOCKET_ERROR) ? address : _getsockname ();
       address_remote = (socket_type == socket_type_e::server) ? address_t{} : address;
 
       if (res == SOCKET_ERROR) {
@@ -473,6 +1068,81 @@ namespace ipsockets {
 
     }
 
+    ///	@brief Opens a UDP socket with segmentation offload enabled.
+    ///	@param address            - The address to bind to (for server) or connect to (for client).
+    ///	@param offload_           - Offload settings (UDP_SEGMENT size and/or UDP_GRO), stored in the offload member.
+    ///	@param timeout_ms         - Receive timeout in milliseconds (SO_RCVTIMEO). Default: 1000.
+    ///	@param connect_timeout_ms - Connect timeout in milliseconds (for TCP client sockets only; UDP connect is instant). Default: 5000.
+    ///	@return Same error codes as open() without offload.
+    ///	@details On platforms without UDP_SEGMENT/UDP_GRO the settings are only remembered
+    ///	  and send_gso()/sendto_gso()/recvfrom_gro() work in software fallback mode.
+    int open (const address_t& address, const udp_offload_t& offload_, uint32_t timeout_ms = 1000, uint32_t connect_timeout_ms = 5000) {
+      if (state != state_e::opened)
+        offload = offload_;
+      return open (address, timeout_ms, connect_timeout_ms);
+    }
+
+    ///	@brief Opens a socket with tuning options (TCP_NODELAY, buffer sizes, keepalive, ...).
+    ///	@param address            - The address to bind to (for server) or connect to (for client).
+    ///	@param options_           - Options to set before bind/connect, stored in the options member.
+    ///	@param timeout_ms         - Receive timeout in milliseconds (SO_RCVTIMEO). Default: 1000.
+    ///	@param connect_timeout_ms - Connect timeout in milliseconds (for TCP client sockets only; UDP connect is instant). Default: 5000.
+    ///	@return Same error codes as open() without options, error_not_allowed if an option is rejected by the OS
+    ///	  or not supported by the platform (the socket is closed again).
+    int open (const address_t& address, const socket_options_t& options_, uint32_t timeout_ms = 1000, uint32_t connect_timeout_ms = 5000) {
+      if (state != state_e::opened)
+        options = options_;
+      return open (address, timeout_ms, connect_timeout_ms);
+    }
+
+    ///	@brief Changes tuning options of an opened socket, e.g. TCP_CORK around a burst of writes.
+    ///	@param opts - Options to set; fields left at their defaults are not touched.
+    ///	@return Error code:
+    ///	  - no_error on success, the set fields are merged into the options member
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if setsockopt fails or an option is not supported by the platform
+    ///	@note Buffer sizes set after connect do not change the negotiated TCP window scale.
+    int set_options (const socket_options_t& opts) {
+      if (state != state_e::opened) return log_and_return ('-', "set_options", error_closed_or_not_open);
+      int res = _apply_options (opts);
+      if (res != no_error) return res;
+      if (opts.no_delay        >= 0) options.no_delay        = opts.no_delay;
+      if (opts.cork            >= 0) options.cork            = opts.cork;
+      if (opts.quick_ack       >= 0) options.quick_ack       = opts.quick_ack;
+      if (opts.keepalive       >= 0) options.keepalive       = opts.keepalive;
+      if (opts.send_buffer     != 0) options.send_buffer     = opts.send_buffer;
+      if (opts.recv_buffer     != 0) options.recv_buffer     = opts.recv_buffer;
+      if (opts.keep_idle_s     != 0) options.keep_idle_s     = opts.keep_idle_s;
+      if (opts.keep_interval_s != 0) options.keep_interval_s = opts.keep_interval_s;
+      if (opts.keep_count      != 0) options.keep_count      = opts.keep_count;
+      if (opts.user_timeout_ms != 0) options.user_timeout_ms = opts.user_timeout_ms;
+      if (opts.notsent_lowat   != 0) options.notsent_lowat   = opts.notsent_lowat;
+      if (opts.busy_poll_us    != 0) options.busy_poll_us    = opts.busy_poll_us;
+      return no_error;
+    }
+
+    ///	@brief Changes segmentation offload settings of an opened UDP socket (UDP_SEGMENT and UDP_GRO).
+    ///	@param offload_ - New settings; gso_size = 0 clears the default segment size, gro = false stops coalescing.
+    ///	@return Error code:
+    ///	  - no_error on success, the settings are stored in the offload member
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on a TCP socket or setsockopt fails (the offload member keeps what was applied)
+    ///	@details Writing the offload member of an opened socket does not reach the kernel, use this instead.
+    ///	  On platforms without UDP_SEGMENT/UDP_GRO the settings are only remembered.
+    int set_offload (const udp_offload_t& offload_) {
+      if (state    != state_e::opened) return log_and_return ('-', "set_offload", error_closed_or_not_open);
+      if (protocol != IPPROTO_UDP)     return log_and_return ('-', "set_offload", error_not_allowed);
+      udp_offload_t applied = offload;
+      applied.gso_size      = offload_.gso_size;
+      int res = _apply_offload (applied, offload);
+      if (res != no_error) return res;
+      offload.gso_size = applied.gso_size;
+      res = _apply_offload (offload_, offload);
+      if (res != no_error) return res;
+      offload = offload_;
+      return no_error;
+    }
+
     ///	@brief Closes the socket if it has an allocated OS descriptor (state is prepared or opened).
     ///	@return always no_error.
     ///	@details Resets socket state to created and invalidates the socket descriptor.
@@ -481,14 +1151,62 @@ namespace ipsockets {
     ///	  Automatically called by destructor.
     int close () {
       if (state != state_e::created) {
-        state = state_e::created;
-        closesocket (sock);
+        state       = state_e::created;
+        nonblocking = false;
+        if (sock != INVALID_SOCKET) // descriptor of an accepted socket may be already closed by its server
+          closesocket (sock);
         sock = INVALID_SOCKET;
         return log_and_return ('-', "close", no_error);
       }
       return no_error;
     }
 
+    ///	@brief Switches an opened socket between blocking (default) and non-blocking mode.
+    ///	@param enable - true for non-blocking mode, false to return to blocking mode. Default: true.
+    ///	@return Error code:
+    ///	  - no_error on success
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_other if the OS call failed
+    ///	@details In non-blocking mode recv/send calls (and accept()) return error_would_block immediately when there
+    ///	  is no data (or no space, or no pending connection) instead of waiting for SO_RCVTIMEO and returning error_timeout.
+    ///	  Wait for readiness with wait_readable()/wait_writable(), poll_sockets() or reactor_t. Mode is reset by close().
+    int set_nonblocking (bool enable = true) {
+
+      if (state != state_e::opened) return log_and_return ('-', "set_nonblocking", error_closed_or_not_open);
+
+      #ifdef _WIN32 // WINDOWS OS
+        unsigned long nb  = (enable) ? 1 : 0;
+        int           res = ioctlsocket (sock, FIONBIO, &nb);
+      #else         // LINUX OS
+        int flags = fcntl (sock, F_GETFL, 0);
+        int res   = (flags == -1) ? -1 : fcntl (sock, F_SETFL, (enable) ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+      #endif
+
+      if (res == SOCKET_ERROR) return log_and_return ('-', "set_nonblocking", _get_err ());
+
+      nonblocking = enable;
+      return log_and_return ('-', "set_nonblocking", no_error, (enable) ? "enabled" : "disabled");
+    }
+
+    ///	@brief Waits until the socket can be read without blocking: a datagram/data is queued, a connection is pending
+    ///	  (listening TCP socket), the peer closed the connection or an error is pending.
+    ///	@param timeout_ms - Maximum wait time in milliseconds, 0 = just check, -1 = wait forever.
+    ///	@return Error code:
+    ///	  - no_error if the socket is ready (the next call reports the data, the close or the error)
+    ///	  - error_timeout if the socket did not become ready in time
+    ///	  - error_closed_or_not_open if socket not opened (or closed from another thread while waiting)
+    ///	  - error_other if the OS call failed
+    int wait_readable (int timeout_ms) {
+      return _wait ("wait_readable", POLLIN, timeout_ms);
+    }
+
+    ///	@brief Waits until the socket can be written without blocking (space in the send buffer, or a pending error).
+    ///	@param timeout_ms - Maximum wait time in milliseconds, 0 = just check, -1 = wait forever.
+    ///	@return Same error codes as wait_readable().
+    int wait_writable (int timeout_ms) {
+      return _wait ("wait_writable", POLLOUT, timeout_ms);
+    }
+
     ///	@brief Receives data on a connected client socket.
     ///	@param[out] buf     - Buffer to store received data.
     ///	@param      buf_len - Maximum number of bytes to receive.
@@ -496,20 +1214,19 @@ namespace ipsockets {
     ///	  - error_closed_or_not_open if socket not opened
     ///	  - error_not_allowed if called on server socket
     ///	  - error_timeout on receive timeout
+    ///	  - error_would_block if the socket is non-blocking and no datagram is queued
     ///	  - error_tcp_closed if connection closed by peer
     ///	  - error_other for other errors
     ///	@pre Socket must be opened in client mode and connected to a remote peer.
-    ///	@note Updates address_local and address_remote member variables.
+    ///	@note address_local and address_remote are fixed by open(), no extra syscalls are made per call.
     int recv (char* buf, int buf_len) {
 
       if (state       != state_e::opened)  return log_and_return ('<', "recv", error_closed_or_not_open);
       if (socket_type == socket_type_e::server) return log_and_return ('<', "recv", error_not_allowed);
       if (type        == SOCK_RAW)         return log_and_return ('<', "recv", error_not_allowed, "use recvfrom() for raw sockets");
 
-      int res        = ::recv (sock, buf, buf_len, 0);
-      int err        = _get_err ();
-      address_remote = _getpeername();
-      address_local  = _getsockname();
+      int res = ::recv (sock, buf, buf_len, 0);
+      int err = _get_err ();
 
       if (res == SOCKET_ERROR) return log_and_return ('<', "recv", err);
       else                     return log_and_return ('<', "recv", no_error, "received", res);
@@ -522,10 +1239,11 @@ namespace ipsockets {
     ///	@return Number of bytes received on success, or error code:
     ///	  - error_closed_or_not_open if socket not opened
     ///	  - error_timeout on receive timeout
+    ///	  - error_would_block if the socket is non-blocking and no datagram is queued
     ///	  - error_unreachable if destination unreachable
     ///	  - error_other for other errors
     ///	@details Can be used on both server and client sockets.
-    ///	  Updates address_local and address_remote member variables.
+    ///	  Updates address_remote member variable (address_local is fixed by open()).
     ///	@warning For raw sockets: buffer will contain IP header + UDP header + payload (not just payload).
     ///	  On Linux, kernel filters by protocol (IPPROTO_UDP). On Windows, raw socket receives ALL IP packets
     ///	  on the bound interface - caller must filter by protocol/port manually.
@@ -538,13 +1256,90 @@ namespace ipsockets {
       int           res       = ::recvfrom (sock, buf, buf_len, 0, (sockaddr*)&addr_from, &addr_len);
       int           err       = _get_err ();
       address_remote          = sockaddr2address (addr_from);
-      address_local           = _getsockname ();
       address_from            = address_remote;
 
       if (res == SOCKET_ERROR) return log_and_return ('<', "recvfrom", err);
       else                     return log_and_return ('<', "recvfrom", no_error, "received", res);
     }
 
+    ///	@brief Receives several datagrams in one call and captures the sender address of each one.
+    ///	@param[in,out] msgs  - Array of datagram descriptors; buf/buf_len are read, len/address are filled.
+    ///	@param         count - Number of descriptors in msgs (at most batch_max are used per call).
+    ///	@return Number of datagrams received (>= 1) on success, or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on a TCP socket, or count <= 0
+    ///	  - error_timeout on receive timeout (no datagram arrived at all)
+    ///	  - error_would_block if the socket is non-blocking and no datagram is queued
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details Waits (up to SO_RCVTIMEO) only for the first datagram, then takes whatever is already queued.
+    ///	  On Linux uses a single recvmmsg(MSG_WAITFORONE) syscall, on other platforms falls back to a recvfrom() loop.
+    ///	  Updates address_remote with the sender of the last datagram; address_local is not re-queried.
+    int recv_batch (recv_msg_t* msgs, int count) {
+
+      if (state    != state_e::opened) return log_and_return ('<', "recv_batch", error_closed_or_not_open);
+      if (protocol != IPPROTO_UDP)     return log_and_return ('<', "recv_batch", error_not_allowed);
+      if (count    <= 0)               return log_and_return ('<', "recv_batch", error_not_allowed);
+      if (count > batch_max)        count = batch_max;
+
+      int res   = 0;
+      int err   = no_error;
+      int total = 0;
+
+      #ifdef IP_SOCKETS_HAS_MMSG // LINUX OS
+        mmsghdr       hdrs [batch_max];
+        iovec         iovs [batch_max];
+        sockaddr_in_t addrs[batch_max];
+        memset (hdrs, 0, sizeof (mmsghdr) * count);
+        for (int i = 0; i < count; i++) {
+          iovs[i].iov_base            = msgs[i].buf;
+          iovs[i].iov_len             = (size_t)msgs[i].buf_len;
+          hdrs[i].msg_hdr.msg_name    = &addrs[i];
+          hdrs[i].msg_hdr.msg_namelen = sizeof (sockaddr_in_t);
+          hdrs[i].msg_hdr.msg_iov     = &iovs[i];
+          hdrs[i].msg_hdr.msg_iovlen  = 1;
+        }
+        res = ::recvmmsg (sock, hdrs, (unsigned int)count, MSG_WAITFORONE, nullptr);
+        err = _get_err ();
+        for (int i = 0; i < res; i++) {
+          msgs[i].len     = (int)hdrs[i].msg_len;
+          msgs[i].address = sockaddr2address (addrs[i]);
+          total          += msgs[i].len;
+        }
+      #else
+        for (; res < count; res++) {
+          int flags = 0;
+          if (res > 0) { // after the first datagram take only what is already queued
+            #ifdef _WIN32 // WINDOWS OS
+              WSAPOLLFD pfd;  pfd.fd = sock;  pfd.events = POLLRDNORM;
+              if (WSAPoll (&pfd, 1, 0) <= 0) break;
+            #else         // OTHER POSIX OS
+              flags = MSG_DONTWAIT;
+            #endif
+          }
+          socklen_t     addr_len  = sizeof (sockaddr_in_t);
+          sockaddr_in_t addr_from = {};
+          int           len       = ::recvfrom (sock, msgs[res].buf, msgs[res].buf_len, flags, (sockaddr*)&addr_from, &addr_len);
+          if (len == SOCKET_ERROR) {
+            if (res == 0) {
+              err = _get_err ();
+              res = SOCKET_ERROR;
+            }
+            break;
+          }
+          msgs[res].len     = len;
+          msgs[res].address = sockaddr2address (addr_from);
+          total            += len;
+        }
+      #endif
+
+      if (res == SOCKET_ERROR) return log_and_return ('<', "recv_batch", err);
+
+      address_remote = msgs[res - 1].address;
+      log_and_return ('<', "recv_batch", no_error, "received", total);
+      return res;
+    }
+
     ///	@brief Sends data on a connected client socket.
     ///	@param buf     - Buffer containing data to send.
     ///	@param buf_len - Number of bytes to send.
@@ -552,20 +1347,19 @@ namespace ipsockets {
     ///	@return Number of bytes sent on success, or error code:
     ///	  - error_closed_or_not_open if socket not opened
     ///	  - error_not_allowed if called on server socket
+    ///	  - error_would_block if the socket is non-blocking and the send buffer is full
     ///	  - error_unreachable if destination unreachable
     ///	  - error_other for other errors
     ///	@pre Socket must be opened in client mode and connected to a remote peer.
-    ///	@note Updates address_local and address_remote member variables.
+    ///	@note address_local and address_remote are fixed by open(), no extra syscalls are made per call.
     int send (const char* buf, int buf_len, int flags = 0) {
 
       if (state       != state_e::opened)  return log_and_return ('>', "send", error_closed_or_not_open);
       if (socket_type == socket_type_e::server) return log_and_return ('>', "send", error_not_allowed);
       if (type        == SOCK_RAW)         return log_and_return ('>', "send", error_not_allowed, "use sendto() for raw sockets");
 
-      int res        = ::send (sock, buf, buf_len, flags);
-      int err        = _get_err ();
-      address_local  = _getsockname ();
-      address_remote = _getpeername ();
+      int res = ::send (sock, buf, buf_len, flags);
+      int err = _get_err ();
 
       if (res == SOCKET_ERROR) return log_and_return ('>', "send", err);
       else                     return log_and_return ('>', "send", no_error, "sended", res);
@@ -578,11 +1372,12 @@ namespace ipsockets {
     ///	@return Number of bytes sent on success, or error code:
     ///	  - error_closed_or_not_open if socket not opened
     ///	  - error_invalid_address if destination address is invalid
+    ///	  - error_would_block if the socket is non-blocking and the send buffer is full
     ///	  - error_unreachable if destination unreachable
     ///	  - error_other for other errors
     ///	@details Can be used on both server and client sockets.
     ///	For raw sockets, extracts source address from IP header.
-    ///	Updates address_local and address_remote member variables.
+    ///	Updates address_remote member variable (and address_local for raw sockets).
     int sendto (const char* buf, int data_len, address_t& address_to) {
 
       if (state != state_e::opened) return log_and_return ('>', "sendto", error_closed_or_not_open);
@@ -595,14 +1390,232 @@ namespace ipsockets {
         const uint16_t* src_port_be = (const uint16_t*)(buf + 20);
         address_local               = addr4_t (*ip4_ptr, orders::ntohT<uint16_t> (*src_port_be));
       }
-      else
-        address_local       = _getsockname ();
       address_remote        = address_to;
 
       if (res == SOCKET_ERROR) return log_and_return ('>', "sendto", err);
       else                     return log_and_return ('>', "sendto", no_error, "sended", res);
     }
 
+    ///	@brief Sends a large buffer on a connected client socket as a train of segment_size datagrams.
+    ///	@param buf          - Buffer containing data to send.
+    ///	@param buf_len      - Number of bytes to send (on Linux at most 64 segments and 65507 bytes per call).
+    ///	@param segment_size - Payload size of each datagram, 0 to use offload.gso_size (open() or set_offload()). Default: 0.
+    ///	@return Number of bytes sent on success, or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on server, raw or TCP socket, or segment size is not set
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details On Linux it is a single sendmsg() with UDP_SEGMENT, the receiver gets separate datagrams.
+    ///	  On other platforms the buffer is split and sent with one send() per segment.
+    int send_gso (const char* buf, int buf_len, uint16_t segment_size = 0) {
+
+      if (state       != state_e::opened)       return log_and_return ('>', "send_gso", error_closed_or_not_open);
+      if (protocol    != IPPROTO_UDP)           return log_and_return ('>', "send_gso", error_not_allowed);
+      if (socket_type == socket_type_e::server) return log_and_return ('>', "send_gso", error_not_allowed);
+      if (type        == SOCK_RAW)              return log_and_return ('>', "send_gso", error_not_allowed);
+
+      return _send_gso (buf, buf_len, nullptr, segment_size, "send_gso");
+    }
+
+    ///	@brief Sends a large buffer to a specified destination as a train of segment_size datagrams.
+    ///	@param buf          - Buffer containing data to send.
+    ///	@param data_len     - Number of bytes to send (on Linux at most 64 segments and 65507 bytes per call).
+    ///	@param address_to   - Destination address.
+    ///	@param segment_size - Payload size of each datagram, 0 to use offload.gso_size (open() or set_offload()). Default: 0.
+    ///	@return Number of bytes sent on success, or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on raw or TCP socket, or segment size is not set
+    ///	  - error_invalid_address if destination address is invalid
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details Can be used on both server and client sockets. Updates address_remote member variable.
+    int sendto_gso (const char* buf, int data_len, const address_t& address_to, uint16_t segment_size = 0) {
+
+      if (state    != state_e::opened) return log_and_return ('>', "sendto_gso", error_closed_or_not_open);
+      if (protocol != IPPROTO_UDP)     return log_and_return ('>', "sendto_gso", error_not_allowed);
+      if (type     == SOCK_RAW)        return log_and_return ('>', "sendto_gso", error_not_allowed);
+
+      sockaddr_in_t addr_to = address2sockaddr (address_to);
+      address_remote        = address_to;
+      return _send_gso (buf, data_len, &addr_to, segment_size, "sendto_gso");
+    }
+
+    ///	@brief Receives a buffer of coalesced datagrams (UDP_GRO) and reports the size of each segment.
+    ///	@param[out] buf          - Buffer to store received data (use 65535 bytes to fit any coalesced train).
+    ///	@param      buf_len      - Maximum number of bytes to receive.
+    ///	@param[out] address_from - Filled with the sender's address.
+    ///	@param[out] segment_size - Size of each datagram in buf (the last one may be shorter).
+    ///	  Equals the return value when a single datagram was received.
+    ///	@return Number of bytes received on success, or the same error codes as recvfrom(),
+    ///	  and error_not_allowed if called on a TCP socket.
+    ///	@details Datagrams are coalesced only when the socket was opened with udp_offload_t::gro = true on Linux.
+    ///	  Otherwise (and on other platforms) behaves exactly like recvfrom().
+    int recvfrom_gro (char* buf, int buf_len, address_t& address_from, int& segment_size) {
+
+      if (state    != state_e::opened) return log_and_return ('<', "recvfrom_gro", error_closed_or_not_open);
+      if (protocol != IPPROTO_UDP)     return log_and_return ('<', "recvfrom_gro", error_not_allowed);
+
+      sockaddr_in_t addr_from = {};
+      int           res       = 0;
+      segment_size            = 0;
+
+      #ifdef IP_SOCKETS_HAS_UDP_OFFLOAD // LINUX OS
+        union {
+          char    buf[CMSG_SPACE (sizeof (int))];
+          cmsghdr align;
+        } control;
+        iovec  iov = { buf, (size_t)buf_len };
+        msghdr msg = {};
+        msg.msg_name       = &addr_from;
+        msg.msg_namelen    = sizeof (sockaddr_in_t);
+        msg.msg_iov        = &iov;
+        msg.msg_iovlen     = 1;
+        msg.msg_control    = control.buf;
+        msg.msg_controllen = sizeof (control.buf);
+        res = (int)::recvmsg (sock, &msg, 0);
+        for (cmsghdr* cm = CMSG_FIRSTHDR (&msg); res != SOCKET_ERROR && cm != nullptr; cm = CMSG_NXTHDR (&msg, cm))
+          if (cm->cmsg_level == SOL_UDP && cm->cmsg_type == UDP_GRO)
+            memcpy (&segment_size, CMSG_DATA (cm), sizeof (int));
+      #else
+        socklen_t addr_len = sizeof (sockaddr_in_t);
+        res = ::recvfrom (sock, buf, buf_len, 0, (sockaddr*)&addr_from, &addr_len);
+      #endif
+      int err        = _get_err ();
+      address_remote = sockaddr2address (addr_from);
+      address_from   = address_remote;
+
+      if (res == SOCKET_ERROR) return log_and_return ('<', "recvfrom_gro", err);
+      if (segment_size == 0 || segment_size > res)
+        segment_size = res;
+      return log_and_return ('<', "recvfrom_gro", no_error, "received", res);
+    }
+
+    ///	@brief Sends several datagrams on a connected client socket in one call.
+    ///	@param msgs  - Array of datagram descriptors (address field is ignored).
+    ///	@param count - Number of descriptors in msgs (at most batch_max are sent per call).
+    ///	@return Number of datagrams accepted by the kernel (>= 1), or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on server, raw or TCP socket, or count <= 0
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details If fewer than count datagrams were accepted, the caller resumes from msgs + result.
+    ///	  On Linux uses a single sendmmsg() syscall, on other platforms falls back to a send() loop.
+    int send_batch (const send_msg_t* msgs, int count) {
+
+      if (state       != state_e::opened)       return log_and_return ('>', "send_batch", error_closed_or_not_open);
+      if (protocol    != IPPROTO_UDP)           return log_and_return ('>', "send_batch", error_not_allowed);
+      if (socket_type == socket_type_e::server) return log_and_return ('>', "send_batch", error_not_allowed);
+      if (type        == SOCK_RAW)              return log_and_return ('>', "send_batch", error_not_allowed, "use sendto_batch() for raw sockets");
+
+      return _send_batch (msgs, count, false, "send_batch");
+    }
+
+    ///	@brief Sends several datagrams, each one to its own destination address, in one call.
+    ///	@param msgs  - Array of datagram descriptors with destination addresses.
+    ///	@param count - Number of descriptors in msgs (at most batch_max are sent per call).
+    ///	@return Number of datagrams accepted by the kernel (>= 1), or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on a TCP socket, or count <= 0
+    ///	  - error_invalid_address if a destination address is invalid
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details If fewer than count datagrams were accepted, the caller resumes from msgs + result.
+    ///	  Consecutive datagrams to the same destination share one converted sockaddr.
+    ///	  On Linux uses a single sendmmsg() syscall, on other platforms falls back to a sendto() loop.
+    ///	  Updates address_remote with the destination of the last accepted datagram.
+    int sendto_batch (const send_msg_t* msgs, int count) {
+
+      if (state    != state_e::opened) return log_and_return ('>', "sendto_batch", error_closed_or_not_open);
+      if (protocol != IPPROTO_UDP)     return log_and_return ('>', "sendto_batch", error_not_allowed);
+
+      return _send_batch (msgs, count, true, "sendto_batch");
+    }
+
+    ///	@brief Sends several buffers as one piece of data (one datagram for UDP) on a connected client socket, without joining them first.
+    ///	@param vecs  - Array of buffers, sent in order.
+    ///	@param count - Number of buffers in vecs (at most iov_max are sent per call).
+    ///	@return Number of bytes sent on success, or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on server or raw socket, or count <= 0
+    ///	  - error_would_block if the socket is non-blocking and the send buffer is full
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details One sendmsg() (WSASend() on Windows) instead of a memcpy into one buffer or a send() per buffer;
+    ///	  a header and a body sent this way leave in the same TCP segment. A non-blocking TCP socket may take
+    ///	  only a part of the data, the caller resumes from the returned byte count.
+    int sendv (const io_vec_t* vecs, int count) {
+
+      if (state       != state_e::opened)       return log_and_return ('>', "sendv", error_closed_or_not_open);
+      if (socket_type == socket_type_e::server) return log_and_return ('>', "sendv", error_not_allowed);
+      if (type        == SOCK_RAW)              return log_and_return ('>', "sendv", error_not_allowed, "use sendto() for raw sockets");
+      if (count <= 0)                           return log_and_return ('>', "sendv", error_not_allowed);
+
+      return _sendv (vecs, count, nullptr, "sendv");
+    }
+
+    ///	@brief Sends several buffers as one datagram to a specified destination address.
+    ///	@param vecs       - Array of buffers, sent in order.
+    ///	@param count      - Number of buffers in vecs (at most iov_max are sent per call).
+    ///	@param address_to - Destination address.
+    ///	@return Number of bytes sent on success, or error code:
+    ///	  - error_closed_or_not_open if socket not opened
+    ///	  - error_not_allowed if called on raw socket, or count <= 0
+    ///	  - error_invalid_address if destination address is invalid
+    ///	  - error_would_block if the socket is non-blocking and the send buffer is full
+    ///	  - error_unreachable if destination unreachable
+    ///	  - error_other for other errors
+    ///	@details Can be used on both server and client sockets. Updates address_remote member variable.
+    int sendtov (const io_vec_t* vecs, int count, const address_t& address_to) {
+
+      if (state != state_e::opened) return log_and_return ('>', "sendtov", error_closed_or_not_open);
+      if (type  == SOCK_RAW)        return log_and_return ('>', "sendtov", error_not_allowed, "use sendto() for raw sockets");
+      if (count <= 0)               return log_and_return ('>', "sendtov", error_not_allowed);
+
+      sockaddr_in_t addr_to = address2sockaddr (address_to);
+      address_remote        = address_to;
+      return _sendv (vecs, count, &addr_to, "sendtov");
+    }
+
+    ///	@brief Receives data on a connected client socket, filling several buffers in order (scatter read).
+    ///	@param vecs  - Array of buffers to receive into.
+    ///	@param count - Number of buffers in vecs (at most iov_max are used per call).
+    ///	@return Number of bytes received on success, or the same error codes as recv().
+    ///	@details E.g. a fixed-size header lands in its own struct and the payload in a separate buffer.
+    ///	  One recvmsg() (WSARecv() on Windows) syscall.
+    int recvv (const io_vec_t* vecs, int count) {
+
+      if (state       != state_e::opened)       return log_and_return ('<', "recvv", error_closed_or_not_open);
+      if (socket_type == socket_type_e::server) return log_and_return ('<', "recvv", error_not_allowed);
+      if (type        == SOCK_RAW)              return log_and_return ('<', "recvv", error_not_allowed, "use recvfrom() for raw sockets");
+      if (count <= 0)                           return log_and_return ('<', "recvv", error_not_allowed);
+      if (count > iov_max)                      count = iov_max;
+
+      #ifdef _WIN32 // WINDOWS OS
+        WSABUF bufs[iov_max];
+        for (int i = 0; i < count; i++) {
+          bufs[i].buf = vecs[i].buf;
+          bufs[i].len = (ULONG)vecs[i].len;
+        }
+        DWORD received = 0;
+        DWORD flags    = 0;
+        int   res      = (WSARecv (sock, bufs, (DWORD)count, &received, &flags, nullptr, nullptr) == SOCKET_ERROR) ? SOCKET_ERROR : (int)received;
+      #else         // LINUX OS
+        iovec iovs[iov_max];
+        for (int i = 0; i < count; i++) {
+          iovs[i].iov_base = vecs[i].buf;
+          iovs[i].iov_len  = (size_t)vecs[i].len;
+        }
+        msghdr msg = {};
+        msg.msg_iov    = iovs;
+        msg.msg_iovlen = (size_t)count;
+        int res = (int)::recvmsg (sock, &msg, 0);
+      #endif
+      int err = _get_err ();
+
+      if (res == SOCKET_ERROR) return log_and_return ('<', "recvv", err);
+      else                     return log_and_return ('<', "recvv", no_error, "received", res);
+    }
+
 
   protected:
 
@@ -610,132 +1623,92 @@ namespace ipsockets {
     int log_and_return (const char dir, const char* func, int err = no_error, const char* mes = 0, int bytes = -1) {
 
       // convert to our error code
-      int cerr;
-    
-      switch (err) {
-        #ifdef _WIN32 // WINDOWS OS
-        case WSAETIMEDOUT:     cerr = error_timeout;         break; // windows error code for timeout in recv when SO_RCVTIMEO != 0
-        case WSAEADDRNOTAVAIL: cerr = error_invalid_address; break; // error when remote address is invalid
-        case WSAECONNREFUSED:
-        case WSAECONNRESET:    cerr = error_unreachable;     break; 
-        case WSAECONNABORTED:  cerr = error_tcp_closed;      break; 
-        #else         // LINUX OS
-        case EWOULDBLOCK:      cerr = error_timeout;         break; // linux error code for timeout in recv when SO_RCVTIMEO != 0
-        case EADDRNOTAVAIL:    cerr = error_invalid_address; break; // error when remote address is invalid
-        case ECONNREFUSED:     cerr = error_unreachable;     break; 
-        case EBADF:            cerr = error_closed_or_not_open;        break; // linux Bad file descriptor
-        #endif
-        default:
-          if (err > 0) cerr = error_other;
-          else         cerr = err; // if we don't understand type of error and it's error from OS (err<0) we just return error from OS
-      }
+      int cerr = error_from_os (err);
+
+      // linux reports an expired SO_RCVTIMEO and "nothing to do yet" on a non-blocking socket with the same EWOULDBLOCK
+      if (cerr == error_timeout && err > 0 && nonblocking)
+        cerr = error_would_block;
 
       // if error is timeout or graceful tcp close, it's not a real error, don't show anything
-      // error_timeout    — expected when SO_RCVTIMEO fires, caller should retry or check conditions
-      // error_tcp_closed — expected when remote peer closes connection gracefully (recv returns 0)
-      if (cerr == error_timeout || cerr == error_tcp_closed)
+      // error_timeout     — expected when SO_RCVTIMEO fires, caller should retry or check conditions
+      // error_would_block — expected on a non-blocking socket, caller waits for readiness and retries
+      // error_tcp_closed  — expected when remote peer closes connection gracefully (recv returns 0)
+      if (cerr == error_timeout || cerr == error_would_block || cerr == error_tcp_closed)
         return cerr;
 
-      // show message if
-      // log_level == debug OR
-      // log_level == info AND (function in [open, close, accept] OR error exists) OR
-      // log_level == error and error exists
-      if (    log_level == log_e::debug
-          || (log_level == log_e::info  && (!strcmp (func, "open") || !strcmp (func, "close") || !strcmp (func, "accept") || cerr != no_error))
-          || (log_level == log_e::error && cerr != no_error)) {
-
-        // get error description text
-        #ifdef _WIN32 // WINDOWS OS
-          const char* sysmesl = "";
-          LPTSTR sysmes       = NULL;
-          DWORD  dwLanguageId = 0x0409; // us-en    for russian leave 0x0000;
-          DWORD  dwFlags      = FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM | FORMAT_MESSAGE_IGNORE_INSERTS;
-          FormatMessageA (dwFlags, NULL, err, dwLanguageId, (LPSTR)&sysmes, 0, NULL);
-        #else         // LINUX OS
-          const char* sysmesl = "\n";
-          const char* sysmes = strerror (errno);
-        #endif
-
-        const char* ctext;
-        switch (cerr) {
-          case no_error:              ctext = "success";                            break;              
-          case error_tcp_closed:      ctext = "error, socket closed by other side"; break;
-          case error_already_opened:  ctext = "error, socket already opened";       break;
-          case error_open_failed:     ctext = "error, failed to open socket";       break;
-          case error_closed_or_not_open:        ctext = "error, use closed socket";           break;
-          case error_timeout:         ctext = "receive timeout";                    break;
-          case error_unreachable:     ctext = "unreachable error";                  break;
-          case error_not_allowed:     ctext = "error, not allowed on this mode";    break;
-          case error_invalid_address: ctext = "error address";                      break;
-          default:                    ctext = "error";                              break;
-        }
-      
-        std::stringstream result;
-      
-        result << tname << ": ";
-      
-        if (sock == INVALID_SOCKET) result << "[undefined]";
-        else                        result << '[' << std::hex << sock << std::dec << ']';
-      
-        result << '.' << func << "() ";
-      
-        //if (address_local.port != 0 || address_remote.port != 0) {
-          std::string local  = (address_local.port  != 0) ? address_local.to_str ()  : "undefined";
-          std::string remote = (address_remote.port != 0) ? address_remote.to_str () : "undefined";
-          if      (dir == '>') result << "[" << local << " -> " << remote << "] ";
-          else if (dir == '<') result << "[" << local << " <- " << remote << "] ";
-          else                 result << "[" << local << " <> " << remote << "] ";
-        //}
-      
-        if (mes) result << mes << ' ';
-      
-        if      (bytes >= 0) result << bytes << " bytes\n";
-        else if (err > 0)    result << ctext << ", system answer: " << sysmes << sysmesl;
-        else                 result << ctext << std::endl;
-      
-        std::cout << result.str();
-      
-        #ifdef _WIN32 // WINDOWS OS
-          LocalFree (sysmes);
-        #endif
-
-      }
+      if (_log_enabled (func, cerr))
+        _log (dir, func, err, cerr, mes, bytes);
 
       if (bytes >= 0) return bytes;
       else            return cerr;
+    }
 
-    // udp<ip4,server>: wsa initialisation error
-    // tname + ": [sock]." + func + "() [" + addr_src + " -> " + addr_dst + "] " + cust_mes + [B bytes] + text(cerr) + [sys_answer(err)]/"\n"
-
-    // tname + ": [sock]." + func + "() [" + addr_src + " -> " + addr_dst + "] " + cust_mes + B bytes"\n"
-    // tname + ": [sock]." + func + "() [" + addr_src + " -> " + addr_dst + "] " + cust_mes + B bytes"\n"
-    // tname + ": [sock]." + func + "() [" + addr_src + " -> " + addr_dst + "] " + cust_mes + [B bytes] + text(cerr) + [sys_answer(err)]/"\n"
-    // tname + ": [sock]." + func + "() [" + addr_src + " -> " + addr_dst + "] " + cust_mes + [B bytes] + text(cerr) + [sys_answer(err)]/"\n"
-    // udp<ip4,server>: [0x0002].open() [192.168.1.1:2000 -> "unspecified"] bind success
-    // udp<ip4,server>: [0x0002].open() [192.168.1.1:2000 -> "unspecified"] error, already opened
-    // udp<ip4,server>: [0x0002].open() [192.168.1.1:2000 -> "unspecified"] error, wsa initialisation error
-    // udp<ip4,server>: [0x0002].open() [192.168.1.1:2000 -> "unspecified"] socket error, system answer: bla bla bla
-    // udp<ip4,server>: [0x0002].open() [192.168.1.1:2000 -> "unspecified"] bind error, system answer: bla bla bla
-
-    // udp<ip4,client>: [0x0002].open() ["unspecified"    -> 192.168.1.1:2000] connect success
-    // udp<ip4,client>: [0x0002].open() [192.168.1.1:2000 -> "unspecified"   ] connect error, system answer: bla bla bla
+    /// @brief Decides whether a log_and_return() call produces a message.
+    /// @details Effective level is the stricter of log_level and compiled_log_level, so with
+    ///   IP_SOCKETS_CPP_LITE_LOG_LEVEL=3 (none) this is a compile-time false and _log() is dropped from the call site.
+    bool _log_enabled (const char* func, int cerr) const {
 
-    // udp<ip4,server>: [0x0002].recv() ["unspecified"    -> 192.168.1.1:2001] error, not allowed on server mode
-    // udp<ip4,server>: [0x0002].send() [192.168.1.1:2001 -> "unspecified"   ] error, not allowed on server mode
-    // udp<ip4,client>: [0x0002].recv() [192.168.1.1:2001 -> 192.168.1.1:2001] received 9 bytes
-    // udp<ip4,client>: [0x0002].recv() [192.168.1.1:2001 -> 192.168.1.1:2001] error, system answer: bla bla bla
-    // udp<ip4,client>: [0x0002].send() [192.168.1.1:2001 -> 192.168.1.1:2001] sended 7777 bytes
-    // udp<ip4,client>: [0x0002].send() [192.168.1.1:2001 -> 192.168.1.1:2001] error, system answer: bla bla bla
-    // udp<ip4,client>: [0x0002].send() [192.168.1.1:2001 -> 192.168.1.1:2001] unreachable error, system answer: bla bla bla
+      log_e level = log_level;
+      if (level < compiled_log_level)
+        level = compiled_log_level;
 
-    // udp<ip4,client>: [0x0002].recvfrom() [192.168.1.1:2001 -> 192.168.1.1:2000] received 9 bytes
-    // udp<ip4,client>: [0x0002].sendto()   [192.168.1.1:2000 -> 192.168.1.1:2001] sended 7777 bytes
-    // udp<ip4,client>: [0x0002].sendto()   [192.168.1.1:2000 -> 192.168.1.1:2001] error, system answer: bla bla bla
+      // show message if
+      // log_level == debug OR
+      // log_level == info AND (error exists OR function in [open, close, accept]) OR
+      // log_level == error and error exists
+      switch (level) {
+        case log_e::debug: return true;
+        case log_e::info:  return cerr != no_error || !strcmp (func, "open") || !strcmp (func, "close") || !strcmp (func, "accept");
+        case log_e::error: return cerr != no_error;
+        default:           return false;
+      }
+    }
 
+    /// @brief Passes one message to the log sink as a structured record, kept out of line so the hot path stays small.
+    IP_SOCKETS_COLD void _log (const char dir, const char* func, int err, int cerr, const char* mes, int bytes) {
+
+      log_record_t record;
+      strncpy (record.tname, tname.c_str (), sizeof (record.tname) - 1);
+      record.fd      = (sock == INVALID_SOCKET) ? -1 : (int64_t)sock;
+      record.func    = func;
+      record.dir     = dir;
+      record.ip_type = Ip_type;
+      record.local   = log_address (address_local);
+      record.remote  = log_address (address_remote);
+      record.bytes   = bytes;
+      record.err     = err;
+      record.cerr    = cerr;
+      record.mes     = mes;
+
+      get_log_sink ().write (record);
     }
 
   public:
 
+    /// @brief Converts an OS error code (errno / WSAGetLastError()) to error_e.
+    /// @param err - OS error code (> 0), or an error_e value (<= 0) which is returned unchanged.
+    /// @return error_e code; unrecognized OS errors become error_other.
+    static inline int error_from_os (int err) {
+      switch (err) {
+        #ifdef _WIN32 // WINDOWS OS
+        case WSAETIMEDOUT:     return error_timeout;            // windows error code for timeout in recv when SO_RCVTIMEO != 0
+        case WSAEADDRNOTAVAIL: return error_invalid_address;    // error when remote address is invalid
+        case WSAECONNREFUSED:
+        case WSAECONNRESET:    return error_unreachable;
+        case WSAECONNABORTED:  return error_tcp_closed;
+        case WSAEWOULDBLOCK:   return error_would_block;        // non-blocking socket has nothing to do yet
+        #else         // LINUX OS
+        case EWOULDBLOCK:      return error_timeout;            // linux error code for timeout in recv when SO_RCVTIMEO != 0
+        case EADDRNOTAVAIL:    return error_invalid_address;    // error when remote address is invalid
+        case ECONNREFUSED:     return error_unreachable;
+        case EBADF:            return error_closed_or_not_open; // linux Bad file descriptor
+        #endif
+        default:
+          if (err > 0) return error_other;
+          else         return err; // if we don't understand type of error and it's error from OS (err<0) we just return error from OS
+      }
+    }
+
     // static address conversion functions
 
     /// @brief Converts addr4_t (ip4 + port) to OS sockaddr_in structure for use with socket API calls.
@@ -831,16 +1804,25 @@ namespace ipsockets {
         freeaddrinfo(res);
       }
 
+      if (log_level < compiled_log_level)
+        log_level = compiled_log_level;
+
       if (log_level <= log_e::info || (log_level == log_e::error && (err != 0 || found == false))) {
 
-        std::stringstream log_message;
+        log_record_t record;
+        strncpy (record.tname, tname.c_str (), sizeof (record.tname) - 1);
+        record.fd      = log_record_t::fd_static;
+        record.func    = "resolve";
+        record.dir     = '>';
+        record.ip_type = Ip_type;
+        record.cerr    = (err != 0 || found == false) ? error_other : no_error;
 
-        log_message << tname << ": [static].resolve()   [undefined -> " << hostname << "] ";
-        if (err != 0)            log_message << "DNS resolution failed: " << gai_strerror(err) << std::endl;
-        else if (found == false) log_message << "DNS resolution succes, but address with " << (Ip_type == v4 ? "IPv4" : "IPv6") << " type not found in DNS answer" << std::endl;
-        else                     log_message << "DNS resolution success, resolved to '" << result.to_str() << "'" << std::endl;
+        record.text = "  [undefined -> " + hostname + "] ";
+        if (err != 0)            record.text += std::string ("DNS resolution failed: ") + gai_strerror (err);
+        else if (found == false) record.text += std::string ("DNS resolution succes, but address with ") + (Ip_type == v4 ? "IPv4" : "IPv6") + " type not found in DNS answer";
+        else                     record.text += "DNS resolution success, resolved to '" + result.to_str () + "'";
 
-        std::cout << log_message.str();
+        get_log_sink ().write (record);
 
       }
 
@@ -871,4 +1853,83 @@ namespace ipsockets {
     }
   };
 
+  // ============================================================
+  // poll_sockets — readiness of many sockets in one poll()/WSAPoll() call
+  // ============================================================
+
+  /// @brief Readiness flags of poll_sockets().
+  enum poll_e : uint32_t {
+    poll_read  = 1, ///< Data or a datagram to read, a pending connection (listening TCP socket), or peer close
+    poll_write = 2, ///< Space in the send buffer (or non-blocking connect completed)
+    poll_error = 4  ///< Error, hang-up or invalid descriptor (always reported, no need to ask for it)
+  };
+
+  namespace poll_detail {
+
+    #ifdef _WIN32 // WINDOWS OS
+      using pollfd_t = WSAPOLLFD;
+    #else         // LINUX OS
+      using pollfd_t = pollfd;
+    #endif
+
+    template <class Socket> inline Socket& target (Socket& socket) { return socket; }  ///< Array of socket objects
+    template <class Socket> inline Socket& target (Socket* socket) { return *socket; } ///< Array of socket pointers
+
+    /// @brief Per-thread descriptor array, reused between calls so polling thousands of sockets does not allocate.
+    inline std::vector<pollfd_t>& buffer () {
+      static thread_local std::vector<pollfd_t> fds;
+      return fds;
+    }
+
+  } // namespace poll_detail
+
+  /// @brief Waits until at least one of many sockets is ready, with a single poll()/WSAPoll() syscall.
+  /// @param      sockets    - Array of udp_socket_t/tcp_socket_t objects, or of pointers to them.
+  /// @param      count      - Number of sockets in the array.
+  /// @param      events     - poll_read and/or poll_write, asked for every socket.
+  /// @param[out] ready      - Array of count flag sets: combination of poll_e for a ready socket, 0 otherwise
+  ///   (sockets that are not opened are skipped and get 0).
+  /// @param      timeout_ms - Maximum wait time in milliseconds, 0 = just check, -1 = wait forever.
+  /// @return Number of ready sockets (0 on timeout or signal interruption), or error_other if the OS call failed.
+  /// @details Usually combined with set_nonblocking(true): read every ready socket until it returns error_would_block.
+  ///   For long-lived sets of sockets reactor_t (epoll on Linux) avoids passing the whole array on every call.
+  ///
+  /// @code
+  ///   std::vector<udp_socket_t<v4, socket_type_e::client>> peers = ...;
+  ///   std::vector<uint32_t> ready (peers.size ());
+  ///   int n = poll_sockets (peers.data (), peers.size (), poll_read, ready.data (), 1000);
+  ///   for (size_t i = 0; n > 0 && i < peers.size (); i++)
+  ///     if (ready[i] & poll_read) { ... peers[i].recv (buf, sizeof (buf)) ... }
+  /// @endcode
+  template <class Item>
+  inline int poll_sockets (Item* sockets, size_t count, uint32_t events, uint32_t* ready, int timeout_ms) {
+
+    std::vector<poll_detail::pollfd_t>& fds = poll_detail::buffer ();
+    fds.resize (count);
+
+    short poll_events = (short)(((events & poll_read) ? POLLIN : 0) | ((events & poll_write) ? POLLOUT : 0));
+    for (size_t i = 0; i < count; i++) {
+      auto& socket   = poll_detail::target (sockets[i]);
+      fds[i].fd      = (socket.state == state_e::opened) ? socket.sock : INVALID_SOCKET; // negative descriptors are ignored
+      fds[i].events  = poll_events;
+      fds[i].revents = 0;
+    }
+
+    #ifdef _WIN32 // WINDOWS OS
+      int n = (count > 0) ? WSAPoll (fds.data (), (ULONG)count, timeout_ms) : 0;
+      if (n == SOCKET_ERROR) return (WSAGetLastError () == WSAEINTR) ? 0 : error_other;
+    #else         // LINUX OS
+      int n = ::poll (fds.data (), (nfds_t)count, timeout_ms);
+      if (n == SOCKET_ERROR) return (errno == EINTR) ? 0 : error_other;
+    #endif
+
+    for (size_t i = 0; i < count; i++) {
+      short revents = fds[i].revents;
+      ready[i] = ((revents & (POLLIN | POLLHUP)) ? (uint32_t)poll_read  : 0u) |
+                 ((revents & POLLOUT)             ? (uint32_t)poll_write : 0u) |
+                 ((revents & (POLLERR | POLLHUP | POLLNVAL)) ? (uint32_t)poll_error : 0u);
+    }
+    return n;
+  }
+
 } // namespace ipsockets
@@ -0,0 +1,656 @@
+
+/*
+ * ip-sockets-cpp-lite — header-only C++ networking utilities
+ * https://github.com/biaks/ip-sockets-cpp-lite
+ *
+ * Copyright (c) 2021 Yan Kryukov ianiskr@gmail.com
+ * Licensed under the MIT License
+ */
+
+#pragma once
+
+#include "tcp_socket.h"
+
+// io_uring is Linux only; the engine talks to the kernel with raw syscalls, liburing is not required.
+// uapi headers of linux 6.0+ are needed at build time (multishot recv/accept, provided buffer rings),
+// on older headers or other platforms IP_SOCKETS_HAS_IO_URING is not defined and this header declares nothing.
+#if defined(__linux__) && defined(__has_include)
+  #if __has_include(<linux/io_uring.h>)
+    #include <linux/io_uring.h>
+    #if defined(IORING_RECV_MULTISHOT) && defined(IORING_ACCEPT_MULTISHOT)
+      #include <signal.h>      // Needed for _NSIG (size of sigmask passed to io_uring_enter)
+      #include <sys/mman.h>    // Needed for mmap() of the rings
+      #include <sys/syscall.h> // Needed for syscall numbers
+      #ifndef __NR_io_uring_setup
+        #define __NR_io_uring_setup    425 // same number on every architecture
+      #endif
+      #ifndef __NR_io_uring_enter
+        #define __NR_io_uring_enter    426
+      #endif
+      #ifndef __NR_io_uring_register
+        #define __NR_io_uring_register 427
+      #endif
+      #define IP_SOCKETS_HAS_IO_URING 1
+    #endif
+  #endif
+#endif
+
+#ifdef IP_SOCKETS_HAS_IO_URING
+
+namespace ipsockets {
+
+  // ============================================================
+  // uring_engine_t — submission-batched socket I/O over io_uring
+  // ============================================================
+
+  /// @brief Queues recv/send/accept/connect for many sockets and reaps their completions in batches.
+  /// @details Operations are only written to the submission ring; one io_uring_enter() syscall in submit()/reap()
+  ///   hands all of them to the kernel and collects whatever has completed. Each operation carries a user tag
+  ///   which is returned in its completion_t together with the result already converted to error_e.
+  ///
+  ///   Buffers, sockets and the engine itself must stay alive until the completion of the operation is reaped.
+  ///   Sockets stay in blocking mode, the kernel completes operations asynchronously anyway.
+  ///   The engine is not thread safe: queue and reap from one thread.
+  ///   Requires linux 5.11+ at run time (5.19+ for multishot accept and buffer groups, 6.0+ for multishot recv).
+  ///
+  /// @code
+  ///   uring_engine_t<v4> ring;
+  ///   ring.open ();
+  ///   int group = ring.add_buffer_group (1024, 2048);      // 1024 buffers of 2048 bytes picked by the kernel
+  ///   ring.accept (server, 0, true);                         // multishot: one completion per new connection
+  ///   uring_engine_t<v4>::completion_t done[64];
+  ///   for (;;) {
+  ///     int n = ring.reap (done, 64, 500);
+  ///     for (int i = 0; i < n; i++)
+  ///       if (done[i].op == uring_engine_t<v4>::op_accept && done[i].result >= 0) {
+  ///         clients.push_back (server.adopt (done[i].result));
+  ///         ring.recv_group (clients.back (), group, clients.size (), true);
+  ///       }
+  ///       else if (done[i].op == uring_engine_t<v4>::op_recv) {
+  ///         ... done[i].buf, done[i].result bytes ...
+  ///         ring.release_buffer (done[i]);
+  ///       }
+  ///   }
+  /// @endcode
+  template <ip_type_e Ip_type>
+  struct uring_engine_t {
+
+    using address_t     = addr_t<Ip_type>;
+    using client_t      = udp_socket_t<Ip_type, socket_type_e::client>; ///< Common base of udp and tcp client sockets
+    using sockaddr_in_t = make_sockaddr_in_t<Ip_type>;
+
+    enum op_e : uint8_t {
+      op_recv,     ///< recv() into caller or provided buffer
+      op_recvfrom, ///< recvmsg() with sender address
+      op_send,     ///< send() on connected socket
+      op_sendto,   ///< sendmsg() to destination address
+      op_accept,   ///< accept() on listening TCP socket, result is the new descriptor
+      op_connect   ///< connect() of a client socket created by the engine
+    };
+
+    /// @brief Result of one finished operation (or of one shot of a multishot operation).
+    struct completion_t {
+      uint64_t  tag          = 0;       ///< Tag passed when the operation was queued
+      op_e      op           = op_recv; ///< Kind of the operation
+      int       result       = 0;       ///< Bytes transferred, accepted descriptor (op_accept), no_error (op_connect) or error_e code (< 0)
+      int       os_error     = 0;       ///< Original OS error code (errno) when result < 0, e.g. ECANCELED after cancel()
+      bool      more         = false;   ///< Multishot operation is still armed, more completions with this tag will follow
+      int       buffer_group = -1;      ///< Buffer group of the provided buffer holding the data, -1 if none
+      int       buffer_id    = -1;      ///< Index of the provided buffer in its group, -1 if none
+      char*     buf          = nullptr; ///< Data in the provided buffer, must be given back with release_buffer()
+      address_t address      = {};      ///< Sender (op_recvfrom), peer (single-shot op_accept) or destination (op_connect) address
+    };
+
+    uring_engine_t () = default;
+
+    uring_engine_t (const uring_engine_t&) = delete;
+    uring_engine_t& operator= (const uring_engine_t&) = delete;
+
+    ~uring_engine_t () {
+      close ();
+    }
+
+    ///	@brief Creates the io_uring instance and maps its rings.
+    ///	@param entries - Size of the submission ring (rounded up to a power of two by the kernel). Default: 256.
+    ///	  The completion ring and the number of operations in flight are twice as large.
+    ///	@return Error code:
+    ///	  - no_error on success
+    ///	  - error_already_opened if engine is already opened
+    ///	  - error_not_allowed if the kernel has no io_uring or it is too old (no IORING_FEAT_EXT_ARG)
+    ///	  - error_open_failed if mapping of the rings failed
+    int open (unsigned entries = 256) {
+
+      if (ring_fd != -1) return error_already_opened;
+
+      io_uring_params params = {};
+      params.flags = IORING_SETUP_COOP_TASKRUN; // no IPI to interrupt the thread, completions are processed on next enter
+      ring_fd      = (int)syscall (__NR_io_uring_setup, entries, &params);
+      if (ring_fd == -1 && errno == EINVAL) { // kernel older than 5.19
+        params       = {};
+        ring_fd      = (int)syscall (__NR_io_uring_setup, entries, &params);
+      }
+      if (ring_fd == -1) return error_not_allowed;
+
+      if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        close ();
+        return error_not_allowed;
+      }
+
+      sq_map_len = params.sq_off.array + params.sq_entries * sizeof (uint32_t);
+      cq_map_len = params.cq_off.cqes  + params.cq_entries * sizeof (io_uring_cqe);
+      if (params.features & IORING_FEAT_SINGLE_MMAP)
+        sq_map_len = cq_map_len = std::max (sq_map_len, cq_map_len);
+
+      sqes_len = params.sq_entries * sizeof (io_uring_sqe);
+      sq_map   = _mmap (sq_map_len, IORING_OFF_SQ_RING);
+      cq_map   = (params.features & IORING_FEAT_SINGLE_MMAP) ? sq_map : _mmap (cq_map_len, IORING_OFF_CQ_RING);
+      sqes     = (io_uring_sqe*)_mmap (sqes_len, IORING_OFF_SQES);
+      if (sq_map == nullptr || cq_map == nullptr || sqes == nullptr) {
+        close ();
+        return error_open_failed;
+      }
+
+      sq_head    = (uint32_t*)(sq_map + params.sq_off.head);
+      sq_ktail   = (uint32_t*)(sq_map + params.sq_off.tail);
+      sq_mask    = *(uint32_t*)(sq_map + params.sq_off.ring_mask);
+      sq_entries = params.sq_entries;
+      cq_khead   = (uint32_t*)(cq_map + params.cq_off.head);
+      cq_tail    = (uint32_t*)(cq_map + params.cq_off.tail);
+      cq_mask    = *(uint32_t*)(cq_map + params.cq_off.ring_mask);
+      cqes       = (io_uring_cqe*)(cq_map + params.cq_off.cqes);
+      sq_tail    = *sq_ktail;
+
+      // sqe index == ring slot, so the indirection array is filled once
+      uint32_t* sq_array = (uint32_t*)(sq_map + params.sq_off.array);
+      for (uint32_t i = 0; i < sq_entries; i++)
+        sq_array[i] = i;
+
+      ops.assign (params.cq_entries, op_t ());
+      free_ops.clear ();
+      for (uint32_t i = params.cq_entries; i > 0; i--)
+        free_ops.push_back (i - 1);
+
+      return no_error;
+    }
+
+    ///	@brief Destroys the io_uring instance; operations still in flight are cancelled by the kernel.
+    void close () {
+      for (buffer_group_t& group : groups)
+        munmap (group.ring, group.ring_len);
+      groups.clear ();
+      if (sqes   != nullptr)                     munmap (sqes, sqes_len);
+      if (cq_map != nullptr && cq_map != sq_map) munmap (cq_map, cq_map_len);
+      if (sq_map != nullptr)                     munmap (sq_map, sq_map_len);
+      if (ring_fd != -1)                         ::close (ring_fd);
+      sqes      = nullptr;
+      sq_map    = cq_map = nullptr;
+      ring_fd   = -1;
+      to_submit = 0;
+      ops.clear ();
+      free_ops.clear ();
+    }
+
+    bool   is_open   () const { return ring_fd != -1; }                ///< @brief Returns true after successful open().
+    size_t in_flight () const { return ops.size () - free_ops.size (); } ///< @brief Returns the number of queued operations not yet completed.
+
+    ///	@brief Queues receive into a caller buffer on a connected socket.
+    ///	@return no_error if queued, or error code:
+    ///	  - error_closed_or_not_open if engine or socket is not opened
+    ///	  - error_other if all operation slots are in use (reap completions first)
+    ///	@details Completion result: bytes received, error_tcp_closed on TCP if the peer closed the connection.
+    template <class Socket>
+    int recv (Socket& socket, char* buf, int buf_len, uint64_t tag) {
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_RECV, socket, tag, op_recv, op);
+      if (sqe == nullptr) return _prepare_error (socket);
+      sqe->addr = (uint64_t)(uintptr_t)buf;
+      sqe->len  = (uint32_t)buf_len;
+      return no_error;
+    }
+
+    ///	@brief Queues receive into a buffer picked by the kernel from a buffer group (see add_buffer_group()).
+    ///	@param group     - Buffer group id returned by add_buffer_group().
+    ///	@param multishot - Keep receiving until an error or cancel(), one completion per received chunk (linux 6.0+). Default: false.
+    ///	@return Same as recv() with caller buffer; error_not_allowed if group does not exist.
+    ///	@details Completion has buf/buffer_id set; the buffer must be returned with release_buffer().
+    ///	  When the group runs out of buffers the operation completes with os_error == ENOBUFS.
+    ///	  A separate name, because recv (socket, 0, tag, true) would be ambiguous with the caller buffer overload.
+    template <class Socket>
+    int recv_group (Socket& socket, int group, uint64_t tag, bool multishot = false) {
+      if (group < 0 || group >= (int)groups.size ()) return error_not_allowed;
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_RECV, socket, tag, op_recv, op);
+      if (sqe == nullptr) return _prepare_error (socket);
+      sqe->flags    |= IOSQE_BUFFER_SELECT;
+      sqe->buf_group = (uint16_t)group;
+      if (multishot) sqe->ioprio |= IORING_RECV_MULTISHOT;
+      op->multishot  = multishot;
+      op->group      = group;
+      return no_error;
+    }
+
+    ///	@brief Queues receive of one datagram together with its sender address.
+    ///	@return Same as recv(). Completion has address set to the sender.
+    template <class Socket>
+    int recvfrom (Socket& socket, char* buf, int buf_len, uint64_t tag) {
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_RECVMSG, socket, tag, op_recvfrom, op);
+      if (sqe == nullptr) return _prepare_error (socket);
+      _set_msg (*op, buf, buf_len);
+      sqe->addr = (uint64_t)(uintptr_t)&op->msg;
+      sqe->len  = 1;
+      return no_error;
+    }
+
+    ///	@brief Queues send on a connected socket.
+    ///	@return Same as recv(). Completion result: bytes sent.
+    template <class Socket>
+    int send (Socket& socket, const char* buf, int buf_len, uint64_t tag) {
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_SEND, socket, tag, op_send, op);
+      if (sqe == nullptr) return _prepare_error (socket);
+      sqe->addr = (uint64_t)(uintptr_t)buf;
+      sqe->len  = (uint32_t)buf_len;
+      return no_error;
+    }
+
+    ///	@brief Queues send of one datagram to a destination address.
+    ///	@return Same as recv(). Completion result: bytes sent.
+    template <class Socket>
+    int sendto (Socket& socket, const char* buf, int buf_len, const address_t& address_to, uint64_t tag) {
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_SENDMSG, socket, tag, op_sendto, op);
+      if (sqe == nullptr) return _prepare_error (socket);
+      op->addr = client_t::address2sockaddr (address_to);
+      _set_msg (*op, (char*)buf, buf_len);
+      sqe->addr = (uint64_t)(uintptr_t)&op->msg;
+      sqe->len  = 1;
+      return no_error;
+    }
+
+    ///	@brief Queues accept on a listening TCP server socket.
+    ///	@param multishot - Keep accepting until an error or cancel(), one completion per connection (linux 5.19+). Default: false.
+    ///	@return Same as recv(); error_not_allowed if socket is not a server.
+    ///	@details Completion result is the descriptor of the new connection, wrap it with server.adopt (result).
+    ///	  Single-shot completions also carry the peer address.
+    template <class Server>
+    int accept (Server& server, uint64_t tag, bool multishot = false) {
+      if (server.socket_type != socket_type_e::server) return error_not_allowed;
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_ACCEPT, server, tag, op_accept, op);
+      if (sqe == nullptr) return _prepare_error (server);
+      if (multishot)
+        sqe->ioprio |= IORING_ACCEPT_MULTISHOT; // every shot would overwrite the same address, so it is not requested
+      else {
+        op->addr_len = sizeof (sockaddr_in_t);
+        sqe->addr    = (uint64_t)(uintptr_t)&op->addr;
+        sqe->off     = (uint64_t)(uintptr_t)&op->addr_len;
+      }
+      op->multishot = multishot;
+      return no_error;
+    }
+
+    ///	@brief Creates the OS socket of a closed client socket and queues its connect.
+    ///	@param socket     - udp_socket_t or tcp_socket_t client in created state; must stay alive until the completion.
+    ///	@param address_to - Remote address to connect to.
+    ///	@return no_error if queued, or error code:
+    ///	  - error_already_opened if socket is not in created state
+    ///	  - error_open_failed if the OS socket could not be created
+    ///	  - error_closed_or_not_open if engine is not opened
+    ///	  - error_other if all operation slots are in use
+    ///	@details On successful completion the socket is switched to opened state with local/remote addresses filled,
+    ///	  on failure it is closed again. The completion result is no_error or the error code.
+    template <class Client>
+    int connect (Client& socket, const address_t& address_to, uint64_t tag) {
+
+      client_t& client = socket; // Client must be udp_socket_t<Ip_type, client> or derived from it
+
+      if (ring_fd == -1)                     return error_closed_or_not_open;
+      if (client.state != state_e::created)  return error_already_opened;
+      if (free_ops.empty ())                 return error_other;
+
+      client.sock = ::socket (client.af_inet, client.type, client.protocol);
+      if (client.sock == INVALID_SOCKET)     return error_open_failed;
+      client.state = state_e::prepared;
+
+      op_t*         op  = nullptr;
+      io_uring_sqe* sqe = _prepare (IORING_OP_CONNECT, client, tag, op_connect, op);
+      if (sqe == nullptr) {
+        client.close ();
+        return error_other;
+      }
+      op->client = &client;
+      op->addr   = client_t::address2sockaddr (address_to);
+      sqe->addr  = (uint64_t)(uintptr_t)&op->addr;
+      sqe->off   = sizeof (sockaddr_in_t);
+      return no_error;
+    }
+
+    ///	@brief Requests cancellation of every queued operation with this tag.
+    ///	@return Number of operations asked to cancel (>= 0); each of them completes with os_error == ECANCELED
+    ///	  (unless it finished before), or error_closed_or_not_open if engine is not opened.
+    int cancel (uint64_t tag) {
+      if (ring_fd == -1) return error_closed_or_not_open;
+      int count = 0;
+      for (uint32_t i = 0; i < ops.size (); i++) {
+        if (!ops[i].busy || ops[i].tag != tag) continue;
+        io_uring_sqe* sqe = _get_sqe ();
+        if (sqe == nullptr) break;
+        sqe->opcode    = IORING_OP_ASYNC_CANCEL;
+        sqe->fd        = -1;
+        sqe->addr      = _user_data (i);
+        sqe->user_data = cancel_user_data;
+        count++;
+      }
+      return count;
+    }
+
+    ///	@brief Registers a group of equally sized buffers the kernel picks from for recv_group() (provided buffer ring).
+    ///	@param count - Number of buffers, power of two up to 32768.
+    ///	@param size  - Size of every buffer in bytes.
+    ///	@return Group id (>= 0) to pass to recv_group(), or error code:
+    ///	  - error_closed_or_not_open if engine is not opened
+    ///	  - error_not_allowed if count is not a power of two or the kernel has no buffer rings (linux 5.19+)
+    ///	  - error_open_failed if memory could not be allocated
+    int add_buffer_group (uint16_t count, uint32_t size) {
+
+      if (ring_fd == -1)                              return error_closed_or_not_open;
+      if (count == 0 || (count & (count - 1)) != 0)   return error_not_allowed;
+      if (size == 0 || groups.size () >= 0xFFFF)      return error_not_allowed;
+
+      buffer_group_t group;
+      group.ring_len = (size_t)count * sizeof (io_uring_buf);
+      group.ring     = (io_uring_buf*)_mmap_anon (group.ring_len);
+      if (group.ring == nullptr) return error_open_failed;
+      group.data.resize ((size_t)count * size);
+      group.size = size;
+      group.mask = (uint16_t)(count - 1);
+
+      io_uring_buf_reg reg = {};
+      reg.ring_addr    = (uint64_t)(uintptr_t)group.ring;
+      reg.ring_entries = count;
+      reg.bgid         = (uint16_t)groups.size ();
+      if (syscall (__NR_io_uring_register, ring_fd, IORING_REGISTER_PBUF_RING, &reg, 1) != 0) {
+        munmap (group.ring, group.ring_len);
+        return error_not_allowed;
+      }
+
+      for (uint16_t bid = 0; bid < count; bid++)
+        _push_buffer (group, bid);
+      _publish_buffers (group);
+
+      groups.push_back (std::move (group));
+      return (int)groups.size () - 1;
+    }
+
+    ///	@brief Gives a provided buffer of a completion back to its group so the kernel can fill it again.
+    void release_buffer (const completion_t& completion) {
+      if (completion.buffer_group < 0 || completion.buffer_group >= (int)groups.size ()) return;
+      buffer_group_t& group = groups[completion.buffer_group];
+      _push_buffer (group, (uint16_t)completion.buffer_id);
+      _publish_buffers (group);
+    }
+
+    ///	@brief Hands all queued operations to the kernel without waiting.
+    ///	@return Number of submitted operations (>= 0), or error_e code if io_uring_enter failed.
+    int submit () {
+      if (to_submit == 0) return 0;
+      int res = _enter (0, 0);
+      if (res < 0) return client_t::error_from_os (errno);
+      return res;
+    }
+
+    ///	@brief Submits queued operations and collects finished ones.
+    ///	@param[out] out        - Array for completions.
+    ///	@param      max        - Capacity of out.
+    ///	@param      timeout_ms - Time to wait when nothing has completed yet: 0 = don't wait, -1 = wait forever. Default: -1.
+    ///	@return Number of completions written to out (>= 0; 0 on timeout), or error_e code.
+    ///	@details One io_uring_enter() both submits and waits; completions already in the ring are taken without a syscall.
+    int reap (completion_t* out, int max, int timeout_ms = -1) {
+
+      if (ring_fd == -1) return error_closed_or_not_open;
+      if (max <= 0)      return error_not_allowed;
+
+      int      count = _peek (out, max);
+      unsigned wait  = (count == 0 && timeout_ms != 0) ? 1 : 0;
+
+      if (to_submit > 0 || wait > 0) {
+        int res = _enter (wait, timeout_ms);
+        if (res < 0 && errno != ETIME && errno != EINTR && errno != EBUSY)
+          return client_t::error_from_os (errno);
+      }
+
+      if (count == 0)
+        count = _peek (out, max);
+      return count;
+    }
+
+  protected:
+
+    static const uint64_t cancel_user_data = ~(uint64_t)0; ///< user_data of cancel requests, their completions are not reported
+
+    /// @brief Per-operation state that must live until the completion (addresses and msghdr are read by the kernel asynchronously).
+    struct op_t {
+      uint64_t      tag       = 0;
+      op_e          op        = op_recv;
+      bool          busy      = false;
+      bool          stream    = false;   ///< SOCK_STREAM socket: recv of 0 bytes means the peer closed the connection
+      bool          multishot = false;
+      int           group     = -1;      ///< Buffer group of recv_group()
+      uint32_t      gen       = 0;       ///< Incremented on every reuse, stale user_data never matches a new operation
+      client_t*     client    = nullptr; ///< op_connect: socket to switch to opened state
+      sockaddr_in_t addr      = {};
+      socklen_t     addr_len  = 0;
+      iovec         iov       = {};
+      msghdr        msg       = {};
+    };
+
+    struct buffer_group_t {
+      io_uring_buf*     ring     = nullptr; ///< Ring shared with the kernel, tail overlays resv field of ring[0]
+      size_t            ring_len = 0;
+      std::vector<char> data;               ///< count * size bytes, buffer bid starts at data[bid * size]
+      uint32_t          size     = 0;
+      uint16_t          mask     = 0;
+      uint16_t          tail     = 0;       ///< Local tail, published by _publish_buffers()
+    };
+
+    int           ring_fd    = -1;
+    char*         sq_map     = nullptr;
+    char*         cq_map     = nullptr;
+    size_t        sq_map_len = 0;
+    size_t        cq_map_len = 0;
+    io_uring_sqe* sqes       = nullptr;
+    size_t        sqes_len   = 0;
+    uint32_t*     sq_head    = nullptr;
+    uint32_t*     sq_ktail   = nullptr;
+    uint32_t      sq_tail    = 0;       ///< Local tail, published to sq_ktail before io_uring_enter()
+    uint32_t      sq_mask    = 0;
+    uint32_t      sq_entries = 0;
+    uint32_t      to_submit  = 0;       ///< Number of sqes written since the last successful submit
+    uint32_t*     cq_khead   = nullptr;
+    uint32_t*     cq_tail    = nullptr;
+    uint32_t      cq_mask    = 0;
+    io_uring_cqe* cqes       = nullptr;
+
+    std::vector<op_t>           ops;      ///< One slot per operation in flight, indexed by low half of user_data
+    std::vector<uint32_t>       free_ops; ///< Stack of unused slots in ops
+    std::vector<buffer_group_t> groups;   ///< Provided buffer groups, index == group id
+
+    char* _mmap (size_t len, uint64_t offset) {
+      void* ptr = mmap (nullptr, len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, (off_t)offset);
+      return (ptr == MAP_FAILED) ? nullptr : (char*)ptr;
+    }
+
+    static void* _mmap_anon (size_t len) {
+      void* ptr = mmap (nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      return (ptr == MAP_FAILED) ? nullptr : ptr;
+    }
+
+    uint64_t _user_data (uint32_t index) const {
+      return ((uint64_t)ops[index].gen << 32) | index;
+    }
+
+    int _enter (unsigned min_complete, int timeout_ms) {
+
+      __atomic_store_n (sq_ktail, sq_tail, __ATOMIC_RELEASE);
+
+      unsigned flags = (min_complete > 0) ? IORING_ENTER_GETEVENTS : 0;
+      int      res;
+      if (min_complete > 0 && timeout_ms > 0) {
+        __kernel_timespec      ts  = { timeout_ms / 1000, (long long)(timeout_ms % 1000) * 1000000 };
+        io_uring_getevents_arg arg = {};
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts         = (uint64_t)(uintptr_t)&ts;
+        res = (int)syscall (__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags | IORING_ENTER_EXT_ARG, &arg, sizeof (arg));
+      }
+      else
+        res = (int)syscall (__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, nullptr, _NSIG / 8);
+
+      if (res > 0)
+        to_submit -= std::min ((uint32_t)res, to_submit);
+      return res;
+    }
+
+    /// @brief Returns the next free sqe (zeroed), submitting queued ones first if the ring is full.
+    io_uring_sqe* _get_sqe () {
+      if (sq_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE) >= sq_entries) {
+        _enter (0, 0);
+        if (sq_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE) >= sq_entries)
+          return nullptr;
+      }
+      io_uring_sqe* sqe = &sqes[sq_tail & sq_mask];
+      memset (sqe, 0, sizeof (io_uring_sqe));
+      sq_tail++;
+      to_submit++;
+      return sqe;
+    }
+
+    /// @brief Common part of every operation: checks state, takes an operation slot and an sqe.
+    template <class Socket>
+    io_uring_sqe* _prepare (uint8_t opcode, Socket& socket, uint64_t tag, op_e kind, op_t*& op) {
+
+      if (ring_fd == -1 || free_ops.empty ())                    return nullptr;
+      if (socket.state != state_e::opened && kind != op_connect) return nullptr;
+
+      io_uring_sqe* sqe = _get_sqe ();
+      if (sqe == nullptr) return nullptr;
+
+      uint32_t index = free_ops.back ();
+      free_ops.pop_back ();
+      op            = &ops[index];
+      uint32_t gen  = op->gen + 1;
+      *op           = op_t ();
+      op->gen       = gen;
+      op->busy      = true;
+      op->tag       = tag;
+      op->op        = kind;
+      op->stream    = (socket.type == SOCK_STREAM);
+
+      sqe->opcode    = opcode;
+      sqe->fd        = socket.sock;
+      sqe->user_data = _user_data (index);
+      return sqe;
+    }
+
+    /// @brief Explains why _prepare() returned nullptr.
+    template <class Socket>
+    int _prepare_error (const Socket& socket) const {
+      if (ring_fd == -1 || socket.state != state_e::opened) return error_closed_or_not_open;
+      return error_other;
+    }
+
+    static void _set_msg (op_t& op, char* buf, int buf_len) {
+      op.iov.iov_base    = buf;
+      op.iov.iov_len     = (size_t)buf_len;
+      op.msg.msg_name    = &op.addr;
+      op.msg.msg_namelen = sizeof (sockaddr_in_t);
+      op.msg.msg_iov     = &op.iov;
+      op.msg.msg_iovlen  = 1;
+    }
+
+    static void _push_buffer (buffer_group_t& group, uint16_t bid) {
+      io_uring_buf& buf = group.ring[group.tail & group.mask];
+      buf.addr = (uint64_t)(uintptr_t)&group.data[(size_t)bid * group.size];
+      buf.len  = group.size;
+      buf.bid  = bid;
+      group.tail++;
+    }
+
+    static void _publish_buffers (buffer_group_t& group) {
+      __atomic_store_n (&group.ring[0].resv, group.tail, __ATOMIC_RELEASE); // resv of the first entry is the ring tail
+    }
+
+    /// @brief Moves up to max completions from the completion ring to out.
+    int _peek (completion_t* out, int max) {
+
+      uint32_t head  = *cq_khead;
+      uint32_t tail  = __atomic_load_n (cq_tail, __ATOMIC_ACQUIRE);
+      int      count = 0;
+
+      for (; head != tail && count < max; head++)
+        if (_complete (cqes[head & cq_mask], out[count]))
+          count++;
+
+      __atomic_store_n (cq_khead, head, __ATOMIC_RELEASE);
+      return count;
+    }
+
+    /// @brief Converts one cqe into completion_t and frees its operation slot unless more shots follow.
+    bool _complete (const io_uring_cqe& cqe, completion_t& done) {
+
+      if (cqe.user_data == cancel_user_data) return false;
+
+      uint32_t index = (uint32_t)cqe.user_data;
+      if (index >= ops.size () || !ops[index].busy || ops[index].gen != (uint32_t)(cqe.user_data >> 32))
+        return false;
+
+      op_t& op  = ops[index];
+      done      = completion_t ();
+      done.tag  = op.tag;
+      done.op   = op.op;
+      done.more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+      if (cqe.flags & IORING_CQE_F_BUFFER) {
+        done.buffer_group = op.group;
+        done.buffer_id    = (int)(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        done.buf          = &groups[done.buffer_group].data[(size_t)done.buffer_id * groups[done.buffer_group].size];
+      }
+
+      if (cqe.res < 0) {
+        done.os_error = -cqe.res;
+        done.result   = client_t::error_from_os (-cqe.res);
+      }
+      else if (cqe.res == 0 && op.op == op_recv && op.stream)
+        done.result = error_tcp_closed;
+      else
+        done.result = cqe.res;
+
+      if (cqe.res >= 0 && (op.op == op_recvfrom || (op.op == op_accept && !op.multishot)))
+        done.address = client_t::sockaddr2address (op.addr);
+
+      if (op.op == op_connect) {
+        done.address = client_t::sockaddr2address (op.addr);
+        if (cqe.res == 0 && op.client->state == state_e::prepared) {
+          sockaddr_in_t local     = {};
+          socklen_t     local_len = sizeof (sockaddr_in_t);
+          getsockname (op.client->sock, (sockaddr*)&local, &local_len);
+          op.client->state          = state_e::opened;
+          op.client->address_local  = client_t::sockaddr2address (local);
+          op.client->address_remote = done.address;
+        }
+        else
+          op.client->close ();
+      }
+
+      if (!done.more) {
+        op.busy = false;
+        free_ops.push_back (index);
+      }
+      return true;
+    }
+
+  };
+
+} // namespace ipsockets
+
+#endif // IP_SOCKETS_HAS_IO_URING